@@ -64,6 +64,19 @@ public:
 	virtual void unregisterPort( AudioPort * _port );
 	virtual void renamePort( AudioPort * _port );
 
+	// called by the audio engine's worker threads with the processed
+	// output of each registered port - returns true if the driver
+	// outputs the port directly, so it must not be mixed into the master
+	virtual bool writePort( AudioPort * _port, const sampleFrame * _buf,
+							const fpp_t _frames );
+
+	// whether the audio engine has to render ahead into a fifo instead of
+	// rendering in the callback of the audio-driver
+	virtual bool needsFifo() const
+	{
+		return true;
+	}
+
 
 	inline bool supportsCapture() const
 	{
@@ -34,6 +34,9 @@
 #include <QThread>
 #include <samplerate.h>
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <vector>
 
 #include "lmms_basics.h"
@@ -193,6 +196,16 @@ public:
 	void clear();
 	void clearNewPlayHandles();
 
+	//! Process all jobs in a fixed order on the rendering thread and reset
+	//! the random generators and the global period counters, so that
+	//! rendering the same project twice gives the same output
+	void setDeterministic( bool deterministic );
+
+	bool isDeterministic() const
+	{
+		return m_deterministic;
+	}
+
 
 	// audio-device-stuff
 
@@ -223,13 +236,7 @@ public:
 
 
 	// audio-port-stuff
-	inline void addAudioPort(AudioPort * port)
-	{
-		requestChangeInModel();
-		m_audioPorts.push_back(port);
-		doneChangeInModel();
-	}
-
+	void addAudioPort(AudioPort * port);
 	void removeAudioPort(AudioPort * port);
 
 
@@ -355,7 +362,9 @@ public:
 	inline bool isMetronomeActive() const { return m_metronomeActive; }
 	inline void setMetronomeActive(bool value = true) { m_metronomeActive = value; }
 
-	//! Block until a change in model can be done (i.e. wait for audio thread)
+	//! Block until a change in model can be done (i.e. wait for audio thread).
+	//! The audio thread waits for the change in turn, so only hold it for
+	//! swapping in what has been prepared before, or use postModelChange().
 	void requestChangeInModel();
 	void doneChangeInModel();
 
@@ -364,6 +373,29 @@ public:
 		return RequestChangesGuard{this};
 	}
 
+	//! Schedule a change in model without blocking: the change is applied by
+	//! the audio thread at the beginning of the next period (or right away
+	//! if the caller is already synchronized with the audio thread). Changes
+	//! are applied in the order in which they have been posted and must
+	//! neither block nor allocate memory.
+	void postModelChange(std::function<void()> change);
+
+	//! Block the calling thread (but never the audio thread) until all render
+	//! periods which were running when calling this have been finished, i.e.
+	//! until data unpublished before can't be accessed by the audio thread anymore
+	void synchronizeWithRender();
+
+	//! Let the reclaimer thread destroy an object as soon as the audio thread
+	//! can't access it anymore. Doesn't block or allocate, so it is safe to be
+	//! called from the audio thread.
+	template<class T>
+	void reclaimLater(T* object)
+	{
+		reclaimLater(object, [](void* p) { delete static_cast<T*>(p); });
+	}
+
+	void reclaimLater(void* object, void (*deleter)(void*));
+
 	static bool isAudioDevNameValid(QString name);
 	static bool isMidiDevNameValid(QString name);
 
@@ -395,6 +427,31 @@ private:
 		void write( surroundSampleFrame * buffer );
 	} ;
 
+	//! Low priority thread destroying objects handed over by reclaimLater()
+	class Reclaimer : public QThread
+	{
+	public:
+		Reclaimer(AudioEngine* audioEngine);
+
+		void finish();
+
+	private:
+		AudioEngine* m_audioEngine;
+		std::atomic<bool> m_running;
+
+		void run() override;
+	};
+
+	struct RetiredObject
+	{
+		void* object;
+		void (*deleter)(void*);
+		std::uint64_t period; //!< last render period which might access the object
+	};
+
+	using AudioPortList = std::vector<AudioPort*>;
+	using ModelChange = std::function<void()>;
+
 
 	AudioEngine( bool renderOnly );
 	~AudioEngine() override;
@@ -419,9 +476,26 @@ private:
 
 	void clearInternal();
 
+	//! Append a new play handle to the list of running ones
+	void appendPlayHandle(PlayHandle* handle);
+	//! Take a play handle out of the list of running ones
+	void takePlayHandle(PlayHandle* handle);
+	//! Let the audio thread remove a play handle at the next period
+	void queuePlayHandleRemoval(PlayHandle* handle);
+	//! Release or destroy a play handle which has been taken out of the list
+	void retirePlayHandle(PlayHandle* handle);
+
+	void applyModelChanges();
+	//! Destroy retired objects which can't be accessed by the audio thread anymore
+	void reclaim(bool all = false);
+
 	bool m_renderOnly;
+	std::atomic<bool> m_deterministic;
 
-	std::vector<AudioPort *> m_audioPorts;
+	// published by the GUI thread and read by the audio thread - writers
+	// have to lock m_audioPortsWriteMutex and copy the list
+	std::atomic<AudioPortList*> m_audioPorts;
+	std::mutex m_audioPortsWriteMutex;
 
 	fpp_t m_framesPerPeriod;
 
@@ -442,7 +516,8 @@ private:
 	PlayHandleList m_playHandles;
 	// place where new playhandles are added temporarily
 	LocklessList<PlayHandle *> m_newPlayHandles;
-	ConstPlayHandleList m_playHandlesToRemove;
+	// every entry is still alive, retirePlayHandle() clears stale ones
+	PlayHandleList m_playHandlesToRemove;
 
 
 	struct qualitySettings m_qualitySettings;
@@ -471,6 +546,13 @@ private:
 
 	std::mutex m_changeMutex;
 
+	// lock-free model changes and deferred destruction
+	LocklessList<ModelChange*> m_modelChanges;
+	LocklessList<RetiredObject> m_retiredObjects;
+	std::atomic<std::uint64_t> m_periodsStarted;
+	std::atomic<std::uint64_t> m_periodsFinished;
+	Reclaimer* m_reclaimer;
+
 	friend class Engine;
 	friend class AudioEngineWorkerThread;
 	friend class ProjectRenderer;
@@ -108,6 +108,13 @@ public:
 
 	static void startAndWaitForJobs();
 
+	//! Process all jobs on the calling thread in the order they were added,
+	//! instead of distributing them to the worker threads
+	static void setProcessInline( bool processInline )
+	{
+		s_processInline = processInline;
+	}
+
 
 private:
 	void run() override;
@@ -115,6 +122,7 @@ private:
 	static JobQueue globalJobQueue;
 	static QWaitCondition * queueReadyWaitCond;
 	static QList<AudioEngineWorkerThread *> workerThreads;
+	static std::atomic<bool> s_processInline;
 
 	volatile bool m_quit;
 } ;
@@ -26,14 +26,30 @@
 #ifndef LMMS_AUDIO_FILE_DEVICE_H
 #define LMMS_AUDIO_FILE_DEVICE_H
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <QCryptographicHash>
 #include <QFile>
+#include <QStringList>
 
 #include "AudioDevice.h"
+#include "LocklessRingBuffer.h"
 #include "OutputSettings.h"
 
 namespace lmms
 {
 
+/*! Base of the devices which export into a file.
+
+	The render thread only copies each period into a lock-free queue, the
+	actual encoding and writing happens on an encoder thread of the device
+	in batches of up to EncoderBatchFrames frames. Further devices added by
+	addOutput() are fed the same audio, so one render can produce several
+	files, each encoded on its own thread.
+*/
 class AudioFileDevice : public AudioDevice
 {
 public:
@@ -49,6 +65,28 @@ public:
 
 	OutputSettings const & getOutputSettings() const { return m_outputSettings; }
 
+	//! Let @p output encode the same audio as this device. Returns false if
+	//! it can't, because it needs a different sample rate.
+	bool addOutput(std::unique_ptr<AudioFileDevice> output);
+
+	//! The files of this device and all outputs added to it
+	QStringList outputFiles() const;
+
+	//! Hash the audio on the encoder thread, see audioHash(). Has to be
+	//! enabled before the rendering starts.
+	void setAudioHashing(bool enabled) { m_audioHashing = enabled; }
+
+	//! SHA-256 of the audio encoded so far, taken before encoding so that it
+	//! doesn't depend on the file format or its metadata. Complete only after
+	//! finishEncoding().
+	QByteArray audioHash() const { return m_audioHash.result().toHex(); }
+
+	//! Wait until everything rendered is encoded by this device and all of
+	//! its outputs. Nothing written afterwards is encoded anymore.
+	void finishEncoding();
+
+	static constexpr fpp_t EncoderBatchFrames = 8192;
+
 
 protected:
 	int writeData( const void* data, int len );
@@ -63,9 +101,40 @@ protected:
 		return m_outputFile.handle();
 	}
 
+	//! Encode @p frames frames and write them to the file. Called on the
+	//! encoder thread, the master gain is already applied.
+	virtual void encodeBuffer(const surroundSampleFrame* buf, const fpp_t frames) = 0;
+
+	//! Wait until everything queued is encoded and stop the encoder thread.
+	//! Subclasses must call this in their destructor before finishing the
+	//! encoding, as the thread still calls encodeBuffer() until then.
+	void finishEncoderThread();
+
 private:
+	class EncoderThread;
+
+	void writeBuffer(const surroundSampleFrame* buf, const fpp_t frames, const float masterGain) final;
+	void queueFrames(const surroundSampleFrame* frames, std::size_t count);
+	void runEncoder();
+
 	QFile m_outputFile;
 	OutputSettings m_outputSettings;
+
+	LocklessRingBuffer<surroundSampleFrame> m_queue;
+	//! Created with the queue, so that it sees every frame queued before
+	//! the encoder thread starts
+	LocklessRingBufferReader<surroundSampleFrame> m_queueReader;
+	//! Signalled by the encoder thread whenever it has read from the queue
+	std::condition_variable m_queueSpace;
+	std::mutex m_queueSpaceMutex;
+	std::unique_ptr<EncoderThread> m_encoderThread;
+	std::atomic<bool> m_finishing;
+
+	std::vector<surroundSampleFrame> m_gainBuffer;
+	std::atomic<bool> m_audioHashing;
+	//! Only used by the encoder thread
+	QCryptographicHash m_audioHash;
+	std::vector<std::unique_ptr<AudioFileDevice>> m_outputs;
 } ;
 
 using AudioFileDeviceInstantiaton
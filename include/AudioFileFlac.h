@@ -65,9 +65,8 @@ private:
 	SF_INFO  m_sfinfo;
 	SNDFILE* m_sf;
 
-	void writeBuffer(surroundSampleFrame const* _ab,
-						fpp_t const frames,
-						float master_gain) override;
+	void encodeBuffer(surroundSampleFrame const* _ab,
+						fpp_t const frames) override;
 
 	bool startEncoding();
 	void finishEncoding();
@@ -58,9 +58,8 @@ public:
 	}
 
 protected:
-	void writeBuffer( const surroundSampleFrame * /* _buf*/,
-				  const fpp_t /*_frames*/,
-				  const float /*_master_gain*/ ) override;
+	void encodeBuffer( const surroundSampleFrame * /* _buf*/,
+				  const fpp_t /*_frames*/ ) override;
 
 private:
 	void flushRemainingBuffers();
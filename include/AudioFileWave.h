@@ -56,9 +56,8 @@ public:
 
 
 private:
-	void writeBuffer( const surroundSampleFrame * _ab,
-						const fpp_t _frames,
-						float _master_gain ) override;
+	void encodeBuffer( const surroundSampleFrame * _ab,
+						const fpp_t _frames ) override;
 
 	bool startEncoding();
 	void finishEncoding();
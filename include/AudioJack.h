@@ -34,12 +34,16 @@
 #include "weak_libjack.h"
 #endif
 
+#include <QMap>
 #include <atomic>
+#include <cstdint>
+#include <mutex>
 #include <vector>
 
 #include "AudioDevice.h"
 #include "AudioDeviceSetupWidget.h"
 
+class QCheckBox;
 class QLineEdit;
 
 namespace lmms
@@ -83,10 +87,14 @@ public:
 	private:
 		QLineEdit* m_clientName;
 		gui::LcdSpinBox* m_channels;
+		QCheckBox* m_trackOutputs;
+		QCheckBox* m_directOut;
 	};
 
 private slots:
 	void restartAfterZombified();
+	//! Retry reclaiming retired ports until the process callback let them go
+	void reclaimRetiredPorts();
 
 private:
 	bool initJackClient();
@@ -98,6 +106,13 @@ private:
 	void registerPort(AudioPort* port) override;
 	void unregisterPort(AudioPort* port) override;
 	void renamePort(AudioPort* port) override;
+	bool writePort(AudioPort* port, const sampleFrame* buf, const fpp_t frames) override;
+
+	//! Track outputs need the ports rendered within the process callback
+	bool needsFifo() const override { return !m_trackOutputs; }
+
+	//! Point the ports at where the next period goes and clear it
+	void preparePortPeriod(jack_nframes_t offset, jack_nframes_t nframes);
 
 	int processCallback(jack_nframes_t nframes);
 
@@ -117,15 +132,55 @@ private:
 	f_cnt_t m_framesDoneInCurBuf;
 	f_cnt_t m_framesToDoInCurBuf;
 
-#ifdef AUDIO_PORT_SUPPORT
 	struct StereoPort
 	{
 		jack_port_t* ports[2];
+		//! JACK buffers of the current cycle
+		jack_default_audio_sample_t* buffers[2];
+		//! Where the period being rendered goes - either right into the
+		//! JACK buffers or into the staging buffers, if it doesn't fit
+		jack_default_audio_sample_t* target[2];
+		std::vector<jack_default_audio_sample_t> staging[2];
+		//! Base name of the JACK ports, unique among the ports of the client
+		QString name;
 	};
 
-	using JackPortMap = QMap<AudioPort*, StereoPort>;
-	JackPortMap m_portMap;
-#endif
+	//! Maps are never changed once published, the process callback uses the
+	//! one it finds at the beginning of a cycle without any locking
+	using JackPortMap = QMap<AudioPort*, StereoPort*>;
+	std::atomic<const JackPortMap*> m_portMap;
+	//! The map of the running cycle, also used by writePort() while rendering
+	const JackPortMap* m_cyclePortMap;
+	//! Counts the starts and ends of process cycles, so it's odd within one
+	std::atomic<std::uint64_t> m_cycle;
+
+	//! A replaced map and the port removed with it, which the process
+	//! callback might still be using
+	struct RetiredPorts
+	{
+		const JackPortMap* map;
+		StereoPort* port;
+		std::uint64_t cycle; //!< from this cycle on, they aren't in use anymore
+	};
+	std::vector<RetiredPorts> m_retiredPorts;
+	//! Serializes the changes of the ports, never taken by the process callback
+	std::mutex m_portMapMutex;
+
+	//! Publish @p map and retire the current one, along with @p removedPort
+	void publishPortMap(const JackPortMap* map, StereoPort* removedPort);
+	//! Unregister and destroy retired ports the process callback is done with
+	void reclaimPorts(bool all = false);
+	//! The name of @p port, numbered if another port is named like it already
+	QString uniquePortName(const AudioPort* port) const;
+
+	//! Output every track at a port of its own
+	const bool m_trackOutputs;
+	//! Don't mix the tracks with outputs of their own into the master
+	const bool m_directOut;
+	//! Whether the ports can be written by the period being rendered
+	bool m_portsWritable;
+	//! Whether the current period was rendered right into the JACK buffers
+	bool m_portsDirect;
 
 signals:
 	void zombified();
@@ -111,8 +111,30 @@ public:
 	void addPlayHandle( PlayHandle * handle );
 	void removePlayHandle( PlayHandle * handle );
 
+	//! Seed the generator fast_rand() uses for this port while rendering
+	//! deterministically, see AudioEngine::setDeterministic()
+	void seedRand( unsigned long seed )
+	{
+		m_randState = seed;
+	}
+
+	//! While alive, fast_rand() draws from the generator of @p port on the
+	//! calling thread if rendering deterministically, so the noise of one
+	//! track doesn't depend on what the other tracks play
+	class RandScope
+	{
+	public:
+		explicit RandScope( AudioPort* port );
+		~RandScope();
+
+	private:
+		AudioPort* m_port;
+	} ;
+
 private:
 	volatile bool m_bufferUsage;
+	// whether m_portBuffer is known to contain silence only
+	bool m_bufferSilent;
 
 	sampleFrame * m_portBuffer;
 	QMutex m_portBufferLock;
@@ -131,6 +153,8 @@ private:
 	FloatModel * m_panningModel;
 	BoolModel * m_mutedModel;
 
+	unsigned long m_randState;
+
 	friend class AudioEngine;
 	friend class AudioEngineWorkerThread;
 
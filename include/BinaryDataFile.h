@@ -0,0 +1,62 @@
+/*
+ * BinaryDataFile.h - binary container for LMMS project files
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_BINARY_DATA_FILE_H
+#define LMMS_BINARY_DATA_FILE_H
+
+#include "lmms_export.h"
+
+class QByteArray;
+class QDomDocument;
+class QIODevice;
+class QString;
+
+/*! The binary container is a lossless alternative to the XML of the project
+	files (.mmpb). It holds the same document tree, but as a sequence of
+	independently compressed chunks:
+
+	- a header with the magic "LMMSPRJB" and the format version
+	- string chunks, extending a table of element and attribute names and
+	  short attribute values, so that every string is only stored once
+	- blob chunks holding the raw bytes of big base64 encoded attributes
+	  (e.g. embedded samples), which are encoded again when reading
+	- node chunks, holding the tree in document order, referring to the
+	  strings and blobs of the chunks before
+
+	Chunks are read one after another, so neither the whole file nor the
+	whole uncompressed tree have to be kept in memory apart from the DOM.
+*/
+namespace lmms::BinaryDataFile
+{
+	//! Whether the data starts like a binary project file
+	bool LMMS_EXPORT isBinary(const QByteArray& data);
+
+	//! Write the document to the device
+	bool LMMS_EXPORT write(const QDomDocument& doc, QIODevice& out);
+
+	//! Read a document from the device, returns false and sets
+	//! errorMsg if the data is no valid binary project file
+	bool LMMS_EXPORT read(QIODevice& in, QDomDocument& doc, QString& errorMsg);
+
+} // namespace lmms::BinaryDataFile
+
+#endif // LMMS_BINARY_DATA_FILE_H
@@ -26,12 +26,15 @@
 #ifndef LMMS_DATA_FILE_H
 #define LMMS_DATA_FILE_H
 
+#include <functional>
 #include <map>
 #include <QDomDocument>
+#include <QStringList>
 
 #include "lmms_export.h"
 #include "MemoryManager.h"
 
+class QIODevice;
 class QTextStream;
 
 namespace lmms
@@ -60,6 +63,16 @@ public:
 		MidiClip
 	} ;
 
+	//! Why writeFileSilently() failed, in words for the user
+	struct WriteError
+	{
+		QString title;
+		QString message;
+	};
+
+	//! Receives the progress of writeFileSilently() in percent
+	using ProgressCallback = std::function<void(int)>;
+
 	DataFile( const QString& fileName );
 	DataFile( const QByteArray& data );
 	DataFile( Type type );
@@ -75,9 +88,23 @@ public:
 	QString nameWithExtension( const QString& fn ) const;
 
 	void write( QTextStream& strm );
+	bool writeBinary( QIODevice& out );
 	bool writeFile(const QString& fn, bool withResources = false);
+	//! The file writeFile() writes @p fn to: with the extension the
+	//! configuration asks for, and within the bundle folder if @p withResources
+	QString fileNameToWrite(const QString& fn, bool withResources) const;
+	//! Creates the bundle folder of @p fullName (see fileNameToWrite()) and
+	//! copies the resources into it, which reads the configuration
+	bool createBundle(const QString& fullName, WriteError& error);
+	//! Writes to @p fullName, which is resolved by fileNameToWrite() and
+	//! createBundle() already. Touches neither the GUI nor the configuration,
+	//! so that it can run on a worker thread
+	bool writeFileSilently(const QString& fullName, bool keepBackup,
+		WriteError& error, const ProgressCallback& progress = {});
+	static void showWriteError(const WriteError& error); //!< Shows the error in a message box or the log
 	bool copyResources(const QString& resourcesDir); //!< Copies resources to the resourcesDir and changes the DataFile to use local paths to them
 	bool hasLocalPlugins(QDomElement parent = QDomElement(), bool firstCall = true) const;
+	QStringList resourceFiles() const; //!< Returns every reference to a file in ELEMENTS_WITH_RESOURCES
 
 	QDomElement& content()
 	{
@@ -143,6 +170,9 @@ private:
 	void upgrade();
 
 	void loadData( const QByteArray & _data, const QString & _sourceFile );
+	void loadBinaryData( QIODevice & _in, const QString & _sourceFile );
+	//! Upgrades the freshly loaded document and sets up head and content
+	void setupLoadedData( const QString & _sourceFile );
 
 	QString m_fileName; //!< The origin file name or "" if this DataFile didn't originate from a file
 	QDomElement m_content;
@@ -63,6 +63,8 @@ public:
 	void moveDown( Effect * _effect );
 	void moveUp( Effect * _effect );
 	bool processAudioBuffer( sampleFrame * _buf, const fpp_t _frames, bool hasInputNoise );
+	// returns whether any effect still has to process, e.g. for a reverb or delay tail
+	bool isRunning() const;
 	void startRunning();
 
 	void clear();
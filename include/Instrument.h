@@ -26,6 +26,8 @@
 #ifndef LMMS_INSTRUMENT_H
 #define LMMS_INSTRUMENT_H
 
+#include <vector>
+
 #include <QString>
 
 #include "Flags.h"
@@ -55,6 +57,7 @@ public:
 		IsSingleStreamed = 0x01,	/*! Instrument provides a single audio stream for all notes */
 		IsMidiBased = 0x02,			/*! Instrument is controlled by MIDI events rather than NotePlayHandles */
 		IsNotBendable = 0x04,		/*! Instrument can't react to pitch bend changes */
+		IsVoiceBatched = 0x08,		/*! Instrument renders all its notes at once in playNotes() */
 	};
 
 	using Flags = lmms::Flags<Flag>;
@@ -62,7 +65,7 @@ public:
 	Instrument(InstrumentTrack * _instrument_track,
 			const Descriptor * _descriptor,
 			const Descriptor::SubPluginFeatures::Key * key = nullptr);
-	~Instrument() override = default;
+	~Instrument() override;
 
 	// --------------------------------------------------------------------
 	// functions that can/should be re-implemented:
@@ -81,6 +84,16 @@ public:
 	{
 	}
 
+	// instruments with the IsVoiceBatched flag get all notes which have to be
+	// rendered in the current period passed at once and mix them into the
+	// single working buffer of their instrument-play-handle. The default
+	// implementation renders the notes one after another using playNote(),
+	// so re-implement it for processing voices in parallel. Note that the
+	// instrument has to create an InstrumentPlayHandle, just like instruments
+	// with the IsSingleStreamed flag.
+	virtual void playNotes( const std::vector<NotePlayHandle*> & _notes,
+					sampleFrame * _working_buffer );
+
 	// needed for deleting plugin-specific-data of a note - plugin has to
 	// cast void-ptr so that the plugin-data is deleted properly
 	// (call of dtor if it's a class etc.)
@@ -148,6 +161,9 @@ protected:
 private:
 	InstrumentTrack * m_instrumentTrack;
 
+	// scratch buffer for the default implementation of playNotes()
+	sampleFrame * m_voiceBuffer;
+
 } ;
 
 
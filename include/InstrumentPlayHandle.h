@@ -25,6 +25,8 @@
 #ifndef LMMS_INSTRUMENT_PLAY_HANDLE_H
 #define LMMS_INSTRUMENT_PLAY_HANDLE_H
 
+#include <vector>
+
 #include "PlayHandle.h"
 #include "lmms_export.h"
 
@@ -33,6 +35,7 @@ namespace lmms
 
 class Instrument;
 class InstrumentTrack;
+class NotePlayHandle;
 
 class LMMS_EXPORT InstrumentPlayHandle : public PlayHandle
 {
@@ -41,6 +44,12 @@ public:
 
 	~InstrumentPlayHandle() override = default;
 
+	//! Only frees the voice list; the instrument outlives its handle
+	bool isReclaimable() const override
+	{
+		return true;
+	}
+
 	void play(sampleFrame * working_buffer) override;
 
 	bool isFinished() const override
@@ -51,7 +60,14 @@ public:
 	bool isFromTrack(const Track* track) const override;
 
 private:
+	//! Render all notes of an instrument with the IsVoiceBatched flag in one go
+	void playBatched(sampleFrame* working_buffer);
+
+	//! Voices which can be batched without allocating on the audio thread
+	static constexpr std::size_t PreallocatedVoices = 256;
+
 	Instrument* m_instrument;
+	std::vector<NotePlayHandle*> m_voices;
 };
 
 } // namespace lmms
@@ -26,6 +26,8 @@
 #ifndef LMMS_INSTRUMENT_TRACK_H
 #define LMMS_INSTRUMENT_TRACK_H
 
+#include <atomic>
+
 #include "AudioPort.h"
 #include "InstrumentFunctions.h"
 #include "InstrumentSoundShaping.h"
@@ -82,6 +84,13 @@ public:
 		return m_sustainPedalPressed;
 	}
 
+	// whether the single stream of the instrument has been silent in the
+	// last period (only detected for single-streamed instruments)
+	bool isSilent() const
+	{
+		return m_silentBuffersProcessed;
+	}
+
 	f_cnt_t beatLen( NotePlayHandle * _n ) const;
 
 
@@ -181,6 +190,13 @@ public:
 	int baseNote() const;
 	float baseFreq() const;
 
+	//! Changes whenever the base note or the pitch changed, so that playing
+	//! notes know to update their frequency
+	int baseNoteVersion() const
+	{
+		return m_baseNoteVersion.load(std::memory_order_acquire);
+	}
+
 	Piano *pianoModel()
 	{
 		return &m_piano;
@@ -289,6 +305,7 @@ private:
 	static InstrumentTrack *s_autoAssignedTrack;
 
 	NotePlayHandleList m_processHandles;
+	std::atomic<int> m_baseNoteVersion;
 
 	FloatModel m_volumeModel;
 	FloatModel m_panningModel;
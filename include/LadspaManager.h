@@ -74,11 +74,16 @@ enum class LadspaPluginType
 
 struct LadspaManagerDescription
 {
+	//! nullptr until the library has been loaded, plugins found in the
+	//! startup cache are only loaded when their descriptor is needed
 	LADSPA_Descriptor_Function descriptorFunction;
+	QString library;
 	uint32_t index;
 	LadspaPluginType type;
 	uint16_t inputChannels;
 	uint16_t outputChannels;
+	QString name;
+	LADSPA_Properties properties;
 };
 
 class LMMS_EXPORT LadspaManager
@@ -330,8 +335,17 @@ public:
 						LADSPA_Handle _instance );
 
 private:
-	void  addPlugins( LADSPA_Descriptor_Function _descriptor_func,
-						const QString & _file );
+	//! Adds all plugins of a library and returns their startup cache entry
+	QByteArray  addPlugins( LADSPA_Descriptor_Function _descriptor_func,
+				const QString & _file, const QString & _library,
+				const QByteArray & _stamp );
+	//! Adds the plugins of a library from its startup cache entry, returns
+	//! false if the entry doesn't belong to this version of the library
+	bool  addCachedPlugins( const QString & _file, const QString & _library,
+				const QByteArray & _stamp, const QByteArray & _entry );
+	void  addDescription( const ladspa_key_t & _key,
+				LadspaManagerDescription * _description );
+	bool  loadLibrary( LadspaManagerDescription * _description );
 	uint16_t  getPluginInputs( const LADSPA_Descriptor * _descriptor );
 	uint16_t  getPluginOutputs( const LADSPA_Descriptor * _descriptor );
 
@@ -36,10 +36,15 @@ namespace lmms
 class LocklessAllocator
 {
 public:
-	LocklessAllocator( size_t nmemb, size_t size );
+	LocklessAllocator( size_t nmemb, size_t size,
+				size_t alignment = sizeof( void * ) );
 	virtual ~LocklessAllocator();
 	void * alloc();
+	//! Like alloc(), but doesn't complain if there is no free space
+	void * tryAlloc();
 	void free( void * ptr );
+	//! Returns whether @p ptr points into this allocator's pool
+	bool owns( const void * ptr ) const;
 
 
 private:
@@ -63,7 +68,7 @@ class LocklessAllocatorT : private LocklessAllocator
 {
 public:
 	LocklessAllocatorT( size_t nmemb ) :
-		LocklessAllocator( nmemb, sizeof( T ) )
+		LocklessAllocator( nmemb, sizeof( T ), alignof( T ) )
 	{
 	}
 
@@ -74,11 +79,21 @@ public:
 		return (T *)LocklessAllocator::alloc();
 	}
 
+	T * tryAlloc()
+	{
+		return (T *)LocklessAllocator::tryAlloc();
+	}
+
 	void free( T * ptr )
 	{
 		LocklessAllocator::free( ptr );
 	}
 
+	bool owns( const T * ptr ) const
+	{
+		return LocklessAllocator::owns( ptr );
+	}
+
 } ;
 
 
@@ -53,6 +53,10 @@ class MixerChannel : public ThreadableJob
 		bool m_hasInput;
 		// set to true if any effect in the channel is enabled and running
 		bool m_stillRunning;
+		// set to false as soon as anything has been written into the buffer
+		// during the current period - silent channels are neither mixed into
+		// their receivers nor cleared
+		bool m_silent;
 
 		float m_peakLeft;
 		float m_peakRight;
@@ -114,12 +114,33 @@ public:
 	/*! Renders one chunk using the attached instrument into the buffer */
 	void play( sampleFrame* buffer ) override;
 
+	/*! Prepares the note for the current period (note-on, release detection) and
+	    locks it. Returns false if nothing is to be rendered in this period, otherwise
+	    the caller must call finishPeriod() after the note has been rendered */
+	bool startPeriod();
+
+	/*! Advances release and frame counters by the frames of the current period and unlocks the note */
+	void finishPeriod();
+
 	/*! Returns whether playback of note is finished and thus handle can be deleted */
 	bool isFinished() const override
 	{
 		return m_released && framesLeft() <= 0;
 	}
 
+	/*! Voices of batched instruments are rendered by the InstrumentPlayHandle
+	    of their instrument and thus are never queued as jobs on their own */
+	bool requiresProcessing() const override
+	{
+		return !m_renderedInBatch && !isFinished();
+	}
+
+	/*! Returns whether this note is rendered together with the other notes of its instrument */
+	bool isRenderedInBatch() const
+	{
+		return m_renderedInBatch;
+	}
+
 	/*! Returns number of frames left for playback */
 	f_cnt_t framesLeft() const;
 
@@ -195,6 +216,14 @@ public:
 		return m_hasParent;
 	}
 
+	/*! Returns how many parents the note has, e.g. 2 for an arpeggio note of a chord */
+	int depth() const
+	{
+		int depth = 0;
+		for (const NotePlayHandle* parent = m_parent; parent != nullptr; parent = parent->m_parent) { ++depth; }
+		return depth;
+	}
+
 	/*! Returns origin of note */
 	Origin origin() const
 	{
@@ -333,6 +362,11 @@ private:
 	Origin m_origin;
 
 	bool m_frequencyNeedsUpdate;				// used to update pitch
+	int m_baseNoteVersion;					// InstrumentTrack::baseNoteVersion() of the frequency
+
+	f_cnt_t m_framesThisPeriod;				// frames to be played between
+											// startPeriod() and finishPeriod()
+	bool m_renderedInBatch;					// rendered via Instrument::playNotes()
 } ;
 
 
@@ -0,0 +1,95 @@
+/*
+ * NotePluginDataPool.h - preallocated storage for per-note plugin data
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_NOTE_PLUGIN_DATA_POOL_H
+#define LMMS_NOTE_PLUGIN_DATA_POOL_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include "LocklessAllocator.h"
+
+
+namespace lmms
+{
+
+/*! Storage for the objects an instrument keeps in NotePlayHandle::m_pluginData.
+
+	The memory for @p capacity objects is allocated together with the
+	instrument, so that starting a note on the audio thread doesn't need the
+	global allocator. Notes may be played by different worker threads at the
+	same time, which is why this uses the LocklessAllocator. If more notes
+	than expected are playing, the remaining objects are created on the heap,
+	destroy() knows where they came from.
+*/
+template<typename T>
+class NotePluginDataPool
+{
+	static_assert(alignof(T) <= alignof(std::max_align_t),
+		"The pool can't provide the alignment of over-aligned types");
+
+public:
+	//! The number of notes an instrument usually plays at once
+	static constexpr std::size_t DefaultCapacity = 64;
+
+	explicit NotePluginDataPool(std::size_t capacity = DefaultCapacity) :
+		m_allocator(capacity)
+	{
+	}
+
+	NotePluginDataPool(const NotePluginDataPool&) = delete;
+	NotePluginDataPool& operator=(const NotePluginDataPool&) = delete;
+
+	template<typename... Args>
+	T* create(Args&&... args)
+	{
+		if (void* ptr = m_allocator.tryAlloc())
+		{
+			return new (ptr) T(std::forward<Args>(args)...);
+		}
+		return new T(std::forward<Args>(args)...);
+	}
+
+	void destroy(T* ptr)
+	{
+		if (ptr == nullptr) { return; }
+
+		if (m_allocator.owns(ptr))
+		{
+			ptr->~T();
+			m_allocator.free(ptr);
+		}
+		else
+		{
+			delete ptr;
+		}
+	}
+
+private:
+	LocklessAllocatorT<T> m_allocator;
+};
+
+
+} // namespace lmms
+
+#endif // LMMS_NOTE_PLUGIN_DATA_POOL_H
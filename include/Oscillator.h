@@ -29,6 +29,8 @@
 #include <cassert>
 #include <fftw3.h>
 #include <cstdlib>
+#include <utility>
+#include <vector>
 
 #include "Engine.h"
 #include "lmms_constants.h"
@@ -89,9 +91,28 @@ public:
 		delete m_subOsc;
 	}
 
+	//! Destroys @p osc and its sub-oscillators, which were all created by
+	//! @p pool (a NotePluginDataPool<Oscillator>)
+	template<typename Pool>
+	static void destroyChain(Oscillator* osc, Pool& pool)
+	{
+		while (osc != nullptr)
+		{
+			Oscillator* subOsc = std::exchange(osc->m_subOsc, nullptr);
+			pool.destroy(osc);
+			osc = subOsc;
+		}
+	}
+
 	static void waveTableInit();
 	static void destroyFFTPlans();
-	static void generateAntiAliasUserWaveTable(SampleBuffer* sampleBuffer);
+	//! Fills @p waveform with the band-limited wave tables of the wave in @p sampleBuffer
+	static void generateAntiAliasUserWaveTable(const SampleBuffer* sampleBuffer, sample_t* waveform);
+
+	static const OscillatorConstants::WaveformLayout& waveformLayout()
+	{
+		return s_waveformLayout;
+	}
 
 	inline void setUseWaveTable(bool n)
 	{
@@ -179,44 +200,26 @@ public:
 	inline wtSampleControl getWtSampleControl(const float sample) const
 	{
 		wtSampleControl control;
-		control.frame = sample * OscillatorConstants::WAVETABLE_LENGTH;
-		control.f1 = static_cast<f_cnt_t>(control.frame) % OscillatorConstants::WAVETABLE_LENGTH;
+		control.frame = sample * m_waveTableLength;
+		control.f1 = static_cast<f_cnt_t>(control.frame) % m_waveTableLength;
 		if (control.f1 < 0)
 		{
-			control.f1 += OscillatorConstants::WAVETABLE_LENGTH;
+			control.f1 += m_waveTableLength;
 		}
-		control.f2 = control.f1 < OscillatorConstants::WAVETABLE_LENGTH - 1 ?
+		control.f2 = control.f1 < m_waveTableLength - 1 ?
 					control.f1 + 1 :
 					0;
-		control.band = waveTableBandFromFreq(
-			m_freq * m_detuning_div_samplerate * Engine::audioEngine()->processingSampleRate());
+		control.band = m_waveTableBand;
 		return control;
 	}
 
-	inline sample_t wtSample(
-		const sample_t table[OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT][OscillatorConstants::WAVETABLE_LENGTH],
-		const float sample) const
+	//! Samples the wave table of the current band from @p waveform
+	inline sample_t wtSample(const sample_t* waveform, const float sample) const
 	{
-		assert(table != nullptr);
+		assert(waveform != nullptr);
 		wtSampleControl control = getWtSampleControl(sample);
-		return linearInterpolate(table[control.band][control.f1],
-				table[control.band][control.f2], fraction(control.frame));
-	}
-
-	inline sample_t wtSample(const std::unique_ptr<OscillatorConstants::waveform_t>& table, const float sample) const
-	{
-		assert(table != nullptr);
-		wtSampleControl control = getWtSampleControl(sample);
-		return linearInterpolate((*table)[control.band][control.f1],
-				(*table)[control.band][control.f2], fraction(control.frame));
-	}
-
-	inline sample_t wtSample(sample_t **table, const float sample) const
-	{
-		assert(table != nullptr);
-		wtSampleControl control = getWtSampleControl(sample);
-		return linearInterpolate(table[control.band][control.f1],
-				table[control.band][control.f2], fraction(control.frame));
+		const sample_t* table = waveform + m_waveTableOffset;
+		return linearInterpolate(table[control.f1], table[control.f2], fraction(control.frame));
 	}
 
 	static inline int waveTableBandFromFreq(float freq)
@@ -252,18 +255,37 @@ private:
 	// There are many update*() variants; the modulator flag is stored as a member variable to avoid
 	// adding more explicit parameters to all of them. Can be converted to a parameter if needed.
 	bool m_isModulator;
+	// The frequency doesn't change during a period, so update() chooses the wavetable band and
+	// whether the sine is above the band limit once instead of for every sample.
+	int m_waveTableBand;
+	int m_waveTableOffset;
+	int m_waveTableLength;
+	bool m_sineAboveMaxFreq;
 
 	/* Multiband WaveTable */
-	static sample_t s_waveTables[NumWaveShapeTables][OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT][OscillatorConstants::WAVETABLE_LENGTH];
+	static const OscillatorConstants::WaveformLayout s_waveformLayout;
+	//! The waveforms of all wave shapes with wave tables, one after the other
+	static std::vector<sample_t> s_waveTables;
 	static fftwf_plan s_fftPlan;
 	static fftwf_plan s_ifftPlan;
 	static fftwf_complex * s_specBuf;
 	static std::array<float, OscillatorConstants::WAVETABLE_LENGTH> s_sampleBuffer;
 
-	static void generateSawWaveTable(int bands, sample_t* table, int firstBand = 1);
-	static void generateTriangleWaveTable(int bands, sample_t* table, int firstBand = 1);
-	static void generateSquareWaveTable(int bands, sample_t* table, int firstBand = 1);
-	static void generateFromFFT(int bands, sample_t* table);
+	static OscillatorConstants::WaveformLayout createWaveformLayout();
+	static int bandHarmonics(int band)
+	{
+		return OscillatorConstants::MAX_FREQ / freqFromWaveTableBand(band);
+	}
+	static sample_t* waveTables(WaveShape shape)
+	{
+		return s_waveTables.data() + (static_cast<std::size_t>(shape) - FirstWaveShapeTable) * s_waveformLayout.size;
+	}
+
+	static void generateSawWaveTable(int bands, sample_t* table, int length, int firstBand = 1);
+	static void generateTriangleWaveTable(int bands, sample_t* table, int length, int firstBand = 1);
+	static void generateSquareWaveTable(int bands, sample_t* table, int length, int firstBand = 1);
+	static void generateFromFFT(int bands, sample_t* table, int length, const std::vector<float>& spectrum);
+	static void generateWaveformFromFFT(sample_t* waveform);
 	static void generateWaveTables();
 	static void createFFTPlans();
 
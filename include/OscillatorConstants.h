@@ -27,6 +27,7 @@
 #define LMMS_OSCILLATORCONSTANTS_H
 
 #include <array>
+#include <vector>
 
 #include "lmms_basics.h"
 
@@ -40,18 +41,32 @@ namespace lmms::OscillatorConstants
 
 	//SEMITONES_PER_TABLE, the smaller the value the smoother the harmonics change on frequency sweeps
 	// with the trade off of increased memory requirements to store the wave tables
-	// require memory = NumberOfWaveShapes*WAVETABLE_LENGTH*(MidiNoteCount/SEMITONES_PER_TABLE)*BytePerSample_t
-	// 7*2446*(128/1)*4 = 8766464 bytes
 	const int SEMITONES_PER_TABLE = 1;
 	const int WAVE_TABLES_PER_WAVEFORM_COUNT = 128 / SEMITONES_PER_TABLE;
 
+	// Wave tables for higher notes contain fewer harmonics, so they are shorter (mip-mapping): a wave table
+	// has WAVETABLE_OVERSAMPLING times the two samples per period its highest harmonic needs, rounded up to a
+	// power of two, which keeps the error of the linear interpolation between its samples small. Only the
+	// tables of the lowest notes are WAVETABLE_LENGTH long. This takes 147248 samples per waveform instead of
+	// 128*2446 = 313088, about 2.9 MB instead of 6.3 MB for the 5 built-in waveforms.
+	constexpr int WAVETABLE_OVERSAMPLING = 4;
+	constexpr int MIN_WAVETABLE_LENGTH = 64;
+
+	//! Where the wave table of each band starts within a waveform, and how long it is
+	struct WaveformLayout
+	{
+		std::array<int, WAVE_TABLES_PER_WAVEFORM_COUNT> offset;
+		std::array<int, WAVE_TABLES_PER_WAVEFORM_COUNT> length;
+		int size; //!< The number of samples of all wave tables of a waveform
+	};
+
 	// There is some ambiguity around the use of "wavetable", "wavetable synthesis" or related terms.
 	// The following meanings and definitions were selected for use in the Oscillator class:
 	//  - wave shape: abstract and precise definition of the graph associated with a given type of wave;
 	//  - waveform: digital representations the wave shape, a set of waves optimized for use at varying pitches;
 	//  - wavetable: a table containing one period of a wave, with frequency content optimized for a specific pitch.
-	using wavetable_t = std::array<sample_t, WAVETABLE_LENGTH>;
-	using waveform_t = std::array<wavetable_t, WAVE_TABLES_PER_WAVEFORM_COUNT>;
+	// The wavetables of a waveform are stored one after the other, as described by Oscillator::waveformLayout().
+	using waveform_t = std::vector<sample_t>;
 
 } // namespace lmms::OscillatorConstants
 
@@ -75,6 +75,20 @@ public:
 		return false;
 	}
 
+	//! Whether the handle may be destroyed on another thread than the audio
+	//! thread after it finished, i.e. its destructor doesn't touch state
+	//! shared with the audio or GUI thread
+	virtual bool isReclaimable() const
+	{
+		return false;
+	}
+
+	//! Called by the AudioEngine with the model locked when the handle is
+	//! retired, so it can let go of shared state before being destroyed
+	virtual void detach()
+	{
+	}
+
 	const QThread* affinity() const
 	{
 		return m_affinity;
@@ -156,6 +170,12 @@ private:
 	bool m_bufferReleased;
 	bool m_usesBuffer;
 	AudioPort * m_audioPort;
+	//! Position in AudioEngine's list of running play handles, -1 if not in it
+	int m_engineIndex;
+	//! Position in AudioEngine's list of handles to remove, -1 if not in it
+	int m_removalIndex;
+
+	friend class AudioEngine;
 } ;
 
 using PlayHandleList = QList<PlayHandle*>;
@@ -39,6 +39,7 @@ namespace lmms
 {
 
 class AutomatableModel;
+class DataFile;
 class PixmapLoader;
 
 namespace gui
@@ -291,6 +292,13 @@ public:
 	//!   use instantiateWithKey instead
 	static Plugin * instantiate(const QString& pluginName, Model * parent, void *data);
 
+	//! Lets the plugins of the instruments in @p dataFile start loading the
+	//! files their settings refer to in the background, before the
+	//! instruments are restored one after another
+	static void prefetch(const DataFile& dataFile);
+	//! Frees whatever the plugins prefetched and no instrument took
+	static void dropPrefetched();
+
 	//! Create a view for the model
 	gui::PluginView * createView( QWidget * parent );
 
@@ -307,6 +315,11 @@ private:
 
 	// pointer to instantiation-function in plugin
 	using InstantiationHook = Plugin* (*)(Model*, void*);
+	// optional functions in plugin: "lmms_plugin_prefetch" gets the settings
+	// of an instance about to be restored, "lmms_plugin_drop_prefetched"
+	// frees what no instance took
+	using PrefetchHook = void (*)(const QDomElement&);
+	using DropPrefetchedHook = void (*)();
 } ;
 
 
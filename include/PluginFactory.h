@@ -49,6 +49,8 @@ public:
 	{
 		QString name() const;
 		QFileInfo file;
+		//! Not loaded yet if the descriptor was taken from the startup
+		//! cache, use PluginFactory::load() before resolving symbols
 		std::shared_ptr<QLibrary> library = nullptr;
 		Plugin::Descriptor* descriptor = nullptr;
 
@@ -58,7 +60,7 @@ public:
 	using DescriptorMap = QMultiMap<Plugin::Type, Plugin::Descriptor*>;
 
 	PluginFactory();
-	~PluginFactory() = default;
+	~PluginFactory();
 
 	static void setupSearchPaths();
 
@@ -87,7 +89,11 @@ public:
 	/// PluginInfo::isNull() to check this).
 	PluginInfo pluginInfo(const char* name) const;
 
-	/// When loading a library fails during discovery, the error string is saved.
+	/// Loads the library of the plugin and the libraries it depends on, if
+	/// this hasn't been done yet. On failure, the error string is saved.
+	bool load(const PluginInfo& info);
+
+	/// When loading a library fails, the error string is saved.
 	/// It can be retrieved by calling this function.
 	QString errorString(QString pluginName) const;
 
@@ -103,6 +109,12 @@ private:
 
 	QHash<QString, QString> m_errors;
 
+	//! Descriptors of plugins whose libraries haven't been loaded yet. They
+	//! are never removed, since they might still be referenced after
+	//! discovering the plugins again.
+	struct CachedDescriptor;
+	std::vector<std::unique_ptr<CachedDescriptor>> m_cachedDescriptors;
+
 	static std::unique_ptr<PluginFactory> s_instance;
 };
 
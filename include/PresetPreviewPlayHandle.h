@@ -52,6 +52,15 @@ public:
 
 	bool isFromTrack( const Track * _track ) const override;
 
+	//! The preview note is released in detach(), which leaves nothing
+	//! shared for the destructor
+	bool isReclaimable() const override
+	{
+		return true;
+	}
+
+	void detach() override;
+
 	static void init();
 	static void cleanup();
 	static ConstNotePlayHandleList nphsOfInstrumentTrack( const InstrumentTrack* instrumentTrack );
@@ -25,8 +25,10 @@
 #ifndef LMMS_PROJECT_JOURNAL_H
 #define LMMS_PROJECT_JOURNAL_H
 
+#include <cstddef>
+#include <deque>
+#include <QByteArray>
 #include <QHash>
-#include <QStack>
 
 #include "lmms_basics.h"
 #include "DataFile.h"
@@ -43,7 +45,9 @@ class JournallingObject;
 class ProjectJournal
 {
 public:
-	static const int MAX_UNDO_STATES;
+	//! Memory the undo and redo history may use if nothing else is
+	//! configured (in MB, see "app"/"undobudget" in the config)
+	static const int DEFAULT_MEMORY_BUDGET;
 
 	ProjectJournal();
 	virtual ~ProjectJournal() = default;
@@ -102,22 +106,42 @@ public:
 private:
 	using JoIdMap = QHash<jo_id_t, JournallingObject*>;
 
+	//! The state of an object as compact XML. Only the most recent
+	//! checkpoint of an object in a stack holds its complete state, the
+	//! earlier ones only hold the difference to the next one of the same
+	//! object, so their size depends on the size of the change.
 	struct CheckPoint
 	{
-		CheckPoint( jo_id_t initID = 0, const DataFile& initData = DataFile( DataFile::Type::JournalData ) ) :
-			joID( initID ),
-			data( initData )
-		{
-		}
 		jo_id_t joID;
-		DataFile data;
+		QByteArray data;
+		bool isDelta;
+		//! Position of the previous checkpoint of the same object
+		std::size_t previous;
 	} ;
-	using CheckPointStack = QStack<CheckPoint>;
+	struct CheckPointStack
+	{
+		std::deque<CheckPoint> checkPoints;
+		//! Number of checkpoints dropped from the front, as positions are
+		//! counted from the first checkpoint ever pushed
+		std::size_t dropped = 0;
+		//! Position of the most recent checkpoint of each object
+		QHash<jo_id_t, std::size_t> latest;
+		//! Bytes held by the checkpoints
+		std::size_t size = 0;
+	} ;
+
+	static void pushCheckPoint( CheckPointStack & stack, jo_id_t id, const QByteArray & state );
+	//! Removes the most recent checkpoint and returns its complete state
+	static QByteArray popCheckPoint( CheckPointStack & stack, jo_id_t & id );
+	static void dropOldestCheckPoint( CheckPointStack & stack );
+	//! Drops the oldest checkpoints until the memory budget is met
+	void trimJournal();
 
 	JoIdMap m_joIDs;
 
 	CheckPointStack m_undoCheckPoints;
 	CheckPointStack m_redoCheckPoints;
+	std::size_t m_memoryBudget;
 
 	bool m_journalling;
 
@@ -72,6 +72,30 @@ public:
 		return m_fileDev != nullptr;
 	}
 
+	//! Additionally encode the render as @p fileFormat into @p outputFilename,
+	//! e.g. an MP3 preview next to the WAV master
+	bool addOutput(ExportFileFormat fileFormat, const QString & outputFilename);
+
+	//! Render the same project always into the same audio, see
+	//! AudioEngine::setDeterministic()
+	void setDeterministic( bool deterministic )
+	{
+		m_deterministic = deterministic;
+	}
+
+	//! The hash of the rendered audio, available once the rendering finished
+	//! if it was deterministic
+	const QByteArray & outputHash() const
+	{
+		return m_outputHash;
+	}
+
+	//! The files completely encoded, available once the rendering finished
+	const QStringList & outputFiles() const
+	{
+		return m_outputFiles;
+	}
+
 	static ExportFileFormat getFileFormatFromExtension(
 							const QString & _ext );
 
@@ -93,11 +117,18 @@ signals:
 private:
 	void run() override;
 
+	AudioFileDevice * createFileDevice( ExportFileFormat fileFormat,
+				const QString & outputFilename ) const;
+
 	AudioFileDevice * m_fileDev;
 	AudioEngine::qualitySettings m_qualitySettings;
+	OutputSettings m_outputSettings;
 
 	volatile int m_progress;
 	volatile bool m_abort;
+	bool m_deterministic;
+	QByteArray m_outputHash;
+	QStringList m_outputFiles;
 
 } ;
 
@@ -27,6 +27,7 @@
 #define LMMS_RENDER_MANAGER_H
 
 #include <memory>
+#include <QMap>
 
 #include "ProjectRenderer.h"
 #include "OutputSettings.h"
@@ -48,6 +49,24 @@ public:
 
 	~RenderManager() override;
 
+	/// Export into this format as well, in the same render pass
+	void addOutputFormat(ProjectRenderer::ExportFileFormat fmt);
+
+	/// Render deterministically, see AudioEngine::setDeterministic()
+	void setDeterministic(bool deterministic);
+
+	/// The hashes of the rendered audio by file, see AudioFileDevice::audioHash()
+	const QMap<QString, QByteArray>& outputHashes() const
+	{
+		return m_outputHashes;
+	}
+
+	/// The files which were completely written, see ProjectRenderer::outputFiles()
+	const QStringList& outputFiles() const
+	{
+		return m_outputFiles;
+	}
+
 	/// Export all unmuted tracks into a single file
 	void renderProject();
 
@@ -74,6 +93,11 @@ private:
 	const AudioEngine::qualitySettings m_oldQualitySettings;
 	const OutputSettings m_outputSettings;
 	ProjectRenderer::ExportFileFormat m_format;
+	std::vector<ProjectRenderer::ExportFileFormat> m_additionalFormats;
+	bool m_deterministic = false;
+	QString m_activeOutputPath;
+	QMap<QString, QByteArray> m_outputHashes;
+	QStringList m_outputFiles;
 	QString m_outputPath;
 
 	std::unique_ptr<ProjectRenderer> m_activeRenderer;
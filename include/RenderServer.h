@@ -0,0 +1,95 @@
+/*
+ * RenderServer.h - renders projects sent as JSON lines on stdin
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_RENDER_SERVER_H
+#define LMMS_RENDER_SERVER_H
+
+#include <vector>
+#include <QJsonObject>
+#include <QObject>
+
+#include "AudioEngine.h"
+#include "OutputSettings.h"
+#include "ProjectRenderer.h"
+
+
+namespace lmms
+{
+
+
+/*! Keeps the engine initialized and renders one project after the other,
+	so a render queue doesn't pay the start-up of LMMS for every job.
+
+	Every line on stdin is a JSON object describing a job:
+
+		{"id": "42", "project": "song.mmpz", "output": "song", "format": "wav,mp3"}
+
+	Further optional keys are named like the command line options of
+	"render": samplerate, bitrate, float, mode, interpolation, oversampling,
+	loop, deterministic and tracks (for rendering each track into the
+	directory "output"). Options missing in a job default to the ones given
+	on the command line, including the formats. "loopcount" sets how often
+	a looped song is rendered and defaults to 1.
+
+	Each job answers with JSON lines on stdout with the "id" of the job and
+	an "event", which is "progress" (with "progress" in percent), "done"
+	(with "files", "loadms", "renderms" and for deterministic renders the
+	"hashes" of the audio by file) or "error" (with "message").
+	Other output of LMMS or its plugins may be interleaved and doesn't start
+	with '{'. The server quits at the end of stdin or on {"command": "quit"}.
+*/
+class RenderServer : public QObject
+{
+	Q_OBJECT
+public:
+	//! The command line options which aren't part of the settings
+	struct Defaults
+	{
+		std::vector<ProjectRenderer::ExportFileFormat> formats;
+		bool loop;
+		bool deterministic;
+	};
+
+	RenderServer(const AudioEngine::qualitySettings& qualitySettings,
+		const OutputSettings& outputSettings, Defaults defaults, QObject* parent = nullptr);
+
+public slots:
+	//! Reads and renders jobs until stdin ends, then emits finished()
+	void run();
+
+signals:
+	void finished();
+
+private:
+	void renderJob(const QJsonObject& job);
+	void reply(const QJsonObject& job, const QString& event, QJsonObject values);
+	void replyError(const QJsonObject& job, const QString& message);
+
+	const AudioEngine::qualitySettings m_qualitySettings;
+	const OutputSettings m_outputSettings;
+	const Defaults m_defaults;
+} ;
+
+
+} // namespace lmms
+
+#endif // LMMS_RENDER_SERVER_H
@@ -25,9 +25,11 @@
 #ifndef LMMS_SAMPLE_BUFFER_H
 #define LMMS_SAMPLE_BUFFER_H
 
+#include <atomic>
 #include <memory>
 #include <QReadWriteLock>
 #include <QObject>
+#include <QStringList>
 
 #include <samplerate.h>
 
@@ -120,6 +122,13 @@ public:
 
 	~SampleBuffer() override;
 
+	//! Start decoding the given audio files on the global thread pool, so
+	//! that loading them afterwards (e.g. while restoring the tracks of a
+	//! project) only has to pick up the result
+	static void prefetch(const QStringList & audioFiles);
+	//! Free all prefetched data
+	static void dropPrefetched();
+
 	bool play(
 		sampleFrame * ab,
 		handleState * state,
@@ -249,8 +258,6 @@ public:
 	// dataUnlock()
 	SampleBuffer * resample(const sample_rate_t srcSR, const sample_rate_t dstSR);
 
-	void normalizeSampleRate(const sample_rate_t srcSR, bool keepSettings = false);
-
 	// protect calls from the GUI to this function with dataReadLock() and
 	// dataUnlock(), out of loops for efficiency
 	inline sample_t userWaveSample(const float sample) const
@@ -276,8 +283,19 @@ public:
 		m_varLock.unlock();
 	}
 
+	//! Builds the band-limited wave tables of the sample, used when it's
+	//! played as a user defined oscillator wave. They're kept up to date from
+	//! then on.
+	void enableUserAntiAliasWaveTable();
 
-	std::unique_ptr<OscillatorConstants::waveform_t> m_userAntiAliasWaveTable;
+	//! The tables laid out as in Oscillator::waveformLayout(), or nullptr if
+	//! they haven't been enabled yet
+	const sample_t* userAntiAliasWaveTable() const
+	{
+		return m_hasUserAntiAliasWaveTable.load(std::memory_order_acquire)
+			? m_userAntiAliasWaveTable.data()
+			: nullptr;
+	}
 
 
 public slots:
@@ -294,30 +312,54 @@ private:
 
 	void update(bool keepSettings = false);
 
-	void convertIntToFloat(int_sample_t * & ibuf, f_cnt_t frames, int channels);
-	void directFloatWrite(sample_t * & fbuf, f_cnt_t frames, int channels);
-
-	f_cnt_t decodeSampleSF(
+	// the decoders don't touch the buffer itself, so that they can run
+	// on any thread, see prefetch()
+	static sampleFrame * resampleFrames(const sampleFrame * data, const f_cnt_t frames,
+		const sample_rate_t srcSR, const sample_rate_t dstSR, f_cnt_t & dstFrames);
+	static void convertIntToFloat(int_sample_t * & ibuf, f_cnt_t frames, int channels,
+		sampleFrame * & data, bool reversed);
+	static void directFloatWrite(sample_t * & fbuf, f_cnt_t frames, int channels,
+		sampleFrame * & data, bool reversed);
+
+	static f_cnt_t decodeFile(
+		const QString & fileName,
+		sampleFrame * & data,
+		sample_rate_t & samplerate,
+		bool reversed
+	);
+	static f_cnt_t decodeSampleSF(
 		QString fileName,
 		sample_t * & buf,
 		ch_cnt_t & channels,
-		sample_rate_t & samplerate
+		sample_rate_t & samplerate,
+		sampleFrame * & data,
+		bool reversed
 	);
 #ifdef LMMS_HAVE_OGGVORBIS
-	f_cnt_t decodeSampleOGGVorbis(
+	static f_cnt_t decodeSampleOGGVorbis(
 		QString fileName,
 		int_sample_t * & buf,
 		ch_cnt_t & channels,
-		sample_rate_t & samplerate
+		sample_rate_t & samplerate,
+		sampleFrame * & data,
+		bool reversed
 	);
 #endif
-	f_cnt_t decodeSampleDS(
+	static f_cnt_t decodeSampleDS(
 		QString fileName,
 		int_sample_t * & buf,
 		ch_cnt_t & channels,
-		sample_rate_t & samplerate
+		sample_rate_t & samplerate,
+		sampleFrame * & data,
+		bool reversed
 	);
 
+	//! Hands out the data of a prefetched file, waiting for it if necessary.
+	//! The last reference to the file takes the data itself, earlier ones
+	//! get a copy
+	static bool takePrefetched(const QString & file, sampleFrame * & data,
+		f_cnt_t & frames, sample_rate_t & samplerate);
+
 	QString m_audioFile;
 	sampleFrame * m_origData;
 	f_cnt_t m_origFrames;
@@ -333,6 +375,9 @@ private:
 	float m_frequency;
 	sample_rate_t m_sampleRate;
 
+	OscillatorConstants::waveform_t m_userAntiAliasWaveTable;
+	std::atomic<bool> m_hasUserAntiAliasWaveTable{false};
+
 	sampleFrame * getSampleFragment(
 		f_cnt_t index,
 		f_cnt_t frames,
@@ -53,6 +53,13 @@ public:
 		return true;
 	}
 
+	//! Only frees the sample and the own audio port, whose removal is
+	//! synchronized by the AudioEngine
+	bool isReclaimable() const override
+	{
+		return true;
+	}
+
 
 	void play( sampleFrame * buffer ) override;
 	bool isFinished() const override;
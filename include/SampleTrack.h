@@ -73,6 +73,8 @@ public:
 		return "sampletrack";
 	}
 
+	void setName(const QString& name) override;
+
 	bool isPlaying()
 	{
 		return m_isPlaying;
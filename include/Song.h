@@ -25,6 +25,7 @@
 #ifndef LMMS_SONG_H
 #define LMMS_SONG_H
 
+#include <future>
 #include <memory>
 
 #include <QHash>
@@ -41,6 +42,7 @@ namespace lmms
 {
 
 class AutomationTrack;
+class DataFile;
 class Keymap;
 class MidiClip;
 class Scale;
@@ -298,6 +300,15 @@ public:
 	bool guiSaveProject();
 	bool guiSaveProjectAs(const QString & filename);
 	bool saveProjectFile(const QString & filename, bool withResources = false);
+	//! Like saveProjectFile(), but builds the snapshot a track at a time and
+	//! doesn't wait for the file to be written. Returns false without saving
+	//! if the previous one or a call of saveProjectFile() is still running.
+	//! The save is dropped if the project changes before the snapshot is done.
+	bool saveProjectFileInBackground(const QString & filename);
+	bool isSavingInBackground() const;
+	//! Wait for the background save being written, one whose snapshot isn't
+	//! complete yet is dropped
+	void waitForBackgroundSave();
 
 	const QString & projectFileName() const
 	{
@@ -406,6 +417,10 @@ private slots:
 
 	void updateFramesPerTick();
 
+	//! Add the next track to the snapshot of saveProjectFileInBackground(),
+	//! or hand the snapshot over to a worker once all are there
+	void continueBackgroundSnapshot();
+
 
 
 private:
@@ -443,6 +458,13 @@ private:
 	void saveKeymapStates(QDomDocument &doc, QDomElement &element);
 	void restoreKeymapStates(const QDomElement &element);
 
+	//! Serializes the project into @p dataFile, which is a snapshot that
+	//! can be written while the project is modified further
+	void saveProjectSnapshot(DataFile& dataFile);
+	//! The parts of saveProjectSnapshot() before and after the tracks
+	void saveSnapshotHead(DataFile& dataFile);
+	void saveSnapshotTail(DataFile& dataFile);
+
 	void processAutomations(const TrackList& tracks, TimePos timeStart, fpp_t frames);
 
 	void setModified(bool value);
@@ -475,6 +497,14 @@ private:
 
 	bool m_savingProject;
 	bool m_loadingProject;
+	//! saveProjectFile() is waiting for its write to finish
+	bool m_writingProject;
+	std::future<bool> m_backgroundSave;
+	struct BackgroundSnapshot;
+	std::unique_ptr<BackgroundSnapshot> m_backgroundSnapshot;
+	//! Counts the modifications, so that a snapshot built over several event
+	//! loop iterations can tell whether the project changed meanwhile
+	unsigned m_modifications;
 	bool m_isCancelled;
 
 	SaveOptions m_saveOptions;
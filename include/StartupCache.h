@@ -0,0 +1,78 @@
+/*
+ * StartupCache.h - on-disk cache for data computed at start-up
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_STARTUP_CACHE_H
+#define LMMS_STARTUP_CACHE_H
+
+#include <cstddef>
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+
+#include "lmms_export.h"
+
+namespace lmms
+{
+
+/*! Files in the user's cache directory holding data which is expensive to
+	compute at start-up, like the oscillator wavetables or the results of
+	scanning the plugins.
+
+	Every file stores a key next to its data. The key always contains the
+	LMMS version and is extended by the callers with everything the data
+	depends on (table sizes, file modification times, ...), so a cache file
+	which doesn't match is simply ignored and written again.
+
+	The cache lives in $XDG_CACHE_HOME/lmms (or the platform's equivalent)
+	and can be moved with the environment variable LMMS_CACHE_DIR. Setting
+	it to "none" disables the cache.
+*/
+class LMMS_EXPORT StartupCache
+{
+public:
+	using Entries = QMap<QString, QByteArray>;
+
+	//! Returns the cache directory or an empty string if it's disabled
+	static QString directory();
+
+	//! Fill @p data from the cache file @p name, returns false if there is
+	//! no file for @p key or its size doesn't match
+	static bool loadBlob(const QString& name, const QByteArray& key, void* data, std::size_t size);
+	static void storeBlob(const QString& name, const QByteArray& key, const void* data, std::size_t size);
+
+	//! Like loadBlob(), but for data of variable size, e.g. plugin
+	//! descriptions keyed by their file
+	static Entries loadEntries(const QString& name, const QByteArray& key);
+	static void storeEntries(const QString& name, const QByteArray& key, const Entries& entries);
+
+	//! Returns a string which changes whenever the file @p path is modified
+	static QByteArray fileStamp(const QString& path);
+
+	//! Load and save the plans FFTW has measured, so that FFTW_MEASURE
+	//! plans are only measured once
+	static void importFftwWisdom();
+	static void exportFftwWisdom();
+};
+
+} // namespace lmms
+
+#endif // LMMS_STARTUP_CACHE_H
@@ -61,6 +61,10 @@ public:
 
 	void saveSettings( QDomDocument & _doc, QDomElement & _parent ) override;
 
+	//! Like saveState(), but leaves the tracks to the caller, who can then
+	//! save them one by one into the returned element
+	QDomElement saveStateWithoutTracks( QDomDocument & doc, QDomElement & parent );
+
 	void loadSettings( const QDomElement & _this ) override;
 
 	int countTracks( Track::Type _tt = Track::Type::Count ) const;
@@ -107,6 +111,7 @@ protected:
 
 private:
 	TrackList m_tracks;
+	bool m_saveTracks;
 
 	Type m_TrackContainerType;
 
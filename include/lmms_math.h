@@ -27,6 +27,7 @@
 
 #include <cstdint>
 #include "lmms_constants.h"
+#include "lmms_export.h"
 #include "lmmsconfig.h"
 #include <QtGlobal>
 
@@ -122,11 +123,23 @@ static inline float absFraction( float _x )
 
 
 constexpr int FAST_RAND_MAX = 32767;
+
+//! The state of fast_rand() for the calling thread. It lives in the core
+//! library, so that plugins use the same one and fastRandSeed() affects
+//! them too.
+LMMS_EXPORT unsigned long& fastRandState();
+
 static inline int fast_rand()
 {
-	static unsigned long next = 1;
-	next = next * 1103515245 + 12345;
-	return( (unsigned)( next / 65536 ) % 32768 );
+	unsigned long& state = fastRandState();
+	state = state * 1103515245 + 12345;
+	return( (unsigned)( state / 65536 ) % 32768 );
+}
+
+//! Seeds fast_rand() on the calling thread only
+static inline void fastRandSeed( unsigned long seed )
+{
+	fastRandState() = seed;
 }
 
 static inline double fastRand( double range )
@@ -283,6 +296,63 @@ static inline float dbfsToAmp( float dbfs )
 }
 
 
+//! @brief Approximates log2(x), with an error below 1e-5. Meant for per sample use in dynamics processors.
+//! @param x ** Must be a normal number larger than zero! **
+static inline float fastLog2f( float x )
+{
+	union
+	{
+		float f;
+		int32_t i;
+	} u = { x };
+	int32_t exponent = ( ( u.i >> 23 ) & 0xff ) - 127;
+	u.i = ( u.i & 0x007fffff ) | 0x3f800000; // the mantissa, within [1, 2)
+	if( u.f > 1.41421356f ) // keep the mantissa around 1, where the series converges fastest
+	{
+		u.f *= 0.5f;
+		++exponent;
+	}
+	// log2(m) = 2 / ln(2) * atanh(t), with t = (m - 1) / (m + 1) and |t| < 0.172
+	const float t = ( u.f - 1.0f ) / ( u.f + 1.0f );
+	const float t2 = t * t;
+	return exponent + t * ( 2.8853901f + t2 * ( 0.9617967f + t2 * 0.5770780f ) );
+}
+
+
+//! @brief Approximates 2^x, with a relative error below 1e-5. Meant for per sample use in dynamics processors.
+//! @param x The exponent, which is clamped to [-126, 126]
+static inline float fastPow2f( float x )
+{
+	x = std::clamp( x, -126.0f, 126.0f );
+	const float rounded = std::floor( x + 0.5f );
+	const float f = x - rounded;
+	union
+	{
+		float f;
+		int32_t i;
+	} u;
+	u.i = ( static_cast<int32_t>( rounded ) + 127 ) << 23;
+	// Taylor series of e^(f * ln(2)) with |f| <= 0.5
+	return u.f * ( 1.0f + f * ( 0.69314718f + f * ( 0.24022651f + f * ( 0.05550411f + f * ( 0.00961813f + f * 0.00133336f ) ) ) ) );
+}
+
+
+//! @brief Faster ampToDbfs(), accurate to 1e-4 dB
+//! @param amp Linear amplitude, where 1.0 = 0dBFS. ** Must be larger than zero! **
+static inline float fastAmpToDbfs( float amp )
+{
+	return fastLog2f( amp ) * 6.0205999f;
+}
+
+
+//! @brief Faster dbfsToAmp(), with a relative error below 1e-5
+//! @param dbfs The dBFS value to convert. ** Must be a real number - not inf/nan! **
+static inline float fastDbfsToAmp( float dbfs )
+{
+	return fastPow2f( dbfs * 0.1660964f );
+}
+
+
 
 //! returns 1.0f if val >= 0.0f, -1.0 else
 static inline float sign( float val ) 
@@ -24,6 +24,8 @@
 
 #include "Compressor.h"
 
+#include <type_traits>
+
 #include "embed.h"
 #include "interpolation.h"
 #include "lmms_math.h"
@@ -276,255 +278,269 @@ bool CompressorEffect::processAudioBuffer(sampleFrame* buf, const fpp_t frames)
 	const bool autoMakeup = m_compressorControls.m_autoMakeupModel.value();
 	const int stereoLink = m_compressorControls.m_stereoLinkModel.value();
 	const bool audition = m_compressorControls.m_auditionModel.value();
-	const bool feedback = m_compressorControls.m_feedbackModel.value();
-	const bool lookahead = m_compressorControls.m_lookaheadModel.value();
+	const bool feedbackEnabled = m_compressorControls.m_feedbackModel.value();
+	const bool lookaheadEnabled = m_compressorControls.m_lookaheadModel.value();
 
-	for(fpp_t f = 0; f < frames; ++f)
+	// The lookahead and feedback modes are template parameters of the frame loop, so that the
+	// compiler can drop the code of the modes that aren't used instead of testing them per sample.
+	auto processFrames = [&](auto lookaheadMode, auto feedbackMode)
 	{
-		auto drySignal = std::array{buf[f][0], buf[f][1]};
-		auto s = std::array{drySignal[0] * m_inGainVal, drySignal[1] * m_inGainVal};
+		constexpr bool lookahead = decltype(lookaheadMode)::value;
+		constexpr bool feedback = decltype(feedbackMode)::value;
 
-		// Calculate tilt filters, to bias the sidechain to the low or high frequencies
-		if (m_tiltVal)
+		for(fpp_t f = 0; f < frames; ++f)
 		{
-			calcTiltFilter(s[0], s[0], 0);
-			calcTiltFilter(s[1], s[1], 1);
-		}
+			auto drySignal = std::array{buf[f][0], buf[f][1]};
+			auto s = std::array{drySignal[0] * m_inGainVal, drySignal[1] * m_inGainVal};
 
-		if (midside)// Convert left/right to mid/side
-		{
-			const float temp = s[0];
-			s[0] = (temp + s[1]) * 0.5;
-			s[1] = temp - s[1];
-		}
+			// Calculate tilt filters, to bias the sidechain to the low or high frequencies
+			if (m_tiltVal)
+			{
+				calcTiltFilter(s[0], s[0], 0);
+				calcTiltFilter(s[1], s[1], 1);
+			}
 
-		s[0] *= inBalance > 0 ? 1 - inBalance : 1;
-		s[1] *= inBalance < 0 ? 1 + inBalance : 1;
+			if (midside)// Convert left/right to mid/side
+			{
+				const float temp = s[0];
+				s[0] = (temp + s[1]) * 0.5;
+				s[1] = temp - s[1];
+			}
 
-		m_gainResult[0] = 0;
-		m_gainResult[1] = 0;
+			s[0] *= inBalance > 0 ? 1 - inBalance : 1;
+			s[1] *= inBalance < 0 ? 1 + inBalance : 1;
 
-		for (int i = 0; i < 2; i++)
-		{
-			float inputValue = (feedback && !lookahead) ? m_prevOut[i] : s[i];
+			m_gainResult[0] = 0;
+			m_gainResult[1] = 0;
 
-			// Calculate the crest factor of the audio by diving the peak by the RMS
-			m_crestPeakVal[i] = qMax(qMax(COMP_NOISE_FLOOR, inputValue * inputValue), m_crestTimeConst * m_crestPeakVal[i] + (1 - m_crestTimeConst) * (inputValue * inputValue));
-			m_crestRmsVal[i] = qMax(COMP_NOISE_FLOOR, m_crestTimeConst * m_crestRmsVal[i] + ((1 - m_crestTimeConst) * (inputValue * inputValue)));
-			m_crestFactorVal[i] = m_crestPeakVal[i] / m_crestRmsVal[i];
+			for (int i = 0; i < 2; i++)
+			{
+				float inputValue = feedback ? m_prevOut[i] : s[i];
 
-			m_rmsVal[i] = m_rmsTimeConst * m_rmsVal[i] + ((1 - m_rmsTimeConst) * (inputValue * inputValue));
+				// Calculate the crest factor of the audio by diving the peak by the RMS
+				m_crestPeakVal[i] = qMax(qMax(COMP_NOISE_FLOOR, inputValue * inputValue), m_crestTimeConst * m_crestPeakVal[i] + (1 - m_crestTimeConst) * (inputValue * inputValue));
+				m_crestRmsVal[i] = qMax(COMP_NOISE_FLOOR, m_crestTimeConst * m_crestRmsVal[i] + ((1 - m_crestTimeConst) * (inputValue * inputValue)));
+				m_crestFactorVal[i] = m_crestPeakVal[i] / m_crestRmsVal[i];
 
-			// Grab the peak or RMS value
-			inputValue = qMax(COMP_NOISE_FLOOR, peakmode ? std::abs(inputValue) : std::sqrt(m_rmsVal[i]));
+				m_rmsVal[i] = m_rmsTimeConst * m_rmsVal[i] + ((1 - m_rmsTimeConst) * (inputValue * inputValue));
 
-			float t = inputValue;
+				// Grab the peak or RMS value
+				inputValue = qMax(COMP_NOISE_FLOOR, peakmode ? std::abs(inputValue) : std::sqrt(m_rmsVal[i]));
 
-			if (t > m_yL[i])// Attack phase
-			{
-				// We want the "resting value" of our crest factor to be with a sine wave,
-				// which with this variable has a value of 2.
-				// So, we pull this value down to 0, and multiply it by the percentage of
-				// automatic attack control that is applied.  We then add 2 back to it.
-				float crestFactorValTemp = ((m_crestFactorVal[i] - 2.f) * m_autoAttVal) + 2.f;
-
-				// Calculate attack value depending on crest factor
-				const float att = m_autoAttVal
-					? msToCoeff(2.f * m_compressorControls.m_attackModel.value() / (crestFactorValTemp))
-					: m_attCoeff;
-
-				m_yL[i] = m_yL[i] * att + (1 - att) * t;
-				m_holdTimer[i] = m_holdLength;// Reset hold timer
-			}
-			else// Release phase
-			{
-				float crestFactorValTemp = ((m_crestFactorVal[i] - 2.f) * m_autoRelVal) + 2.f;
-
-				const float rel = m_autoRelVal
-					? msToCoeff(2.f * m_compressorControls.m_releaseModel.value() / (crestFactorValTemp))
-					: m_relCoeff;
+				float t = inputValue;
 
-				if (m_holdTimer[i])// Don't change peak if hold is being applied
+				if (t > m_yL[i])// Attack phase
 				{
-					--m_holdTimer[i];
+					// We want the "resting value" of our crest factor to be with a sine wave,
+					// which with this variable has a value of 2.
+					// So, we pull this value down to 0, and multiply it by the percentage of
+					// automatic attack control that is applied.  We then add 2 back to it.
+					float crestFactorValTemp = ((m_crestFactorVal[i] - 2.f) * m_autoAttVal) + 2.f;
+
+					// Calculate attack value depending on crest factor
+					const float att = m_autoAttVal
+						? msToCoeff(2.f * m_compressorControls.m_attackModel.value() / (crestFactorValTemp))
+						: m_attCoeff;
+
+					m_yL[i] = m_yL[i] * att + (1 - att) * t;
+					m_holdTimer[i] = m_holdLength;// Reset hold timer
 				}
-				else
+				else// Release phase
 				{
-					m_yL[i] = m_yL[i] * rel + (1 - rel) * t;
+					float crestFactorValTemp = ((m_crestFactorVal[i] - 2.f) * m_autoRelVal) + 2.f;
+
+					const float rel = m_autoRelVal
+						? msToCoeff(2.f * m_compressorControls.m_releaseModel.value() / (crestFactorValTemp))
+						: m_relCoeff;
+
+					if (m_holdTimer[i])// Don't change peak if hold is being applied
+					{
+						--m_holdTimer[i];
+					}
+					else
+					{
+						m_yL[i] = m_yL[i] * rel + (1 - rel) * t;
+					}
 				}
-			}
 
-			// Keep it above the noise floor
-			m_yL[i] = qMax(COMP_NOISE_FLOOR, m_yL[i]);
-			
-			float scVal = m_yL[i];
-			
-			if (lookahead)
-			{
-				const float temp = scVal;
-				// Lookahead is calculated by picking the largest value between
-				// the current sidechain signal and the delayed sidechain signal.
-				scVal = std::max(m_scLookBuf[i][m_lookWrite], m_scLookBuf[i][(m_lookWrite + m_lookBufLength - m_lookaheadLength) % m_lookBufLength]);
-				m_scLookBuf[i][m_lookWrite] = temp;
-			}
+				// Keep it above the noise floor
+				m_yL[i] = qMax(COMP_NOISE_FLOOR, m_yL[i]);
+				
+				float scVal = m_yL[i];
+				
+				if constexpr (lookahead)
+				{
+					const float temp = scVal;
+					// Lookahead is calculated by picking the largest value between
+					// the current sidechain signal and the delayed sidechain signal.
+					scVal = std::max(m_scLookBuf[i][(m_lookWrite + m_lookBufLength) & m_lookBufMask],
+						m_scLookBuf[i][(m_lookWrite + m_lookBufLength - m_lookaheadLength) & m_lookBufMask]);
+					m_scLookBuf[i][m_lookWrite] = temp;
+				}
 
-			// For the visualizer
-			m_displayPeak[i] = qMax(scVal, m_displayPeak[i]);
+				// For the visualizer
+				m_displayPeak[i] = qMax(scVal, m_displayPeak[i]);
 
-			const float currentPeakDbfs = ampToDbfs(scVal);
+				const float currentPeakDbfs = fastAmpToDbfs(scVal);
 
-			// Now find the gain change that should be applied,
-			// depending on the measured input value.
-			if (currentPeakDbfs - m_thresholdVal < -m_kneeVal)// Below knee
-			{
-				m_gainResult[i] = currentPeakDbfs;
+				// Now find the gain change that should be applied,
+				// depending on the measured input value.
+				if (currentPeakDbfs - m_thresholdVal < -m_kneeVal)// Below knee
+				{
+					m_gainResult[i] = currentPeakDbfs;
+				}
+				else if (currentPeakDbfs - m_thresholdVal < m_kneeVal)// Within knee
+				{
+					const float temp = currentPeakDbfs - m_thresholdVal + m_kneeVal;
+					m_gainResult[i] = currentPeakDbfs + ((limiter ? 0 : m_ratioVal) - 1) * temp * temp / (4 * m_kneeVal);
+				}
+				else// Above knee
+				{
+					m_gainResult[i] = limiter
+						? m_thresholdVal
+						: m_thresholdVal + (currentPeakDbfs - m_thresholdVal) * m_ratioVal;
+				}
+
+				m_gainResult[i] = fastDbfsToAmp(m_gainResult[i]) / scVal;
+				m_gainResult[i] = qMax(m_rangeVal, m_gainResult[i]);
 			}
-			else if (currentPeakDbfs - m_thresholdVal < m_kneeVal)// Within knee
+
+			switch (static_cast<StereoLinkMode>(stereoLink))
 			{
-				const float temp = currentPeakDbfs - m_thresholdVal + m_kneeVal;
-				m_gainResult[i] = currentPeakDbfs + ((limiter ? 0 : m_ratioVal) - 1) * temp * temp / (4 * m_kneeVal);
+				case StereoLinkMode::Unlinked:
+				{
+					break;
+				}
+				case StereoLinkMode::Maximum:
+				{
+					m_gainResult[0] = m_gainResult[1] = qMin(m_gainResult[0], m_gainResult[1]);
+					break;
+				}
+				case StereoLinkMode::Average:
+				{
+					m_gainResult[0] = m_gainResult[1] = (m_gainResult[0] + m_gainResult[1]) * 0.5f;
+					break;
+				}
+				case StereoLinkMode::Minimum:
+				{
+					m_gainResult[0] = m_gainResult[1] = qMax(m_gainResult[0], m_gainResult[1]);
+					break;
+				}
+				case StereoLinkMode::Blend:
+				{
+					if (blend > 0)// 0 is unlinked
+					{
+						if (blend <= 1)// Blend to minimum volume
+						{
+							const float temp1 = qMin(m_gainResult[0], m_gainResult[1]);
+							m_gainResult[0] = linearInterpolate(m_gainResult[0], temp1, blend);
+							m_gainResult[1] = linearInterpolate(m_gainResult[1], temp1, blend);
+						}
+						else if (blend <= 2)// Blend to average volume
+						{
+							const float temp1 = qMin(m_gainResult[0], m_gainResult[1]);
+							const float temp2 = (m_gainResult[0] + m_gainResult[1]) * 0.5f;
+							m_gainResult[0] = linearInterpolate(temp1, temp2, blend - 1);
+							m_gainResult[1] = m_gainResult[0];
+						}
+						else// Blend to maximum volume
+						{
+							const float temp1 = (m_gainResult[0] + m_gainResult[1]) * 0.5f;
+							const float temp2 = qMax(m_gainResult[0], m_gainResult[1]);
+							m_gainResult[0] = linearInterpolate(temp1, temp2, blend - 2);
+							m_gainResult[1] = m_gainResult[0];
+						}
+					}
+					break;
+				}
 			}
-			else// Above knee
+
+			// Bias compression to the left or right (or mid or side)
+			if (stereoBalance != 0)
 			{
-				m_gainResult[i] = limiter
-					? m_thresholdVal
-					: m_thresholdVal + (currentPeakDbfs - m_thresholdVal) * m_ratioVal;
+				m_gainResult[0] = 1 - ((1 - m_gainResult[0]) * (stereoBalance > 0 ? 1 - stereoBalance : 1));
+				m_gainResult[1] = 1 - ((1 - m_gainResult[1]) * (stereoBalance < 0 ? 1 + stereoBalance : 1));
 			}
 
-			m_gainResult[i] = dbfsToAmp(m_gainResult[i]) / scVal;
-			m_gainResult[i] = qMax(m_rangeVal, m_gainResult[i]);
-		}
+			// For visualizer
+			m_displayGain[0] = qMax(m_gainResult[0], m_displayGain[0]);
+			m_displayGain[1] = qMax(m_gainResult[1], m_displayGain[1]);
 
-		switch (static_cast<StereoLinkMode>(stereoLink))
-		{
-			case StereoLinkMode::Unlinked:
-			{
-				break;
-			}
-			case StereoLinkMode::Maximum:
-			{
-				m_gainResult[0] = m_gainResult[1] = qMin(m_gainResult[0], m_gainResult[1]);
-				break;
-			}
-			case StereoLinkMode::Average:
-			{
-				m_gainResult[0] = m_gainResult[1] = (m_gainResult[0] + m_gainResult[1]) * 0.5f;
-				break;
-			}
-			case StereoLinkMode::Minimum:
+			// Delay the signal by m_lookBufLength samples via ring buffer if lookahead is enabled
+			if constexpr (lookahead)
 			{
-				m_gainResult[0] = m_gainResult[1] = qMax(m_gainResult[0], m_gainResult[1]);
-				break;
+				s[0] = m_inLookBuf[0][(m_lookWrite + m_lookBufLength) & m_lookBufMask];
+				s[1] = m_inLookBuf[1][(m_lookWrite + m_lookBufLength) & m_lookBufMask];
+				m_inLookBuf[0][m_lookWrite] = drySignal[0];
+				m_inLookBuf[1][m_lookWrite] = drySignal[1];
 			}
-			case StereoLinkMode::Blend:
+			else
 			{
-				if (blend > 0)// 0 is unlinked
-				{
-					if (blend <= 1)// Blend to minimum volume
-					{
-						const float temp1 = qMin(m_gainResult[0], m_gainResult[1]);
-						m_gainResult[0] = linearInterpolate(m_gainResult[0], temp1, blend);
-						m_gainResult[1] = linearInterpolate(m_gainResult[1], temp1, blend);
-					}
-					else if (blend <= 2)// Blend to average volume
-					{
-						const float temp1 = qMin(m_gainResult[0], m_gainResult[1]);
-						const float temp2 = (m_gainResult[0] + m_gainResult[1]) * 0.5f;
-						m_gainResult[0] = linearInterpolate(temp1, temp2, blend - 1);
-						m_gainResult[1] = m_gainResult[0];
-					}
-					else// Blend to maximum volume
-					{
-						const float temp1 = (m_gainResult[0] + m_gainResult[1]) * 0.5f;
-						const float temp2 = qMax(m_gainResult[0], m_gainResult[1]);
-						m_gainResult[0] = linearInterpolate(temp1, temp2, blend - 2);
-						m_gainResult[1] = m_gainResult[0];
-					}
-				}
-				break;
+				s[0] = drySignal[0];
+				s[1] = drySignal[1];
 			}
-		}
 
-		// Bias compression to the left or right (or mid or side)
-		if (stereoBalance != 0)
-		{
-			m_gainResult[0] = 1 - ((1 - m_gainResult[0]) * (stereoBalance > 0 ? 1 - stereoBalance : 1));
-			m_gainResult[1] = 1 - ((1 - m_gainResult[1]) * (stereoBalance < 0 ? 1 + stereoBalance : 1));
-		}
+			auto delayedDrySignal = std::array{s[0], s[1]};
 
-		// For visualizer
-		m_displayGain[0] = qMax(m_gainResult[0], m_displayGain[0]);
-		m_displayGain[1] = qMax(m_gainResult[1], m_displayGain[1]);
+			if (midside)// Convert left/right to mid/side
+			{
+				const float temp = s[0];
+				s[0] = (temp + s[1]) * 0.5;
+				s[1] = temp - s[1];
+			}
 
-		// Delay the signal by 20 ms via ring buffer if lookahead is enabled
-		if (lookahead)
-		{
-			s[0] = m_inLookBuf[0][m_lookWrite];
-			s[1] = m_inLookBuf[1][m_lookWrite];
-			m_inLookBuf[0][m_lookWrite] = drySignal[0];
-			m_inLookBuf[1][m_lookWrite] = drySignal[1];
-		}
-		else
-		{
-			s[0] = drySignal[0];
-			s[1] = drySignal[1];
-		}
+			s[0] *= inBalance > 0 ? 1 - inBalance : 1;
+			s[1] *= inBalance < 0 ? 1 + inBalance : 1;
 
-		auto delayedDrySignal = std::array{s[0], s[1]};
+			s[0] *= m_gainResult[0] * m_inGainVal * m_outGainVal * (outBalance > 0 ? 1 - outBalance : 1);
+			s[1] *= m_gainResult[1] * m_inGainVal * m_outGainVal * (outBalance < 0 ? 1 + outBalance : 1);
 
-		if (midside)// Convert left/right to mid/side
-		{
-			const float temp = s[0];
-			s[0] = (temp + s[1]) * 0.5;
-			s[1] = temp - s[1];
-		}
+			if (midside)// Convert mid/side back to left/right
+			{
+				const float temp1 = s[0];
+				const float temp2 = s[1] * 0.5;
+				s[0] = temp1 + temp2;
+				s[1] = temp1 - temp2;
+			}
 
-		s[0] *= inBalance > 0 ? 1 - inBalance : 1;
-		s[1] *= inBalance < 0 ? 1 + inBalance : 1;
+			m_prevOut[0] = s[0];
+			m_prevOut[1] = s[1];
 
-		s[0] *= m_gainResult[0] * m_inGainVal * m_outGainVal * (outBalance > 0 ? 1 - outBalance : 1);
-		s[1] *= m_gainResult[1] * m_inGainVal * m_outGainVal * (outBalance < 0 ? 1 + outBalance : 1);
+			// Negate wet signal from dry signal
+			if (audition)
+			{
+				s[0] = (-s[0] + delayedDrySignal[0] * m_outGainVal * m_inGainVal);
+				s[1] = (-s[1] + delayedDrySignal[1] * m_outGainVal * m_inGainVal);
+			}
+			else if (autoMakeup)
+			{
+				s[0] *= m_autoMakeupVal;
+				s[1] *= m_autoMakeupVal;
+			}
 
-		if (midside)// Convert mid/side back to left/right
-		{
-			const float temp1 = s[0];
-			const float temp2 = s[1] * 0.5;
-			s[0] = temp1 + temp2;
-			s[1] = temp1 - temp2;
-		}
+			// Calculate wet/dry value results
+			const float temp1 = delayedDrySignal[0];
+			const float temp2 = delayedDrySignal[1];
+			buf[f][0] = d * temp1 + w * s[0];
+			buf[f][1] = d * temp2 + w * s[1];
+			buf[f][0] = (1 - m_mixVal) * temp1 + m_mixVal * buf[f][0];
+			buf[f][1] = (1 - m_mixVal) * temp2 + m_mixVal * buf[f][1];
 
-		m_prevOut[0] = s[0];
-		m_prevOut[1] = s[1];
+			outSum += buf[f][0] * buf[f][0] + buf[f][1] * buf[f][1];
+			
+			m_lookWrite = (m_lookWrite - 1) & m_lookBufMask;
 
-		// Negate wet signal from dry signal
-		if (audition)
-		{
-			s[0] = (-s[0] + delayedDrySignal[0] * m_outGainVal * m_inGainVal);
-			s[1] = (-s[1] + delayedDrySignal[1] * m_outGainVal * m_inGainVal);
-		}
-		else if (autoMakeup)
-		{
-			s[0] *= m_autoMakeupVal;
-			s[1] *= m_autoMakeupVal;
+			lInPeak = drySignal[0] > lInPeak ? drySignal[0] : lInPeak;
+			rInPeak = drySignal[1] > rInPeak ? drySignal[1] : rInPeak;
+			lOutPeak = s[0] > lOutPeak ? s[0] : lOutPeak;
+			rOutPeak = s[1] > rOutPeak ? s[1] : rOutPeak;
 		}
+	};
 
-		// Calculate wet/dry value results
-		const float temp1 = delayedDrySignal[0];
-		const float temp2 = delayedDrySignal[1];
-		buf[f][0] = d * temp1 + w * s[0];
-		buf[f][1] = d * temp2 + w * s[1];
-		buf[f][0] = (1 - m_mixVal) * temp1 + m_mixVal * buf[f][0];
-		buf[f][1] = (1 - m_mixVal) * temp2 + m_mixVal * buf[f][1];
-
-		outSum += buf[f][0] * buf[f][0] + buf[f][1] * buf[f][1];
-		
-		if (--m_lookWrite < 0) { m_lookWrite = m_lookBufLength - 1; }
-
-		lInPeak = drySignal[0] > lInPeak ? drySignal[0] : lInPeak;
-		rInPeak = drySignal[1] > rInPeak ? drySignal[1] : rInPeak;
-		lOutPeak = s[0] > lOutPeak ? s[0] : lOutPeak;
-		rOutPeak = s[1] > rOutPeak ? s[1] : rOutPeak;
-	}
+	// feedback isn't available with lookahead
+	if (lookaheadEnabled) { processFrames(std::true_type{}, std::false_type{}); }
+	else if (feedbackEnabled) { processFrames(std::false_type{}, std::true_type{}); }
+	else { processFrames(std::false_type{}, std::false_type{}); }
 
 	checkGate(outSum / frames);
 	m_compressorControls.m_outPeakL = lOutPeak;
@@ -567,11 +583,16 @@ void CompressorEffect::changeSampleRate()
 	// 200 ms
 	m_crestTimeConst = exp(-1.f / (0.2f * m_sampleRate));
 
+	// The signal is delayed by m_lookBufLength samples. The ring buffers are a power
+	// of two long, so that they can be indexed with a mask.
 	m_lookBufLength = std::ceil((20.f / 1000.f) * m_sampleRate) + 2;
+	int lookBufCapacity = 1;
+	while (lookBufCapacity < m_lookBufLength) { lookBufCapacity *= 2; }
+	m_lookBufMask = lookBufCapacity - 1;
 	for (int i = 0; i < 2; ++i)
 	{
-		m_inLookBuf[i].resize(m_lookBufLength);
-		m_scLookBuf[i].resize(m_lookBufLength, COMP_NOISE_FLOOR);
+		m_inLookBuf[i].resize(lookBufCapacity);
+		m_scLookBuf[i].resize(lookBufCapacity, COMP_NOISE_FLOOR);
 	}
 	m_lookWrite = 0;
 
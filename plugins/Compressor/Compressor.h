@@ -85,6 +85,7 @@ private:
 	std::array<std::vector<float>, 2> m_scLookBuf;
 	int m_lookWrite;
 	int m_lookBufLength;
+	int m_lookBufMask;
 
 	float m_attCoeff;
 	float m_relCoeff;
@@ -24,6 +24,8 @@
 
 #include "Dispersion.h"
 
+#include <algorithm>
+
 #include "embed.h"
 #include "plugin_export.h"
 
@@ -55,6 +57,13 @@ DispersionEffect::DispersionEffect(Model* parent, const Descriptor::SubPluginFea
 	m_sampleRate(Engine::audioEngine()->processingSampleRate()),
 	m_amountVal(0)
 {
+	m_work = MM_ALLOC<sampleFrame>(Engine::audioEngine()->framesPerPeriod());
+}
+
+
+DispersionEffect::~DispersionEffect()
+{
+	MM_FREE(m_work);
 }
 
 
@@ -75,11 +84,10 @@ bool DispersionEffect::processAudioBuffer(sampleFrame* buf, const fpp_t frames)
 	float feedback = m_dispersionControls.m_feedbackModel.value();
 	const bool dc = m_dispersionControls.m_dcModel.value();
 	
-	// All-pass coefficient calculation
-	const float w0 = (F_2PI / m_sampleRate) * freq;
-	const float a0 = 1 + (std::sin(w0) / (reso * 2.f));
-	float apCoeff1 = (1 - (a0 - 1)) / a0;
-	float apCoeff2 = (-2 * std::cos(w0)) / a0;
+	if (freq != m_freqVal || reso != m_resoVal)
+	{
+		calcCoeffs(freq, reso);
+	}
 	
 	float dcCoeff = 0.001 * (44100.f / m_sampleRate);
 	
@@ -88,10 +96,7 @@ bool DispersionEffect::processAudioBuffer(sampleFrame* buf, const fpp_t frames)
 		if (amount < m_amountVal)
 		{
 			// Flush filter buffers when they're no longer in use
-			for (int i = amount * 2; i < m_amountVal * 2; ++i)
-			{
-				m_state.x0[i] = m_state.x1[i] = m_state.y0[i] = m_state.y1[i] = 0;
-			}
+			std::fill(m_state.begin() + amount, m_state.begin() + m_amountVal, FilterState{});
 		}
 		m_amountVal = amount;
 	}
@@ -102,13 +107,35 @@ bool DispersionEffect::processAudioBuffer(sampleFrame* buf, const fpp_t frames)
 		m_feedbackVal[0] = m_feedbackVal[1] = 0;
 	}
 
-	for (fpp_t f = 0; f < frames; ++f)
+	if (feedback != 0)
+	{
+		// The output of the last filter feeds the first one, so all filters have to be run for each frame
+		for (fpp_t f = 0; f < frames; ++f)
+		{
+			std::array<sample_t, 2> s = { buf[f][0] + m_feedbackVal[0], buf[f][1] + m_feedbackVal[1] };
+			
+			runDispersionAP(m_amountVal, m_apCoeff1, m_apCoeff2, s);
+			m_feedbackVal[0] = s[0] * feedback;
+			m_feedbackVal[1] = s[1] * feedback;
+			
+			m_work[f] = s;
+		}
+	}
+	else
 	{
-		std::array<sample_t, 2> s = { buf[f][0] + m_feedbackVal[0], buf[f][1] + m_feedbackVal[1] };
+		// Without feedback each filter can run over the whole period before the next one,
+		// which keeps its state in registers. Only the first frame gets the remaining feedback.
+		std::copy(buf, buf + frames, m_work);
+		m_work[0][0] += m_feedbackVal[0];
+		m_work[0][1] += m_feedbackVal[1];
+		m_feedbackVal[0] = m_feedbackVal[1] = 0;
 		
-		runDispersionAP(m_amountVal, apCoeff1, apCoeff2, s);
-		m_feedbackVal[0] = s[0] * feedback;
-		m_feedbackVal[1] = s[1] * feedback;
+		runDispersionAPBlock(m_amountVal, m_apCoeff1, m_apCoeff2, m_work, frames);
+	}
+
+	for (fpp_t f = 0; f < frames; ++f)
+	{
+		std::array<sample_t, 2> s = m_work[f];
 		
 		if (dc)
 		{
@@ -130,20 +157,65 @@ bool DispersionEffect::processAudioBuffer(sampleFrame* buf, const fpp_t frames)
 }
 
 
+void DispersionEffect::calcCoeffs(float freq, float reso)
+{
+	// All-pass coefficient calculation
+	const float w0 = (F_2PI / m_sampleRate) * freq;
+	const float a0 = 1 + (std::sin(w0) / (reso * 2.f));
+	m_apCoeff1 = (1 - (a0 - 1)) / a0;
+	m_apCoeff2 = (-2 * std::cos(w0)) / a0;
+	m_freqVal = freq;
+	m_resoVal = reso;
+}
+
+
 void DispersionEffect::runDispersionAP(const int filtNum, const float apCoeff1, const float apCoeff2, std::array<sample_t, 2> &put)
 {
-	for (int i = 0; i < filtNum * 2; ++i)
+	for (int i = 0; i < filtNum; ++i)
+	{
+		FilterState& state = m_state[i];
+		// both channels are independent, the compiler can compute them side by side
+		for (int channel = 0; channel < 2; ++channel)
+		{
+			const sample_t currentInput = put[channel];
+			const sample_t filterOutput = apCoeff1 * (currentInput - state.y1[channel])
+				+ apCoeff2 * (state.x0[channel] - state.y0[channel]) + state.x1[channel];
+			state.x1[channel] = state.x0[channel];
+			state.x0[channel] = currentInput;
+			state.y1[channel] = state.y0[channel];
+			state.y0[channel] = filterOutput;
+
+			put[channel] = filterOutput;
+		}
+	}
+}
+
+
+void DispersionEffect::runDispersionAPBlock(const int filtNum, const float apCoeff1, const float apCoeff2, sampleFrame* buf, const fpp_t frames)
+{
+	for (int i = 0; i < filtNum; ++i)
 	{
-		const int channel = i % 2;
-		const sample_t currentInput = put[channel];
-		const sample_t filterOutput = apCoeff1 * (currentInput - m_state.y1[i])
-			+ apCoeff2 * (m_state.x0[i] - m_state.y0[i]) + m_state.x1[i];
-		m_state.x1[i] = m_state.x0[i];
-		m_state.x0[i] = currentInput;
-		m_state.y1[i] = m_state.y0[i];
-		m_state.y0[i] = filterOutput;
-
-		put[channel] = filterOutput;
+		FilterState& state = m_state[i];
+		auto x0 = state.x0, x1 = state.x1, y0 = state.y0, y1 = state.y1;
+		for (fpp_t f = 0; f < frames; ++f)
+		{
+			for (int channel = 0; channel < 2; ++channel)
+			{
+				const sample_t currentInput = buf[f][channel];
+				const sample_t filterOutput = apCoeff1 * (currentInput - y1[channel])
+					+ apCoeff2 * (x0[channel] - y0[channel]) + x1[channel];
+				x1[channel] = x0[channel];
+				x0[channel] = currentInput;
+				y1[channel] = y0[channel];
+				y0[channel] = filterOutput;
+
+				buf[f][channel] = filterOutput;
+			}
+		}
+		state.x0 = x0;
+		state.x1 = x1;
+		state.y0 = y0;
+		state.y1 = y1;
 	}
 }
 
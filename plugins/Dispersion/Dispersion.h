@@ -40,7 +40,7 @@ class DispersionEffect : public Effect
 {
 public:
 	DispersionEffect(Model* parent, const Descriptor::SubPluginFeatures::Key* key);
-	~DispersionEffect() override = default;
+	~DispersionEffect() override;
 	bool processAudioBuffer(sampleFrame* buf, const fpp_t frames) override;
 
 	EffectControls* controls() override
@@ -49,22 +49,32 @@ public:
 	}
 	
 	void runDispersionAP(const int filtNum, const float apCoeff1, const float apCoeff2, std::array<sample_t, 2> &put);
+	void runDispersionAPBlock(const int filtNum, const float apCoeff1, const float apCoeff2, sampleFrame* buf, const fpp_t frames);
 
 private:
+	void calcCoeffs(float freq, float reso);
+
 	DispersionControls m_dispersionControls;
 	
 	float m_sampleRate;
 	
 	int m_amountVal;
 	
-	using Filter = std::array<sample_t, MAX_DISPERSION_FILTERS * 2>;
+	// the state of one all-pass filter for both channels, so that they can be computed together
 	struct FilterState {
-		Filter x0{};
-		Filter x1{};
-		Filter y0{};
-		Filter y1{};
+		std::array<sample_t, 2> x0{};
+		std::array<sample_t, 2> x1{};
+		std::array<sample_t, 2> y0{};
+		std::array<sample_t, 2> y1{};
 	};
-	FilterState m_state = {};
+	std::array<FilterState, MAX_DISPERSION_FILTERS> m_state = {};
+	
+	float m_freqVal = -1;
+	float m_resoVal = -1;
+	float m_apCoeff1 = 0;
+	float m_apCoeff2 = 0;
+	
+	sampleFrame* m_work;
 	
 	std::array<float, 2> m_feedbackVal{};
 	std::array<float, 2> m_integrator{};
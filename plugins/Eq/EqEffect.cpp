@@ -24,6 +24,8 @@
 
 #include "EqEffect.h"
 
+#include <algorithm>
+
 #include "Engine.h"
 #include "lmms_math.h"
 
@@ -59,6 +61,15 @@ EqEffect::EqEffect( Model *parent, const Plugin::Descriptor::SubPluginFeatures::
 	m_inGain( 1.0 ),
 	m_outGain( 1.0 )
 {
+	m_dryBuf = MM_ALLOC<sampleFrame>( Engine::audioEngine()->framesPerPeriod() );
+}
+
+
+
+
+EqEffect::~EqEffect()
+{
+	MM_FREE( m_dryBuf );
 }
 
 
@@ -71,7 +82,6 @@ bool EqEffect::processAudioBuffer( sampleFrame *buf, const fpp_t frames )
 	//wet/dry controls
 	const float dry = dryLevel();
 	const float wet = wetLevel();
-	auto dryS = std::array<sample_t, 2>{};
 	// setup sample exact controls
 	float hpRes = m_eqControls.m_hpResModel.value();
 	float lowShelfRes = m_eqControls.m_lowShelfResModel.value();
@@ -112,8 +122,8 @@ bool EqEffect::processAudioBuffer( sampleFrame *buf, const fpp_t frames )
 	float para4Gain = m_eqControls.m_para4GainModel.value();
 	float highShelfGain = m_eqControls.m_highShelfGainModel.value();
 
-	//set all filter parameters once per frame, EqFilter handles
-	//smooth xfading, reducing pops clicks and dc bias offsets
+	//set all filter parameters once per period, EqFilter handles
+	//smooth coefficent changes, reducing pops clicks and dc bias offsets
 
 	m_hp12.setParameters( sampleRate, hpFreq, hpRes, 1 );
 	m_hp24.setParameters( sampleRate, hpFreq, hpRes, 1 );
@@ -172,95 +182,56 @@ bool EqEffect::processAudioBuffer( sampleFrame *buf, const fpp_t frames )
 	m_eqControls.m_inPeakL = m_eqControls.m_inPeakL < m_inPeak[0] ? m_inPeak[0] : m_eqControls.m_inPeakL;
 	m_eqControls.m_inPeakR = m_eqControls.m_inPeakR < m_inPeak[1] ? m_inPeak[1] : m_eqControls.m_inPeakR;
 
-	float periodProgress = 0.0f; // percentage of period processed
-	for( fpp_t f = 0; f < frames; ++f)
+	// keep the dry signal for the wet/dry mix
+	std::copy( buf, buf + frames, m_dryBuf );
+
+	// each active band filters the whole period before the next one, this
+	// keeps the filter state in registers and lets the compiler unroll the
+	// stereo biquad instead of going through the bands for each frame
+	if( hpActive )
 	{
-		periodProgress = (float)f / (float)(frames-1);
-		//wet dry buffer
-		dryS[0] = buf[f][0];
-		dryS[1] = buf[f][1];
-		if( hpActive )
-		{
-			buf[f][0] = m_hp12.update( buf[f][0], 0, periodProgress );
-			buf[f][1] = m_hp12.update( buf[f][1], 1, periodProgress );
-
-			if( hp24Active || hp48Active )
-			{
-				buf[f][0] = m_hp24.update( buf[f][0], 0, periodProgress );
-				buf[f][1] = m_hp24.update( buf[f][1], 1, periodProgress );
-			}
-
-			if( hp48Active )
-			{
-				buf[f][0] = m_hp480.update( buf[f][0], 0, periodProgress );
-				buf[f][1] = m_hp480.update( buf[f][1], 1, periodProgress );
-
-				buf[f][0] = m_hp481.update( buf[f][0], 0, periodProgress );
-				buf[f][1] = m_hp481.update( buf[f][1], 1, periodProgress );
-			}
-		}
+		m_hp12.processBuffer( buf, frames );
 
-		if( lowShelfActive )
+		if( hp24Active || hp48Active )
 		{
-			buf[f][0] = m_lowShelf.update( buf[f][0], 0, periodProgress );
-			buf[f][1] = m_lowShelf.update( buf[f][1], 1, periodProgress );
+			m_hp24.processBuffer( buf, frames );
 		}
 
-		if( para1Active )
+		if( hp48Active )
 		{
-			buf[f][0] = m_para1.update( buf[f][0], 0, periodProgress );
-			buf[f][1] = m_para1.update( buf[f][1], 1, periodProgress );
+			m_hp480.processBuffer( buf, frames );
+			m_hp481.processBuffer( buf, frames );
 		}
+	}
 
-		if( para2Active )
-		{
-			buf[f][0] = m_para2.update( buf[f][0], 0, periodProgress );
-			buf[f][1] = m_para2.update( buf[f][1], 1, periodProgress );
-		}
+	if( lowShelfActive ) { m_lowShelf.processBuffer( buf, frames ); }
+	if( para1Active ) { m_para1.processBuffer( buf, frames ); }
+	if( para2Active ) { m_para2.processBuffer( buf, frames ); }
+	if( para3Active ) { m_para3.processBuffer( buf, frames ); }
+	if( para4Active ) { m_para4.processBuffer( buf, frames ); }
+	if( highShelfActive ) { m_highShelf.processBuffer( buf, frames ); }
 
-		if( para3Active )
-		{
-			buf[f][0] = m_para3.update( buf[f][0], 0, periodProgress );
-			buf[f][1] = m_para3.update( buf[f][1], 1, periodProgress );
-		}
+	if( lpActive )
+	{
+		m_lp12.processBuffer( buf, frames );
 
-		if( para4Active )
+		if( lp24Active || lp48Active )
 		{
-			buf[f][0] = m_para4.update( buf[f][0], 0, periodProgress );
-			buf[f][1] = m_para4.update( buf[f][1], 1, periodProgress );
+			m_lp24.processBuffer( buf, frames );
 		}
 
-		if( highShelfActive )
+		if( lp48Active )
 		{
-			buf[f][0] = m_highShelf.update( buf[f][0], 0, periodProgress );
-			buf[f][1] = m_highShelf.update( buf[f][1], 1, periodProgress );
+			m_lp480.processBuffer( buf, frames );
+			m_lp481.processBuffer( buf, frames );
 		}
+	}
 
-		if( lpActive ){
-			buf[f][0] = m_lp12.update( buf[f][0], 0, periodProgress );
-			buf[f][1] = m_lp12.update( buf[f][1], 1, periodProgress );
-
-			if( lp24Active || lp48Active )
-			{
-				buf[f][0] = m_lp24.update( buf[f][0], 0, periodProgress );
-				buf[f][1] = m_lp24.update( buf[f][1], 1, periodProgress );
-			}
-
-			if( lp48Active )
-			{
-				buf[f][0] = m_lp480.update( buf[f][0], 0, periodProgress );
-				buf[f][1] = m_lp480.update( buf[f][1], 1, periodProgress );
-
-				buf[f][0] = m_lp481.update( buf[f][0], 0, periodProgress );
-				buf[f][1] = m_lp481.update( buf[f][1], 1, periodProgress );
-			}
-		}
-
-		//apply wet / dry levels
-		buf[f][1] = ( dry * dryS[1] ) + ( wet * buf[f][1] );
-		buf[f][0] = ( dry * dryS[0] ) + ( wet * buf[f][0] );
-
-
+	//apply wet / dry levels
+	for( fpp_t f = 0; f < frames; ++f )
+	{
+		buf[f][0] = ( dry * m_dryBuf[f][0] ) + ( wet * buf[f][0] );
+		buf[f][1] = ( dry * m_dryBuf[f][1] ) + ( wet * buf[f][1] );
 	}
 
 	sampleFrame outPeak = { 0, 0 };
@@ -36,7 +36,7 @@ class EqEffect : public Effect
 {
 public:
 	EqEffect( Model * parent , const Descriptor::SubPluginFeatures::Key * key );
-	~EqEffect() override = default;
+	~EqEffect() override;
 	bool processAudioBuffer( sampleFrame * buf, const fpp_t frames ) override;
 	EffectControls * controls() override
 	{
@@ -87,6 +87,8 @@ private:
 	float m_inGain;
 	float m_outGain;
 
+	sampleFrame* m_dryBuf;
+
 	float peakBand( float minF, float maxF, EqAnalyser *, int );
 
 	inline float bandToFreq ( int index , int sampleRate )
@@ -25,6 +25,8 @@
 #ifndef EQFILTER_H
 #define EQFILTER_H
 
+#include <array>
+
 #include "BasicFilters.h"
 #include "lmms_math.h"
 
@@ -34,8 +36,8 @@ namespace lmms
 
 ///
 /// \brief The EqFilter class.
-/// A wrapper for the StereoBiQuad class, giving it freq, res, and gain controls.
-/// Used on a per channel per frame basis with recalculation of coefficents
+/// A stereo biquad filter with freq, res, and gain controls.
+/// Used on a per period basis with recalculation of coefficents
 /// upon parameter changes. The intention is to use this as a bass class, children override
 /// the calcCoefficents() function, providing the coefficents a1, a2, b0, b1, b2.
 ///
@@ -47,9 +49,10 @@ public:
 		m_freq(0),
 		m_res(0),
 		m_gain(0),
-		m_bw(0)
+		m_bw(0),
+		m_hasCoeffs(false)
 	{
-
+		clearHistory();
 	}
 
 
@@ -119,26 +122,56 @@ public:
 
 
 	///
-	/// \brief update
-	/// filters using two BiQuads, then crossfades,
-	///  depending on on percentage of period processes
-	/// \param in
-	/// \param ch
-	/// \param frameProgress percentage of frame processed
-	/// \return
+	/// \brief processBuffer
+	/// filters both channels of the buffer in place. To avoid zipper noise
+	/// on parameter changes, the coefficents glide from the previous ones to
+	/// the new ones over the period. A biquad is stable for all a1, a2 within
+	/// a triangle, so the interpolated coefficents are stable when both ends are.
+	/// \param buf
+	/// \param frames
 	///
-	inline float update( float in, ch_cnt_t ch, float frameProgress)
+	void processBuffer( sampleFrame* buf, const fpp_t frames )
 	{
-		float initailF =  m_biQuadFrameInitial.update( in, ch );
-		float targetF = m_biQuadFrameTarget.update( in, ch );
-
-		if(frameProgress > 0.99999 )
+		Coeffs c = m_coeffs;
+		Coeffs step = {};
+		const bool gliding = frames > 1 && c != m_targetCoeffs;
+		if( gliding )
 		{
-			m_biQuadFrameInitial= m_biQuadFrameTarget;
+			const float scale = 1.0f / ( frames - 1 );
+			for( std::size_t i = 0; i < c.size(); ++i )
+			{
+				step[i] = ( m_targetCoeffs[i] - c[i] ) * scale;
+			}
 		}
 
-		return (1.0f-frameProgress) * initailF + frameProgress * targetF;
+		float z1l = m_z1[0], z2l = m_z2[0];
+		float z1r = m_z1[1], z2r = m_z2[1];
+		for( fpp_t f = 0; f < frames; ++f )
+		{
+			const float a1 = c[A1], a2 = c[A2], b0 = c[B0], b1 = c[B1], b2 = c[B2];
+
+			// biquad filter in transposed form, as in BiQuad::update()
+			const float inL = buf[f][0];
+			const float outL = z1l + b0 * inL;
+			z1l = b1 * inL + z2l - a1 * outL;
+			z2l = b2 * inL - a2 * outL;
+			buf[f][0] = outL;
+
+			const float inR = buf[f][1];
+			const float outR = z1r + b0 * inR;
+			z1r = b1 * inR + z2r - a1 * outR;
+			z2r = b2 * inR - a2 * outR;
+			buf[f][1] = outR;
+
+			if( gliding )
+			{
+				for( std::size_t i = 0; i < c.size(); ++i ) { c[i] += step[i]; }
+			}
+		}
+		m_z1[0] = z1l; m_z2[0] = z2l;
+		m_z1[1] = z1r; m_z2[1] = z2r;
 
+		m_coeffs = m_targetCoeffs;
 	}
 
 
@@ -154,7 +187,19 @@ protected:
 
 	inline void setCoeffs( float a1, float a2, float b0, float b1, float b2 )
 	{
-		m_biQuadFrameTarget.setCoeffs( a1, a2, b0, b1, b2 );
+		m_targetCoeffs = { a1, a2, b0, b1, b2 };
+		// there's nothing to glide from before the first period
+		if( !m_hasCoeffs )
+		{
+			m_coeffs = m_targetCoeffs;
+			m_hasCoeffs = true;
+		}
+	}
+
+	inline void clearHistory()
+	{
+		m_z1.fill( 0.0f );
+		m_z2.fill( 0.0f );
 	}
 
 
@@ -167,8 +212,16 @@ protected:
 	float m_res;
 	float m_gain;
 	float m_bw;
-	StereoBiQuad m_biQuadFrameInitial;
-	StereoBiQuad m_biQuadFrameTarget;
+
+private:
+	enum { A1, A2, B0, B1, B2 };
+	using Coeffs = std::array<float, 5>;
+
+	Coeffs m_coeffs = {};        // used at the start of the next period
+	Coeffs m_targetCoeffs = {};  // reached at the end of the next period
+	bool m_hasCoeffs;
+	std::array<float, 2> m_z1;
+	std::array<float, 2> m_z2;
 };
 
 
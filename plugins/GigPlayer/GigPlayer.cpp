@@ -89,6 +89,8 @@ GigInstrument::GigInstrument( InstrumentTrack * _instrument_track ) :
 	m_patchNum( 0, 0, 127, this, tr( "Patch" ) ),
 	m_gain( 1.0f, 0.0f, 5.0f, 0.01f, this, tr( "Gain" ) ),
 	m_interpolation( SRC_LINEAR ),
+	m_streamer( GigStreamer::acquire() ),
+	m_underruns( 0 ),
 	m_RandomSeed( 0 ),
 	m_currentKeyDimension( 0 )
 {
@@ -111,6 +113,7 @@ GigInstrument::~GigInstrument()
 				PlayHandle::Type::NotePlayHandle
 				| PlayHandle::Type::InstrumentPlayHandle );
 	freeInstance();
+	GigStreamer::release();
 }
 
 
@@ -184,19 +187,39 @@ QString GigInstrument::nodeName() const
 
 void GigInstrument::freeInstance()
 {
-	QMutexLocker synthLock( &m_synthMutex );
-	QMutexLocker notesLock( &m_notesMutex );
+	GigInstance * instance = nullptr;
 
-	if( m_instance != nullptr )
 	{
-		delete m_instance;
-		m_instance = nullptr;
+		QMutexLocker synthLock( &m_synthMutex );
+		QMutexLocker notesLock( &m_notesMutex );
 
 		// If we're changing instruments, we got to make sure that we
 		// remove all pointers to the old samples and don't try accessing
 		// that instrument again
 		m_instrument = nullptr;
 		m_notes.clear();
+
+		instance = m_instance;
+		m_instance = nullptr;
+	}
+
+	if( instance != nullptr )
+	{
+		// The disk thread may still be reading for the notes we just
+		// removed, so wait for it before closing the file. Their streams
+		// are released, so it won't start another read from this file.
+		{
+			QMutexLocker diskLock( instance->diskMutex.get() );
+		}
+		delete instance;
+	}
+
+	const int underruns = m_underruns.exchange( 0 );
+
+	if( underruns > 0 )
+	{
+		qWarning( "GigInstrument: sample data wasn't read from disk in time "
+				"%d times while playing %s", underruns, qPrintable( m_filename ) );
 	}
 }
 
@@ -210,12 +233,27 @@ void GigInstrument::openFile( const QString & _gigFile, bool updateTrackName )
 	// Remove the current instrument if one is selected
 	freeInstance();
 
+	const QString absolutePath = PathUtil::toAbsolute( _gigFile );
+
+	std::future<GigInstance*> prefetchedInstance;
+	{
+		QMutexLocker prefetchLock( &s_prefetchedInstancesMutex );
+		const auto it = s_prefetchedInstances.find( absolutePath );
+		if( it != s_prefetchedInstances.end() )
+		{
+			prefetchedInstance = std::move( it->second );
+			s_prefetchedInstances.erase( it );
+		}
+	}
+	// Wait for the file if prefetchInstance() is still opening it
+	GigInstance * prefetched = prefetchedInstance.valid() ? prefetchedInstance.get() : nullptr;
+
 	{
 		QMutexLocker locker( &m_synthMutex );
 
 		try
 		{
-			m_instance = new GigInstance( PathUtil::toAbsolute( _gigFile ) );
+			m_instance = prefetched != nullptr ? prefetched : new GigInstance( absolutePath );
 			m_filename = PathUtil::toShortestRelative( _gigFile );
 		}
 		catch( ... )
@@ -237,6 +275,63 @@ void GigInstrument::openFile( const QString & _gigFile, bool updateTrackName )
 
 
 
+void GigInstrument::prefetchInstance( const QDomElement & _this )
+{
+	const QString absolutePath = PathUtil::toAbsolute( _this.attribute( "src" ) );
+	if( absolutePath.isEmpty() )
+	{
+		return;
+	}
+
+	// Automated or controlled models aren't saved as attributes, the file
+	// is only opened then
+	bool hasPatch = false;
+	const int bank = _this.attribute( "bank" ).toInt( &hasPatch );
+	const int patch = hasPatch ? _this.attribute( "patch" ).toInt( &hasPatch ) : 0;
+
+	auto instance = std::async( std::launch::async, [absolutePath, hasPatch, bank, patch]() -> GigInstance*
+	{
+		GigInstance * instance = nullptr;
+		try
+		{
+			instance = new GigInstance( absolutePath );
+		}
+		catch( ... )
+		{
+			return nullptr;
+		}
+
+		if( hasPatch )
+		{
+			preloadSamples( instance, findInstrument( instance, bank, patch ) );
+		}
+		return instance;
+	} );
+
+	QMutexLocker locker( &s_prefetchedInstancesMutex );
+	s_prefetchedInstances.emplace( absolutePath, std::move( instance ) );
+}
+
+
+
+
+void GigInstrument::dropPrefetchedInstances()
+{
+	std::multimap<QString, std::future<GigInstance*>> prefetched;
+	{
+		QMutexLocker locker( &s_prefetchedInstancesMutex );
+		prefetched.swap( s_prefetchedInstances );
+	}
+
+	for( auto& instance : prefetched )
+	{
+		delete instance.second.get();
+	}
+}
+
+
+
+
 void GigInstrument::updatePatch()
 {
 	if( m_bankNum.value() >= 0 && m_patchNum.value() >= 0 )
@@ -380,7 +475,7 @@ void GigInstrument::play( sampleFrame * _working_buffer )
 			// notes, or if a release sample, then if we've reached
 			// the end of the sample
 			if( sample->sample == nullptr || sample->adsr.done() ||
-				( it->isRelease == true &&
+				( it->isRelease == true && sample->loop.enabled == false &&
 				  sample->pos >= sample->sample->SamplesTotal - 1 ) )
 			{
 				sample = it->samples.erase( sample );
@@ -482,6 +577,8 @@ void GigInstrument::play( sampleFrame * _working_buffer )
 			// Update note position with how many samples we actually used
 			sample.pos += used;
 			sample.adsr.inc(used);
+
+			if (sample.stream != nullptr) { sample.stream->consume(sample.pos); }
 		}
 	}
 
@@ -499,169 +596,256 @@ void GigInstrument::play( sampleFrame * _working_buffer )
 
 
 
-void GigInstrument::loadSample( GigSample& sample, sampleFrame* sampleData, f_cnt_t samples )
+// Convert frames of 16 or 24 bit sample data into 32-bit float, in reverse
+// order if the frames are played backwards
+static void convertFrames( const gig::Sample * pSample, const int8_t * data,
+		sampleFrame * sampleData, f_cnt_t frames, bool backwards )
 {
-	if( sampleData == nullptr || samples < 1 )
+	if( pSample->BitDepth == 24 ) // 24 bit
 	{
-		return;
-	}
-
-	// Determine if we need to loop part of this sample
-	bool loop = false;
-	gig::loop_type_t loopType = gig::loop_type_normal;
-	f_cnt_t loopStart = 0;
-	f_cnt_t loopLength = 0;
+		auto pInt = reinterpret_cast<const uint8_t*>( data );
 
-	if( sample.region->pSampleLoops != nullptr )
-	{
-		for( uint32_t i = 0; i < sample.region->SampleLoops; ++i )
+		for( f_cnt_t i = 0; i < frames; ++i )
 		{
-			loop = true;
-			loopType = static_cast<gig::loop_type_t>( sample.region->pSampleLoops[i].LoopType );
-			loopStart = sample.region->pSampleLoops[i].LoopStart;
-			loopLength = sample.region->pSampleLoops[i].LoopLength;
-
-			// Currently only support at max one loop
-			break;
-		}
-	}
+			const f_cnt_t frame = backwards ? frames - 1 - i : i;
 
-	unsigned long allocationsize = samples * sample.sample->FrameSize;
-	int8_t buffer[allocationsize];
+			// libgig gives 24-bit data as little endian, so we must
+			// convert if on a big endian system
+			int32_t valueLeft = swap32IfBE(
+						( pInt[ 3 * pSample->Channels * frame ] << 8 ) |
+						( pInt[ 3 * pSample->Channels * frame + 1 ] << 16 ) |
+						( pInt[ 3 * pSample->Channels * frame + 2 ] << 24 ) );
 
-	// Load the sample in different ways depending on if we're looping or not
-	if( loop == true && ( sample.pos >= loopStart || sample.pos + samples > loopStart ) )
-	{
-		// Calculate the new position based on the type of loop
-		if( loopType == gig::loop_type_bidirectional )
-		{
-			sample.pos = getPingPongIndex( sample.pos, loopStart, loopStart + loopLength );
-		}
-		else
-		{
-			sample.pos = getLoopedIndex( sample.pos, loopStart, loopStart + loopLength );
-			// TODO: also implement loop_type_backward support
-		}
+			sampleData[i][0] = 1.0 / 0x100000000 * valueLeft;
 
-		sample.sample->SetPos( sample.pos );
+			if( pSample->Channels == 1 )
+			{
+				sampleData[i][1] = sampleData[i][0];
+			}
+			else
+			{
+				int32_t valueRight = swap32IfBE(
+							( pInt[ 3 * pSample->Channels * frame + 3 ] << 8 ) |
+							( pInt[ 3 * pSample->Channels * frame + 4 ] << 16 ) |
+							( pInt[ 3 * pSample->Channels * frame + 5 ] << 24 ) );
 
-		// Load the samples (based on gig::Sample::ReadAndLoop) even around the end
-		// of a loop boundary wrapping to the beginning of the loop region
-		long samplestoread = samples;
-		long samplestoloopend = 0;
-		long readsamples = 0;
-		long totalreadsamples = 0;
-		long loopEnd = loopStart + loopLength;
+				sampleData[i][1] = 1.0 / 0x100000000 * valueRight;
+			}
+		}
+	}
+	else // 16 bit
+	{
+		auto pInt = reinterpret_cast<const int16_t*>( data );
 
-		do
+		for( f_cnt_t i = 0; i < frames; ++i )
 		{
-			samplestoloopend = loopEnd - sample.sample->GetPos();
-			readsamples = sample.sample->Read( &buffer[totalreadsamples * sample.sample->FrameSize],
-					std::min( samplestoread, samplestoloopend ) );
-			samplestoread -= readsamples;
-			totalreadsamples += readsamples;
+			const f_cnt_t frame = backwards ? frames - 1 - i : i;
+
+			sampleData[i][0] = 1.0 / 0x10000 * pInt[ pSample->Channels * frame ];
 
-			if( readsamples >= samplestoloopend )
+			if( pSample->Channels == 1 )
+			{
+				sampleData[i][1] = sampleData[i][0];
+			}
+			else
 			{
-				sample.sample->SetPos( loopStart );
+				sampleData[i][1] = 1.0 / 0x10000 * pInt[ pSample->Channels * frame + 1 ];
 			}
 		}
-		while( samplestoread > 0 && readsamples > 0 );
 	}
-	else
+}
+
+
+
+
+// Nothing in here reads from disk. The beginning of the sample is in memory
+// and the disk thread streams the rest, frames that didn't arrive in time
+// are played as silence and counted as an underrun.
+void GigInstrument::loadSample( GigSample& sample, sampleFrame* sampleData, f_cnt_t samples )
+{
+	if( sampleData == nullptr || samples < 1 )
 	{
-		sample.sample->SetPos( sample.pos );
+		return;
+	}
+
+	gig::Sample * pSample = sample.sample;
+	const gig::buffer_t cache = pSample->GetCache();
+	const auto cacheData = static_cast<const int8_t*>( cache.pStart );
+	const f_cnt_t cachedFrames = cache.Size / pSample->FrameSize;
+	const f_cnt_t total = pSample->SamplesTotal;
 
-		unsigned long size = sample.sample->Read( &buffer, samples ) * sample.sample->FrameSize;
-		std::memset( (int8_t*) &buffer + size, 0, allocationsize - size );
+	// Only stream if the frames we may play aren't all in memory
+	const bool streamed = cachedFrames < ( sample.loop.enabled ? sample.loop.end : total );
+
+	if( streamed && sample.stream == nullptr )
+	{
+		sample.stream = m_streamer->startStream( pSample, sample.loop,
+				std::max( sample.pos, cachedFrames ), m_instance->diskMutex );
 	}
 
-	// Convert from 16 or 24 bit into 32-bit float
-	if( sample.sample->BitDepth == 24 ) // 24 bit
+	bool underrun = false;
+	f_cnt_t done = 0;
+
+	while( done < samples )
 	{
-		auto pInt = reinterpret_cast<uint8_t*>(&buffer);
+		const f_cnt_t pos = sample.pos + done;
+		f_cnt_t count = samples - done;
 
-		for( f_cnt_t i = 0; i < samples; ++i )
+		if( sample.loop.enabled == false )
 		{
-			// libgig gives 24-bit data as little endian, so we must
-			// convert if on a big endian system
-			int32_t valueLeft = swap32IfBE(
-						( pInt[ 3 * sample.sample->Channels * i ] << 8 ) |
-						( pInt[ 3 * sample.sample->Channels * i + 1 ] << 16 ) |
-						( pInt[ 3 * sample.sample->Channels * i + 2 ] << 24 ) );
+			if( pos >= total )
+			{
+				std::memset( &sampleData[done], 0, count * sizeof( sampleFrame ) );
+				break;
+			}
+
+			count = std::min( count, total - pos );
+		}
 
-			// Store the notes to this buffer before saving to output
-			// so we can fade them out as needed
-			sampleData[i][0] = 1.0 / 0x100000000 * sample.attenuation * valueLeft;
+		if( streamed == false || pos < cachedFrames )
+		{
+			// Read from memory up to the end of the loop or of the preloaded
+			// part, whatever comes first
+			const GigSampleLoop::Run run = sample.loop.run( pos, total );
+			count = std::min( count, run.frames );
 
-			if( sample.sample->Channels == 1 )
+			if( streamed == true )
 			{
-				sampleData[i][1] = sampleData[i][0];
+				count = std::min( count, cachedFrames - pos );
 			}
-			else
-			{
-				int32_t valueRight = swap32IfBE(
-							( pInt[ 3 * sample.sample->Channels * i + 3 ] << 8 ) |
-							( pInt[ 3 * sample.sample->Channels * i + 4 ] << 16 ) |
-							( pInt[ 3 * sample.sample->Channels * i + 5 ] << 24 ) );
 
-				sampleData[i][1] = 1.0 / 0x100000000 * sample.attenuation * valueRight;
-			}
+			const f_cnt_t first = run.backwards ? run.frame - count + 1 : run.frame;
+			convertFrames( pSample, &cacheData[first * pSample->FrameSize],
+					&sampleData[done], count, run.backwards );
 		}
-	}
-	else // 16 bit
-	{
-		auto pInt = reinterpret_cast<int16_t*>(&buffer);
-
-		for( f_cnt_t i = 0; i < samples; ++i )
+		else
 		{
-			sampleData[i][0] = 1.0 / 0x10000 *
-				pInt[ sample.sample->Channels * i ] * sample.attenuation;
+			GigStream * stream = sample.stream;
+			f_cnt_t available = 0;
 
-			if( sample.sample->Channels == 1 )
+			if( stream != nullptr )
 			{
-				sampleData[i][1] = sampleData[i][0];
+				// The disk thread can't fill more than a ring ahead of the
+				// frames we already used
+				count = std::min( count, stream->readPos.load( std::memory_order_relaxed )
+						+ GigStreamer::StreamFrames - pos );
+
+				if( count <= 0 )
+				{
+					std::memset( &sampleData[done], 0, ( samples - done ) * sizeof( sampleFrame ) );
+					underrun = true;
+					break;
+				}
+
+				available = stream->writePos.load( std::memory_order_acquire ) - pos;
+
+				// Exports don't have to keep up with realtime, so rather wait
+				// for the disk than leave gaps
+				while( available < count && Engine::getSong()->isExporting() )
+				{
+					m_streamer->wakeUp();
+					QThread::usleep( 100 );
+					available = stream->writePos.load( std::memory_order_acquire ) - pos;
+				}
+
+				available = std::clamp( available, 0, count );
+
+				for( f_cnt_t i = 0; i < available; )
+				{
+					const f_cnt_t index = ( pos + i ) & ( GigStreamer::StreamFrames - 1 );
+					const f_cnt_t frames = std::min( available - i, GigStreamer::StreamFrames - index );
+					std::memcpy( &sampleData[done + i], &stream->buffer[index], frames * sizeof( sampleFrame ) );
+					i += frames;
+				}
 			}
-			else
+
+			if( available < count )
 			{
-				sampleData[i][1] = 1.0 / 0x10000 *
-					pInt[ sample.sample->Channels * i + 1 ] * sample.attenuation;
+				std::memset( &sampleData[done + available], 0, ( count - available ) * sizeof( sampleFrame ) );
+				underrun = true;
 			}
 		}
+
+		done += count;
 	}
+
+	if( underrun == true )
+	{
+		++sample.underruns;
+		++m_underruns;
+	}
+
+	for( f_cnt_t i = 0; i < samples; ++i )
+	{
+		sampleData[i][0] *= sample.attenuation;
+		sampleData[i][1] *= sample.attenuation;
+	}
+}
+
+
+
+
+GigSampleLoop::GigSampleLoop() :
+	enabled( false ),
+	pingPong( false ),
+	start( 0 ),
+	end( 0 )
+{
 }
 
 
 
 
-// These two loop index functions taken from SampleBuffer.cpp
-f_cnt_t GigInstrument::getLoopedIndex( f_cnt_t index, f_cnt_t startf, f_cnt_t endf ) const
+GigSampleLoop::GigSampleLoop( gig::DimensionRegion * pDimRegion ) :
+	GigSampleLoop()
 {
-	if( index < endf )
+	if( pDimRegion->pSampleLoops != nullptr && pDimRegion->SampleLoops > 0 )
 	{
-		return index;
+		// Currently only support at max one loop
+		const auto & sampleLoop = pDimRegion->pSampleLoops[0];
+		const f_cnt_t samplesTotal = pDimRegion->pSample != nullptr ?
+			pDimRegion->pSample->SamplesTotal : 0;
+
+		start = sampleLoop.LoopStart;
+		end = std::min<f_cnt_t>( sampleLoop.LoopStart + sampleLoop.LoopLength, samplesTotal );
+		enabled = start < end;
+
+		// TODO: also implement loop_type_backward support
+		pingPong = static_cast<gig::loop_type_t>( sampleLoop.LoopType ) ==
+			gig::loop_type_bidirectional;
 	}
-
-	return startf + ( index - startf )
-				% ( endf - startf );
 }
 
 
 
 
-f_cnt_t GigInstrument::getPingPongIndex( f_cnt_t index, f_cnt_t startf, f_cnt_t endf ) const
+// The index calculations are taken from SampleBuffer.cpp
+GigSampleLoop::Run GigSampleLoop::run( f_cnt_t pos, f_cnt_t samplesTotal ) const
 {
-	if( index < endf )
+	if( enabled == false )
+	{
+		return { pos, samplesTotal - pos, false };
+	}
+
+	if( pos < end )
 	{
-		return index;
+		return { pos, end - pos, false };
 	}
 
-	const f_cnt_t looplen = endf - startf;
-	const f_cnt_t looppos = ( index - endf ) % ( looplen * 2 );
+	const f_cnt_t looplen = end - start;
+
+	if( pingPong == true )
+	{
+		const f_cnt_t looppos = ( pos - end ) % ( looplen * 2 );
 
-	return ( looppos < looplen )
-		? endf - looppos
-		: startf + ( looppos - looplen );
+		return ( looppos < looplen )
+			? Run{ end - 1 - looppos, looplen - looppos, true }
+			: Run{ start + ( looppos - looplen ), looplen * 2 - looppos, false };
+	}
+
+	const f_cnt_t frame = start + ( pos - start ) % looplen;
+
+	return { frame, end - frame, false };
 }
 
 
@@ -853,32 +1037,93 @@ Dimension GigInstrument::getDimensions( gig::Region * pRegion, int velocity, boo
 
 // Get the selected instrument from the GIG file we opened if we haven't gotten
 // it already. This is based on the bank and patch numbers.
+//
+// m_instance is only replaced by openFile() on this thread, so it can be used
+// without m_synthMutex. The instrument is preloaded before it is handed to
+// the audio thread, which keeps playing the previous one in the meantime.
 void GigInstrument::getInstrument()
 {
-	// Find instrument
-	int iBankSelected = m_bankNum.value();
-	int iProgSelected = m_patchNum.value();
+	if( m_instance == nullptr )
+	{
+		return;
+	}
+
+	gig::Instrument * pInstrument = findInstrument( m_instance, m_bankNum.value(), m_patchNum.value() );
+
+	preloadSamples( m_instance, pInstrument );
 
 	QMutexLocker locker( &m_synthMutex );
+	m_instrument = pInstrument;
+}
+
+
 
-	if( m_instance != nullptr )
+
+gig::Instrument * GigInstrument::findInstrument( GigInstance * instance, int bank, int patch )
+{
+	// libgig may read the instrument list from the file
+	QMutexLocker diskLock( instance->diskMutex.get() );
+
+	gig::Instrument * pInstrument = instance->gig.GetFirstInstrument();
+
+	while( pInstrument != nullptr )
 	{
-		gig::Instrument * pInstrument = m_instance->gig.GetFirstInstrument();
+		int iBank = pInstrument->MIDIBank;
+		int iProg = pInstrument->MIDIProgram;
 
-		while( pInstrument != nullptr )
+		if( iBank == bank && iProg == patch )
 		{
-			int iBank = pInstrument->MIDIBank;
-			int iProg = pInstrument->MIDIProgram;
+			break;
+		}
+
+		pInstrument = instance->gig.GetNextInstrument();
+	}
+
+	return pInstrument;
+}
+
+
+
+
+// The preloaded data stays in memory until the file is closed, since notes of
+// the previous instrument may still be playing from it. Each sample is loaded
+// with the file's disk lock held, so that the disk thread can go on streaming
+// the other notes in between.
+void GigInstrument::preloadSamples( GigInstance * instance, gig::Instrument * pInstrument )
+{
+	if( pInstrument == nullptr )
+	{
+		return;
+	}
+
+	gig::Region* pRegion = pInstrument->GetFirstRegion();
 
-			if( iBank == iBankSelected && iProg == iProgSelected )
+	while( pRegion != nullptr )
+	{
+		for( uint32_t i = 0; i < pRegion->DimensionRegions; ++i )
+		{
+			gig::Sample * pSample = pRegion->pDimensionRegions[i]->pSample;
+
+			if( pSample == nullptr || pSample->SamplesTotal == 0 ||
+					pSample->GetCache().Size > 0 )
 			{
-				break;
+				continue;
 			}
 
-			pInstrument = m_instance->gig.GetNextInstrument();
+			QMutexLocker diskLock( instance->diskMutex.get() );
+
+			try
+			{
+				pSample->LoadSampleData( GigStreamer::preloadFrames( pSample ) );
+			}
+			catch( ... )
+			{
+				// Without preloaded data the whole sample is streamed
+				qWarning( "GigInstrument: could not preload sample data" );
+			}
 		}
 
-		m_instrument = pInstrument;
+		pRegion = pInstrument->GetNextRegion();
 	}
 }
 
@@ -1086,11 +1331,13 @@ void GigInstrumentView::showPatchDialog()
 GigSample::GigSample( gig::Sample * pSample, gig::DimensionRegion * pDimRegion,
 		float attenuation, int interpolation, float desiredFreq )
 	: sample( pSample ), region( pDimRegion ), attenuation( attenuation ),
-	  pos( 0 ), interpolation( interpolation ), srcState( nullptr ),
-	  sampleFreq( 0 ), freqFactor( 1 )
+	  pos( 0 ), stream( nullptr ), underruns( 0 ), interpolation( interpolation ),
+	  srcState( nullptr ), sampleFreq( 0 ), freqFactor( 1 )
 {
 	if( sample != nullptr && region != nullptr )
 	{
+		loop = GigSampleLoop( region );
+
 		// Note: we don't create the libsamplerate object here since we always
 		// also call the copy constructor when appending to the end of the
 		// QList. We'll create it only in the copy constructor so we only have
@@ -1123,6 +1370,11 @@ GigSample::~GigSample()
 	{
 		src_delete( srcState );
 	}
+
+	if( stream != nullptr )
+	{
+		stream->release();
+	}
 }
 
 
@@ -1130,10 +1382,12 @@ GigSample::~GigSample()
 
 GigSample::GigSample( const GigSample& g )
 	: sample( g.sample ), region( g.region ), attenuation( g.attenuation ),
-	  adsr( g.adsr ), pos( g.pos ), interpolation( g.interpolation ),
+	  adsr( g.adsr ), pos( g.pos ), loop( g.loop ), stream( nullptr ),
+	  underruns( g.underruns ), interpolation( g.interpolation ),
 	  srcState( nullptr ), sampleFreq( g.sampleFreq ), freqFactor( g.freqFactor )
 {
-	// On the copy, we want to create the object
+	// On the copy, we want to create the object. The stream isn't shared,
+	// the copy starts its own one when it's played.
 	updateSampleRate();
 }
 
@@ -1147,11 +1401,19 @@ GigSample& GigSample::operator=( const GigSample& g )
 	attenuation = g.attenuation;
 	adsr = g.adsr;
 	pos = g.pos;
+	loop = g.loop;
+	underruns = g.underruns;
 	interpolation = g.interpolation;
 	srcState = nullptr;
 	sampleFreq = g.sampleFreq;
 	freqFactor = g.freqFactor;
 
+	if( stream != nullptr )
+	{
+		stream->release();
+		stream = nullptr;
+	}
+
 	if( g.srcState != nullptr )
 	{
 		updateSampleRate();
@@ -1229,6 +1491,236 @@ bool GigSample::convertSampleRate( sampleFrame & oldBuf, sampleFrame & newBuf,
 
 
 
+GigStreamer * GigStreamer::s_instance = nullptr;
+int GigStreamer::s_users = 0;
+QMutex GigStreamer::s_instanceMutex;
+
+
+
+
+GigStreamer::GigStreamer() :
+	m_wakeUpPending( false ),
+	m_quit( false ),
+	m_readBuffer( MM_ALLOC<int8_t>( ChunkFrames * sizeof( sampleFrame ) ) ),
+	m_convertBuffer( MM_ALLOC<sampleFrame>( ChunkFrames ) )
+{
+	for( auto& stream : m_streams )
+	{
+		stream.buffer = MM_ALLOC<sampleFrame>( StreamFrames );
+	}
+}
+
+
+
+
+GigStreamer::~GigStreamer()
+{
+	m_quit = true;
+	wakeUp();
+	wait();
+
+	for( auto& stream : m_streams )
+	{
+		MM_FREE( stream.buffer );
+	}
+
+	MM_FREE( m_readBuffer );
+	MM_FREE( m_convertBuffer );
+}
+
+
+
+
+GigStreamer * GigStreamer::acquire()
+{
+	QMutexLocker locker( &s_instanceMutex );
+
+	if( s_users++ == 0 )
+	{
+		s_instance = new GigStreamer;
+		s_instance->start();
+	}
+
+	return s_instance;
+}
+
+
+
+
+void GigStreamer::release()
+{
+	QMutexLocker locker( &s_instanceMutex );
+
+	if( --s_users == 0 )
+	{
+		delete s_instance;
+		s_instance = nullptr;
+	}
+}
+
+
+
+
+f_cnt_t GigStreamer::preloadFrames( const gig::Sample * pSample )
+{
+	return std::min<f_cnt_t>( pSample->SamplesTotal,
+			pSample->SamplesPerSecond * PreloadMs / 1000 );
+}
+
+
+
+
+GigStream * GigStreamer::startStream( gig::Sample * pSample,
+		const GigSampleLoop & loop, f_cnt_t startFrame,
+		const std::shared_ptr<QMutex> & diskMutex )
+{
+	for( auto& stream : m_streams )
+	{
+		auto state = GigStream::State::Free;
+
+		if( stream.state.compare_exchange_strong( state, GigStream::State::Starting,
+				std::memory_order_acquire ) )
+		{
+			stream.sample = pSample;
+			stream.loop = loop;
+			stream.startFrame = startFrame;
+			stream.diskMutex = diskMutex;
+			stream.readPos.store( startFrame, std::memory_order_relaxed );
+			stream.writePos.store( startFrame, std::memory_order_relaxed );
+			stream.state.store( GigStream::State::Active, std::memory_order_release );
+
+			wakeUp();
+			return &stream;
+		}
+	}
+
+	return nullptr;
+}
+
+
+
+
+void GigStreamer::wakeUp()
+{
+	m_wakeUpPending = true;
+	m_wakeUp.wakeOne();
+}
+
+
+
+
+void GigStreamer::run()
+{
+	while( m_quit == false )
+	{
+		bool active = false;
+		bool busy = false;
+
+		// Read a chunk for every stream per round, so a note that needs a
+		// lot of data doesn't hold up the others
+		for( auto& stream : m_streams )
+		{
+			switch( stream.state.load( std::memory_order_acquire ) )
+			{
+				case GigStream::State::Active:
+					active = true;
+					busy = fill( stream ) || busy;
+					break;
+				case GigStream::State::Released:
+					stream.diskMutex.reset();
+					stream.state.store( GigStream::State::Free, std::memory_order_release );
+					break;
+				default:
+					break;
+			}
+		}
+
+		// Sleep until a note starts or some time has passed, notes
+		// don't tell us when they used frames. Without any streams only
+		// a new note gives us something to do, the timeout just covers a
+		// wake-up that came in right before we started waiting.
+		if( busy == false )
+		{
+			QMutexLocker locker( &m_wakeUpMutex );
+
+			if( m_quit == false && m_wakeUpPending.exchange( false ) == false )
+			{
+				m_wakeUp.wait( &m_wakeUpMutex, active ? BusyWaitMs : IdleWaitMs );
+			}
+		}
+	}
+}
+
+
+
+
+bool GigStreamer::fill( GigStream & stream )
+{
+	QMutexLocker diskLock( stream.diskMutex.get() );
+
+	// The note may have been removed and its file closed while we waited
+	if( stream.state.load( std::memory_order_acquire ) != GigStream::State::Active )
+	{
+		return false;
+	}
+
+	gig::Sample * pSample = stream.sample;
+	const f_cnt_t readPos = stream.readPos.load( std::memory_order_acquire );
+
+	// If the audio thread had to skip frames, continue where it is now
+	f_cnt_t writePos = std::max( stream.writePos.load( std::memory_order_relaxed ), readPos );
+
+	f_cnt_t frames = std::min( StreamFrames - ( writePos - readPos ), ChunkFrames );
+
+	if( stream.loop.enabled == false )
+	{
+		frames = std::min<f_cnt_t>( frames, pSample->SamplesTotal - writePos );
+	}
+
+	if( frames <= 0 )
+	{
+		stream.writePos.store( writePos, std::memory_order_release );
+		return false;
+	}
+
+	for( f_cnt_t done = 0; done < frames; )
+	{
+		const GigSampleLoop::Run run = stream.loop.run( writePos + done, pSample->SamplesTotal );
+		const f_cnt_t count = std::min( frames - done, run.frames );
+		f_cnt_t framesRead = 0;
+
+		try
+		{
+			pSample->SetPos( run.backwards ? run.frame - count + 1 : run.frame );
+			framesRead = pSample->Read( m_readBuffer, count );
+		}
+		catch( ... )
+		{
+			framesRead = 0;
+		}
+
+		std::memset( &m_readBuffer[framesRead * pSample->FrameSize], 0,
+				( count - framesRead ) * pSample->FrameSize );
+		convertFrames( pSample, m_readBuffer, &m_convertBuffer[done], count, run.backwards );
+		done += count;
+	}
+
+	for( f_cnt_t i = 0; i < frames; )
+	{
+		const f_cnt_t index = ( writePos + i ) & ( StreamFrames - 1 );
+		const f_cnt_t count = std::min( frames - i, StreamFrames - index );
+		std::memcpy( &stream.buffer[index], &m_convertBuffer[i], count * sizeof( sampleFrame ) );
+		i += count;
+	}
+
+	stream.writePos.store( writePos + frames, std::memory_order_release );
+
+	return true;
+}
+
+
+
+
 ADSR::ADSR()
 	: preattack( 0 ), attack( 0 ), decay1( 0 ), decay2( 0 ), infiniteSustain( false ),
 	  sustain( 0 ), release( 0 ),
@@ -1381,6 +1873,16 @@ PLUGIN_EXPORT Plugin * lmms_plugin_main( Model *m, void * )
 	return new GigInstrument( static_cast<InstrumentTrack *>( m ) );
 }
 
+PLUGIN_EXPORT void lmms_plugin_prefetch( const QDomElement & settings )
+{
+	GigInstrument::prefetchInstance( settings );
+}
+
+PLUGIN_EXPORT void lmms_plugin_drop_prefetched()
+{
+	GigInstrument::dropPrefetchedInstances();
+}
+
 }
 
 
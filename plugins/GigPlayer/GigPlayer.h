@@ -27,9 +27,17 @@
 #ifndef GIG_PLAYER_H
 #define GIG_PLAYER_H
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <future>
+#include <map>
+#include <memory>
 #include <QList>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QThread>
+#include <QWaitCondition>
 #include <samplerate.h>
 
 #include "Instrument.h"
@@ -74,7 +82,8 @@ class GigInstance
 public:
 	GigInstance( QString filename ) :
 		riff( filename.toUtf8().constData() ),
-		gig( &riff )
+		gig( &riff ),
+		diskMutex( std::make_shared<QMutex>() )
 	{}
 
 private:
@@ -82,6 +91,11 @@ private:
 
 public:
 	gig::File gig;
+
+	// libgig reads a file from a single position, so anything reading from
+	// it while notes are playing must hold this. Streams keep a reference,
+	// so the disk thread can still lock it after the file was closed.
+	std::shared_ptr<QMutex> diskMutex;
 } ;
 
 
@@ -143,6 +157,138 @@ public:
 
 
 
+// The loop of a sample. Positions in a looping sample keep counting up, this
+// maps them to the frames in the sample.
+struct GigSampleLoop
+{
+	GigSampleLoop();
+	GigSampleLoop( gig::DimensionRegion * pDimRegion );
+
+	// The frame at a position and how many frames after it can be read in the
+	// same direction before the loop wraps around or turns
+	struct Run
+	{
+		f_cnt_t frame;
+		f_cnt_t frames;
+		bool backwards;
+	} ;
+
+	Run run( f_cnt_t pos, f_cnt_t samplesTotal ) const;
+
+	bool enabled;
+	bool pingPong;
+	f_cnt_t start;
+	f_cnt_t end;
+} ;
+
+
+
+
+// A ring buffer the disk thread fills with the frames of a playing sample
+// that come after its preloaded part. Positions are those of the note in the
+// sample, the ring holds the frames from readPos up to writePos.
+class GigStream
+{
+public:
+	enum class State
+	{
+		Free,
+		Starting, // being set up by the audio thread
+		Active,
+		Released // the note is done, the disk thread frees the stream
+	} ;
+
+	// Let the disk thread overwrite the frames before pos
+	void consume( f_cnt_t pos )
+	{
+		readPos.store( std::max( pos, startFrame ), std::memory_order_release );
+	}
+
+	void release()
+	{
+		state.store( State::Released, std::memory_order_release );
+	}
+
+	std::atomic<State> state{ State::Free };
+
+	gig::Sample * sample = nullptr;
+	GigSampleLoop loop;
+	f_cnt_t startFrame = 0;
+
+	// The lock of the sample's file, only reset by the disk thread when it
+	// frees the stream
+	std::shared_ptr<QMutex> diskMutex;
+
+	std::atomic<f_cnt_t> readPos{ 0 }; // only written by the audio thread
+	std::atomic<f_cnt_t> writePos{ 0 }; // only written by the disk thread
+	sampleFrame * buffer = nullptr;
+} ;
+
+
+
+
+// The disk thread shared by all GIG players. It keeps the streams of the
+// playing notes filled, so that the audio thread never reads from disk.
+//
+// Note: the disk thread holds the lock of a stream's file (GigInstance::diskMutex)
+// for one chunk at a time, so other files and other readers aren't held up
+// for a whole round
+class GigStreamer : public QThread
+{
+public:
+	// How much of each sample is kept in memory so notes start right away
+	static constexpr int PreloadMs = 250;
+
+	// Notes playing from disk at once, and the ring size of each of them
+	static constexpr int StreamCount = 64;
+	static constexpr f_cnt_t StreamFrames = 32768; // must be a power of 2
+
+	// The most frames read for one stream before serving the next one
+	static constexpr f_cnt_t ChunkFrames = 4096;
+
+	// How long to sleep when all streams are filled, and when there are none
+	static constexpr unsigned long BusyWaitMs = 2;
+	static constexpr unsigned long IdleWaitMs = 50;
+
+	static GigStreamer * acquire();
+	static void release();
+
+	static f_cnt_t preloadFrames( const gig::Sample * pSample );
+
+	// Called by the audio thread, returns nullptr if all streams are in use
+	GigStream * startStream( gig::Sample * pSample, const GigSampleLoop & loop,
+			f_cnt_t startFrame, const std::shared_ptr<QMutex> & diskMutex );
+
+	void wakeUp();
+
+protected:
+	void run() override;
+
+private:
+	GigStreamer();
+	~GigStreamer() override;
+
+	// Returns whether there was anything to read
+	bool fill( GigStream & stream );
+
+	std::array<GigStream, StreamCount> m_streams;
+
+	QMutex m_wakeUpMutex;
+	QWaitCondition m_wakeUp;
+	std::atomic<bool> m_wakeUpPending;
+	std::atomic<bool> m_quit;
+
+	int8_t * m_readBuffer;
+	sampleFrame * m_convertBuffer;
+
+	static GigStreamer * s_instance;
+	static int s_users;
+	static QMutex s_instanceMutex;
+} ;
+
+
+
+
 // The sample from the GIG file with our current position in both the sample
 // and the envelope
 class GigSample
@@ -166,8 +312,14 @@ public:
 	float attenuation;
 	ADSR adsr;
 
-	// The position in sample
+	// The position in sample, keeps counting up while looping
 	f_cnt_t pos;
+	GigSampleLoop loop;
+
+	// Where the frames after the preloaded part come from, and how many
+	// periods had to be played without them
+	GigStream * stream;
+	int underruns;
 
 	// Whether to change the pitch of the samples, e.g. if there's only one
 	// sample per octave and you want that sample pitch shifted for the rest of
@@ -278,6 +430,12 @@ public:
 
 	void setParameter( const QString & _param, const QString & _value );
 
+	// Start opening the GIG file the settings refer to and preloading their
+	// instrument on another thread, so openFile() only has to wait for it
+	static void prefetchInstance( const QDomElement & _this );
+	// Close the prefetched GIG files no instrument has opened
+	static void dropPrefetchedInstances();
+
 
 public slots:
 	void openFile( const QString & _gigFile, bool updateTrackName = true );
@@ -305,6 +463,10 @@ private:
 	// Used for resampling
 	int m_interpolation;
 
+	// Reads the samples from disk while notes are playing
+	GigStreamer * m_streamer;
+	std::atomic<int> m_underruns;
+
 	// List of all the currently playing notes
 	QList<GigNote> m_notes;
 
@@ -312,6 +474,11 @@ private:
 	uint32_t m_RandomSeed;
 	float m_currentKeyDimension;
 
+	// GIG files being opened by prefetchInstance(), one for each instrument
+	// which will open them, by absolute path
+	static std::multimap<QString, std::future<GigInstance*>> s_prefetchedInstances;
+	static QMutex s_prefetchedInstancesMutex;
+
 private:
 	// Delete the current GIG instance if one is open
 	void freeInstance();
@@ -319,14 +486,20 @@ private:
 	// Open the instrument in the currently-open GIG file
 	void getInstrument();
 
+	// Find the instrument with the given bank and patch in a GIG file
+	static gig::Instrument * findInstrument( GigInstance * instance, int bank, int patch );
+
 	// Create "dimension" to select desired samples from GIG file based on
 	// parameters such as velocity
 	Dimension getDimensions( gig::Region * pRegion, int velocity, bool release );
 
-	// Load sample data from the Gig file, looping the sample where needed
+	// Keep the beginning of the instrument's samples in memory, so notes
+	// can start without waiting for the disk
+	static void preloadSamples( GigInstance * instance, gig::Instrument * pInstrument );
+
+	// Load sample data from memory or the note's stream, looping the sample
+	// where needed
 	void loadSample( GigSample& sample, sampleFrame* sampleData, f_cnt_t samples );
-	f_cnt_t getLoopedIndex( f_cnt_t index, f_cnt_t startf, f_cnt_t endf ) const;
-	f_cnt_t getPingPongIndex( f_cnt_t index, f_cnt_t startf, f_cnt_t endf ) const;
 
 	// Add the desired samples to the note, either normal samples or release
 	// samples
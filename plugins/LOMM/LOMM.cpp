@@ -24,6 +24,8 @@
 
 #include "LOMM.h"
 
+#include <type_traits>
+
 #include "embed.h"
 #include "plugin_export.h"
 
@@ -59,7 +61,8 @@ LOMMEffect::LOMMEffect(Model* parent, const Descriptor::SubPluginFeatures::Key*
 	m_coeffPrecalc(-0.05),
 	m_crestTimeConst(0.999),
 	m_lookWrite(0),
-	m_lookBufLength(2)
+	m_lookBufLength(2),
+	m_lookBufMask(1)
 {
 	autoQuitModel()->setValue(autoQuitModel()->maxValue());
 	
@@ -84,13 +87,19 @@ void LOMMEffect::changeSampleRate()
 	
 	m_crestTimeConst = exp(-1.f / (0.2f * m_sampleRate));
 	
+	// The bands are delayed by m_lookBufLength samples. The ring buffers are a power
+	// of two long, so that they can be indexed with a mask.
 	m_lookBufLength = std::ceil((LOMM_MAX_LOOKAHEAD / 1000.f) * m_sampleRate) + 2;
+	int lookBufCapacity = 1;
+	while (lookBufCapacity < m_lookBufLength) { lookBufCapacity *= 2; }
+	m_lookBufMask = lookBufCapacity - 1;
+	m_lookWrite = 0;
 	for (int i = 0; i < 2; ++i)
 	{
 		for (int j = 0; j < 3; ++j)
 		{
-			m_inLookBuf[j][i].resize(m_lookBufLength);
-			m_scLookBuf[j][i].resize(m_lookBufLength, LOMM_MIN_FLOOR);
+			m_inLookBuf[j][i].resize(lookBufCapacity);
+			m_scLookBuf[j][i].resize(lookBufCapacity, LOMM_MIN_FLOOR);
 		}
 	}
 }
@@ -193,240 +202,253 @@ bool LOMMEffect::processAudioBuffer(sampleFrame* buf, const fpp_t frames)
 	const float autoTime = m_lommControls.m_autoTimeModel.value() * m_lommControls.m_autoTimeModel.value();
 	const float mix = m_lommControls.m_mixModel.value();
 	const bool midside = m_lommControls.m_midsideModel.value();
-	const bool lookaheadEnable = m_lommControls.m_lookaheadEnableModel.value();
+	const bool lookaheadEnabled = m_lommControls.m_lookaheadEnableModel.value();
 	const int lookahead = std::ceil((m_lommControls.m_lookaheadModel.value() / 1000.f) * m_sampleRate);
-	const bool feedback = m_lommControls.m_feedbackModel.value() && !lookaheadEnable;
+	const bool feedbackEnabled = m_lommControls.m_feedbackModel.value() && !lookaheadEnabled;
 	const bool lowSideUpwardSuppress = m_lommControls.m_lowSideUpwardSuppressModel.value() && midside;
 	
-	for (fpp_t f = 0; f < frames; ++f)
+	// The lookahead and feedback modes are template parameters of the frame loop, so that they
+	// aren't tested for every sample, band and channel.
+	auto processFrames = [&](auto lookaheadMode, auto feedbackMode)
 	{
-		std::array<sample_t, 2> s = {buf[f][0], buf[f][1]};
-		
-		// Convert left/right to mid/side.  Side channel is intentionally made
-		// to be 6 dB louder to bring it into volume ranges comparable to the mid channel.
-		if (midside)
-		{
-			float tempS0 = s[0];
-			s[0] = (s[0] + s[1]) * 0.5f;
-			s[1] = tempS0 - s[1];
-		}
-		
-		std::array<std::array<float, 2>, 3> bands = {{}};
-		std::array<std::array<float, 2>, 3> bandsDry = {{}};
-		
-		for (int i = 0; i < 2; ++i)// Channels
+		constexpr bool lookaheadEnable = decltype(lookaheadMode)::value;
+		constexpr bool feedback = decltype(feedbackMode)::value;
+	
+		for (fpp_t f = 0; f < frames; ++f)
 		{
-			// These values are for the Auto time knob.  Higher crest factor allows for faster attack/release.
-			float inSquared = s[i] * s[i];
-			m_crestPeakVal[i] = std::max(std::max(LOMM_MIN_FLOOR, inSquared), m_crestTimeConst * m_crestPeakVal[i] + (1 - m_crestTimeConst) * (inSquared));
-			m_crestRmsVal[i] = std::max(LOMM_MIN_FLOOR, m_crestTimeConst * m_crestRmsVal[i] + ((1 - m_crestTimeConst) * (inSquared)));
-			m_crestFactorVal[i] = m_crestPeakVal[i] / m_crestRmsVal[i];
-			float crestFactorValTemp = ((m_crestFactorVal[i] - LOMM_AUTO_TIME_ADJUST) * autoTime) + LOMM_AUTO_TIME_ADJUST;
-		
-			// Crossover filters
-			bands[0][i] = m_hp1.update(s[i], i);
-			bands[1][i] = m_hp2.update(m_lp1.update(s[i], i), i);
-			bands[2][i] = m_lp2.update(s[i], i);
+			std::array<sample_t, 2> s = {buf[f][0], buf[f][1]};
 			
-			if (!split1Enabled)
+			// Convert left/right to mid/side.  Side channel is intentionally made
+			// to be 6 dB louder to bring it into volume ranges comparable to the mid channel.
+			if (midside)
 			{
-				bands[1][i] += bands[0][i];
-				bands[0][i] = 0;
-			}
-			if (!split2Enabled)
-			{
-				bands[1][i] += bands[2][i];
-				bands[2][i] = 0;
+				float tempS0 = s[0];
+				s[0] = (s[0] + s[1]) * 0.5f;
+				s[1] = tempS0 - s[1];
 			}
 			
-			// Mute disabled bands
-			bands[0][i] *= band1Enabled;
-			bands[1][i] *= band2Enabled;
-			bands[2][i] *= band3Enabled;
+			std::array<std::array<float, 2>, 3> bands = {{}};
+			std::array<std::array<float, 2>, 3> bandsDry = {{}};
 			
-			std::array<float, 3> detect = {0, 0, 0};
-			for (int j = 0; j < 3; ++j)// Bands
+			for (int i = 0; i < 2; ++i)// Channels
 			{
-				bandsDry[j][i] = bands[j][i];
-				
-				if (feedback && !lookaheadEnable)
-				{
-					bands[j][i] = m_prevOut[j][i];
-				}
-				
-				bands[j][i] *= inBandVol[j] * inVol * balanceAmp[i];
+				// These values are for the Auto time knob.  Higher crest factor allows for faster attack/release.
+				float inSquared = s[i] * s[i];
+				m_crestPeakVal[i] = std::max(std::max(LOMM_MIN_FLOOR, inSquared), m_crestTimeConst * m_crestPeakVal[i] + (1 - m_crestTimeConst) * (inSquared));
+				m_crestRmsVal[i] = std::max(LOMM_MIN_FLOOR, m_crestTimeConst * m_crestRmsVal[i] + ((1 - m_crestTimeConst) * (inSquared)));
+				m_crestFactorVal[i] = m_crestPeakVal[i] / m_crestRmsVal[i];
+				float crestFactorValTemp = ((m_crestFactorVal[i] - LOMM_AUTO_TIME_ADJUST) * autoTime) + LOMM_AUTO_TIME_ADJUST;
+			
+				// Crossover filters
+				bands[0][i] = m_hp1.update(s[i], i);
+				bands[1][i] = m_hp2.update(m_lp1.update(s[i], i), i);
+				bands[2][i] = m_lp2.update(s[i], i);
 				
-				if (rmsTime > 0)// RMS
+				if (!split1Enabled)
 				{
-					m_rms[j][i] = rmsTimeConst * m_rms[j][i] + ((1 - rmsTimeConst) * (bands[j][i] * bands[j][i]));
-					detect[j] = std::max(LOMM_MIN_FLOOR, std::sqrt(m_rms[j][i]));
+					bands[1][i] += bands[0][i];
+					bands[0][i] = 0;
 				}
-				else// Peak
+				if (!split2Enabled)
 				{
-					detect[j] = std::max(LOMM_MIN_FLOOR, std::abs(bands[j][i]));
+					bands[1][i] += bands[2][i];
+					bands[2][i] = 0;
 				}
 				
-				if (detect[j] > m_yL[j][i])// Attack phase
+				// Mute disabled bands
+				bands[0][i] *= band1Enabled;
+				bands[1][i] *= band2Enabled;
+				bands[2][i] *= band3Enabled;
+				
+				std::array<float, 3> detect = {0, 0, 0};
+				for (int j = 0; j < 3; ++j)// Bands
 				{
-					// Calculate attack value depending on crest factor
-					const float currentAttack = autoTime
-						? msToCoeff(LOMM_AUTO_TIME_ADJUST * atk[j] / crestFactorValTemp)
-						: atkCoef[j];
+					bandsDry[j][i] = bands[j][i];
 					
-					m_yL[j][i] = m_yL[j][i] * currentAttack + (1 - currentAttack) * detect[j];
-				}
-				else// Release phase
-				{
-					// Calculate release value depending on crest factor
-					const float currentRelease = autoTime
-						? msToCoeff(LOMM_AUTO_TIME_ADJUST * rel[j] / crestFactorValTemp)
-						: relCoef[j];
+					if constexpr (feedback)
+					{
+						bands[j][i] = m_prevOut[j][i];
+					}
 					
-					m_yL[j][i] = m_yL[j][i] * currentRelease + (1 - currentRelease) * detect[j];
-				}
-				
-				m_yL[j][i] = std::max(LOMM_MIN_FLOOR, m_yL[j][i]);
-				
-				float yAmp = m_yL[j][i];
-				if (lookaheadEnable)
-				{
-					float temp = yAmp;
-					// Lookahead is calculated by picking the largest value between
-					// the current sidechain signal and the delayed sidechain signal.
-					yAmp = std::max(m_scLookBuf[j][i][m_lookWrite], m_scLookBuf[j][i][(m_lookWrite + m_lookBufLength - lookahead) % m_lookBufLength]);
-					m_scLookBuf[j][i][m_lookWrite] = temp;
-				}
-				
-				const float yDbfs = ampToDbfs(yAmp);
-				
-				float aboveGain = 0;
-				float belowGain = 0;
-				
-				// Downward compression
-				if (yDbfs - aThresh[j] < -knee)// Below knee
-				{
-					aboveGain = yDbfs;
-				}
-				else if (yDbfs - aThresh[j] < knee)// Within knee
-				{
-					const float temp = yDbfs - aThresh[j] + knee;
-					aboveGain = yDbfs + (aRatio[j] - 1) * temp * temp / (4 * knee);
-				}
-				else// Above knee
-				{
-					aboveGain = aThresh[j] + (yDbfs - aThresh[j]) * aRatio[j];
-				}
-				if (aboveGain < yDbfs)
-				{
-					if (downward * depth <= 1)
+					bands[j][i] *= inBandVol[j] * inVol * balanceAmp[i];
+					
+					if (rmsTime > 0)// RMS
 					{
-						aboveGain = linearInterpolate(yDbfs, aboveGain, downward * depth);
+						m_rms[j][i] = rmsTimeConst * m_rms[j][i] + ((1 - rmsTimeConst) * (bands[j][i] * bands[j][i]));
+						detect[j] = std::max(LOMM_MIN_FLOOR, std::sqrt(m_rms[j][i]));
 					}
-					else
+					else// Peak
 					{
-						aboveGain = linearInterpolate(aboveGain, aThresh[j], downward * depth - 1);
+						detect[j] = std::max(LOMM_MIN_FLOOR, std::abs(bands[j][i]));
 					}
-				}
-				
-				// Upward compression
-				if (yDbfs - bThresh[j] > knee)// Above knee
-				{
-					belowGain = yDbfs;
-				}
-				else if (bThresh[j] - yDbfs < knee)// Within knee
-				{
-					const float temp = bThresh[j] - yDbfs + knee;
-					belowGain = yDbfs + (1 - bRatio[j]) * temp * temp / (4 * knee);
-				}
-				else// Below knee
-				{
-					belowGain = bThresh[j] + (yDbfs - bThresh[j]) * bRatio[j];
-				}
-				if (belowGain > yDbfs)
-				{
-					if (upward * depth <= 1)
+					
+					if (detect[j] > m_yL[j][i])// Attack phase
 					{
-						belowGain = linearInterpolate(yDbfs, belowGain, upward * depth);
+						// Calculate attack value depending on crest factor
+						const float currentAttack = autoTime
+							? msToCoeff(LOMM_AUTO_TIME_ADJUST * atk[j] / crestFactorValTemp)
+							: atkCoef[j];
+						
+						m_yL[j][i] = m_yL[j][i] * currentAttack + (1 - currentAttack) * detect[j];
 					}
-					else
+					else// Release phase
 					{
-						belowGain = linearInterpolate(belowGain, bThresh[j], upward * depth - 1);
+						// Calculate release value depending on crest factor
+						const float currentRelease = autoTime
+							? msToCoeff(LOMM_AUTO_TIME_ADJUST * rel[j] / crestFactorValTemp)
+							: relCoef[j];
+						
+						m_yL[j][i] = m_yL[j][i] * currentRelease + (1 - currentRelease) * detect[j];
 					}
-				}
-				
-				m_displayIn[j][i] = yDbfs;
-				m_gainResult[j][i] = (dbfsToAmp(aboveGain) / yAmp) * (dbfsToAmp(belowGain) / yAmp);
-				if (lowSideUpwardSuppress && m_gainResult[j][i] > 1 && j == 2 && i == 1) //undo upward compression if low side band
-				{
-					m_gainResult[j][i] = 1;
-				}
-				m_gainResult[j][i] = std::min(m_gainResult[j][i], rangeAmp);
-				m_displayOut[j][i] = ampToDbfs(std::max(LOMM_MIN_FLOOR, yAmp * m_gainResult[j][i]));
-				
-				// Apply the same gain reduction to both channels if stereo link is enabled.
-				if (stereoLink && i == 1)
-				{
-					if (m_gainResult[j][1] < m_gainResult[j][0])
+					
+					m_yL[j][i] = std::max(LOMM_MIN_FLOOR, m_yL[j][i]);
+					
+					float yAmp = m_yL[j][i];
+					if constexpr (lookaheadEnable)
 					{
-						m_gainResult[j][0] = m_gainResult[j][1];
-						m_displayOut[j][0] = m_displayIn[j][0] - (m_displayIn[j][1] - m_displayOut[j][1]);
+						float temp = yAmp;
+						// Lookahead is calculated by picking the largest value between
+						// the current sidechain signal and the delayed sidechain signal.
+						yAmp = std::max(m_scLookBuf[j][i][(m_lookWrite + m_lookBufLength) & m_lookBufMask],
+							m_scLookBuf[j][i][(m_lookWrite + m_lookBufLength - lookahead) & m_lookBufMask]);
+						m_scLookBuf[j][i][m_lookWrite] = temp;
 					}
-					else
+					
+					const float yDbfs = fastAmpToDbfs(yAmp);
+					
+					float aboveGain = 0;
+					float belowGain = 0;
+					
+					// Downward compression
+					if (yDbfs - aThresh[j] < -knee)// Below knee
+					{
+						aboveGain = yDbfs;
+					}
+					else if (yDbfs - aThresh[j] < knee)// Within knee
+					{
+						const float temp = yDbfs - aThresh[j] + knee;
+						aboveGain = yDbfs + (aRatio[j] - 1) * temp * temp / (4 * knee);
+					}
+					else// Above knee
+					{
+						aboveGain = aThresh[j] + (yDbfs - aThresh[j]) * aRatio[j];
+					}
+					if (aboveGain < yDbfs)
+					{
+						if (downward * depth <= 1)
+						{
+							aboveGain = linearInterpolate(yDbfs, aboveGain, downward * depth);
+						}
+						else
+						{
+							aboveGain = linearInterpolate(aboveGain, aThresh[j], downward * depth - 1);
+						}
+					}
+					
+					// Upward compression
+					if (yDbfs - bThresh[j] > knee)// Above knee
+					{
+						belowGain = yDbfs;
+					}
+					else if (bThresh[j] - yDbfs < knee)// Within knee
+					{
+						const float temp = bThresh[j] - yDbfs + knee;
+						belowGain = yDbfs + (1 - bRatio[j]) * temp * temp / (4 * knee);
+					}
+					else// Below knee
+					{
+						belowGain = bThresh[j] + (yDbfs - bThresh[j]) * bRatio[j];
+					}
+					if (belowGain > yDbfs)
+					{
+						if (upward * depth <= 1)
+						{
+							belowGain = linearInterpolate(yDbfs, belowGain, upward * depth);
+						}
+						else
+						{
+							belowGain = linearInterpolate(belowGain, bThresh[j], upward * depth - 1);
+						}
+					}
+					
+					m_displayIn[j][i] = yDbfs;
+					m_gainResult[j][i] = fastDbfsToAmp(aboveGain + belowGain) / (yAmp * yAmp);
+					if (lowSideUpwardSuppress && m_gainResult[j][i] > 1 && j == 2 && i == 1) //undo upward compression if low side band
+					{
+						m_gainResult[j][i] = 1;
+					}
+					m_gainResult[j][i] = std::min(m_gainResult[j][i], rangeAmp);
+					m_displayOut[j][i] = fastAmpToDbfs(std::max(LOMM_MIN_FLOOR, yAmp * m_gainResult[j][i]));
+					
+					// Apply the same gain reduction to both channels if stereo link is enabled.
+					if (stereoLink && i == 1)
 					{
-						m_gainResult[j][1] = m_gainResult[j][0];
-						m_displayOut[j][1] = m_displayIn[j][1] - (m_displayIn[j][0] - m_displayOut[j][0]);
+						if (m_gainResult[j][1] < m_gainResult[j][0])
+						{
+							m_gainResult[j][0] = m_gainResult[j][1];
+							m_displayOut[j][0] = m_displayIn[j][0] - (m_displayIn[j][1] - m_displayOut[j][1]);
+						}
+						else
+						{
+							m_gainResult[j][1] = m_gainResult[j][0];
+							m_displayOut[j][1] = m_displayIn[j][1] - (m_displayIn[j][0] - m_displayOut[j][0]);
+						}
 					}
 				}
 			}
-		}
-		
-		for (int i = 0; i < 2; ++i)// Channels
-		{
-			for (int j = 0; j < 3; ++j)// Bands
+			
+			for (int i = 0; i < 2; ++i)// Channels
 			{
-				if (lookaheadEnable)
+				for (int j = 0; j < 3; ++j)// Bands
 				{
-					float temp = bands[j][i];
-					bands[j][i] = m_inLookBuf[j][i][m_lookWrite];
-					m_inLookBuf[j][i][m_lookWrite] = temp;
-					bandsDry[j][i] = bands[j][i];
-				}
-				else if (feedback)
-				{
-					bands[j][i] = bandsDry[j][i] * inBandVol[j] * inVol * balanceAmp[i];
-				}
-			
-				// Apply gain reduction
-				bands[j][i] *= m_gainResult[j][i];
+					if constexpr (lookaheadEnable)
+					{
+						float temp = bands[j][i];
+						bands[j][i] = m_inLookBuf[j][i][(m_lookWrite + m_lookBufLength) & m_lookBufMask];
+						m_inLookBuf[j][i][m_lookWrite] = temp;
+						bandsDry[j][i] = bands[j][i];
+					}
+					else if constexpr (feedback)
+					{
+						bands[j][i] = bandsDry[j][i] * inBandVol[j] * inVol * balanceAmp[i];
+					}
 				
-				// Store for Feedback
-				m_prevOut[j][i] = bands[j][i];
+					// Apply gain reduction
+					bands[j][i] *= m_gainResult[j][i];
+					
+					// Store for Feedback
+					m_prevOut[j][i] = bands[j][i];
+					
+					bands[j][i] *= outBandVol[j];
+					
+					bands[j][i] = linearInterpolate(bandsDry[j][i], bands[j][i], mix);
+				}
 				
-				bands[j][i] *= outBandVol[j];
+				s[i] = bands[0][i] + bands[1][i] + bands[2][i];
 				
-				bands[j][i] = linearInterpolate(bandsDry[j][i], bands[j][i], mix);
+				s[i] *= linearInterpolate(1.f, outVol, mix * (depthScaling ? depth : 1));
 			}
 			
-			s[i] = bands[0][i] + bands[1][i] + bands[2][i];
+			// Convert mid/side back to left/right.
+			// Note that the side channel was intentionally made to be 6 dB louder prior to compression.
+			if (midside)
+			{
+				float tempS0 = s[0];
+				s[0] = s[0] + (s[1] * 0.5f);
+				s[1] = tempS0 - (s[1] * 0.5f);
+			}
 			
-			s[i] *= linearInterpolate(1.f, outVol, mix * (depthScaling ? depth : 1));
-		}
-		
-		// Convert mid/side back to left/right.
-		// Note that the side channel was intentionally made to be 6 dB louder prior to compression.
-		if (midside)
-		{
-			float tempS0 = s[0];
-			s[0] = s[0] + (s[1] * 0.5f);
-			s[1] = tempS0 - (s[1] * 0.5f);
-		}
-		
-		if (--m_lookWrite < 0) { m_lookWrite = m_lookBufLength - 1; }
+			m_lookWrite = (m_lookWrite - 1) & m_lookBufMask;
 
-		buf[f][0] = d * buf[f][0] + w * s[0];
-		buf[f][1] = d * buf[f][1] + w * s[1];
-		outSum += buf[f][0] + buf[f][1];
-	}
+			buf[f][0] = d * buf[f][0] + w * s[0];
+			buf[f][1] = d * buf[f][1] + w * s[1];
+			outSum += buf[f][0] + buf[f][1];
+		}
+	};
+	
+	if (lookaheadEnabled) { processFrames(std::true_type{}, std::false_type{}); }
+	else if (feedbackEnabled) { processFrames(std::false_type{}, std::true_type{}); }
+	else { processFrames(std::false_type{}, std::false_type{}); }
 
 	checkGate(outSum / frames);
 	return isRunning();
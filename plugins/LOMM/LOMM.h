@@ -95,6 +95,7 @@ private:
 	
 	int m_lookWrite = 0;
 	int m_lookBufLength = 0;
+	int m_lookBufMask = 0;
 	
 	friend class LOMMControls;
 	friend class gui::LOMMControlDialog;
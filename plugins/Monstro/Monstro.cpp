@@ -1032,7 +1032,7 @@ void MonstroInstrument::playNote( NotePlayHandle * _n,
 
 	if (!_n->m_pluginData)
 	{
-		_n->m_pluginData = new MonstroSynth( this, _n );
+		_n->m_pluginData = m_synthPool.create( this, _n );
 	}
 
 	auto ms = static_cast<MonstroSynth*>(_n->m_pluginData);
@@ -1044,7 +1044,7 @@ void MonstroInstrument::playNote( NotePlayHandle * _n,
 
 void MonstroInstrument::deleteNotePluginData( NotePlayHandle * _n )
 {
-	delete static_cast<MonstroSynth *>( _n->m_pluginData );
+	m_synthPool.destroy( static_cast<MonstroSynth *>( _n->m_pluginData ) );
 }
 
 
@@ -37,6 +37,7 @@
 #include "Oscillator.h"
 #include "lmms_math.h"
 #include "BandLimitedWave.h"
+#include "NotePluginDataPool.h"
 
 //
 //	UI Macros
@@ -577,6 +578,8 @@ private:
 	FloatModel	m_sub3lfo1;
 	FloatModel	m_sub3lfo2;
 
+	NotePluginDataPool<MonstroSynth> m_synthPool;
+
 	friend class MonstroSynth;
 	friend class gui::MonstroView;
 
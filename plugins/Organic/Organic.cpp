@@ -231,7 +231,7 @@ void OrganicInstrument::playNote( NotePlayHandle * _n,
 		auto oscs_l = std::array<Oscillator*, NUM_OSCILLATORS>{};
 		auto oscs_r = std::array<Oscillator*, NUM_OSCILLATORS>{};
 
-		_n->m_pluginData = new oscPtr;
+		_n->m_pluginData = m_oscPtrPool.create();
 
 		for( int i = m_numOscillators - 1; i >= 0; --i )
 		{
@@ -245,7 +245,7 @@ void OrganicInstrument::playNote( NotePlayHandle * _n,
 			if( i == m_numOscillators - 1 )
 			{
 				// create left oscillator
-				oscs_l[i] = new Oscillator(
+				oscs_l[i] = m_oscillatorPool.create(
 						&m_osc[i]->m_waveShape,
 						&m_modulationAlgo,
 						_n->frequency(),
@@ -253,7 +253,7 @@ void OrganicInstrument::playNote( NotePlayHandle * _n,
 						static_cast<oscPtr *>( _n->m_pluginData )->phaseOffsetLeft[i],
 						m_osc[i]->m_volumeLeft );
 				// create right oscillator
-				oscs_r[i] = new Oscillator(
+				oscs_r[i] = m_oscillatorPool.create(
 						&m_osc[i]->m_waveShape,
 						&m_modulationAlgo,
 						_n->frequency(),
@@ -264,7 +264,7 @@ void OrganicInstrument::playNote( NotePlayHandle * _n,
 			else
 			{
 				// create left oscillator
-				oscs_l[i] = new Oscillator(
+				oscs_l[i] = m_oscillatorPool.create(
 						&m_osc[i]->m_waveShape,
 						&m_modulationAlgo,
 						_n->frequency(),
@@ -273,7 +273,7 @@ void OrganicInstrument::playNote( NotePlayHandle * _n,
 						m_osc[i]->m_volumeLeft,
 						oscs_l[i + 1] );
 				// create right oscillator
-				oscs_r[i] = new Oscillator(
+				oscs_r[i] = m_oscillatorPool.create(
 						&m_osc[i]->m_waveShape,
 						&m_modulationAlgo,
 						_n->frequency(),
@@ -318,12 +318,10 @@ void OrganicInstrument::playNote( NotePlayHandle * _n,
 
 void OrganicInstrument::deleteNotePluginData( NotePlayHandle * _n )
 {
-	delete static_cast<Oscillator *>( static_cast<oscPtr *>(
-						_n->m_pluginData )->oscLeft );
-	delete static_cast<Oscillator *>( static_cast<oscPtr *>(
-						_n->m_pluginData )->oscRight );
-
-	delete static_cast<oscPtr *>( _n->m_pluginData );
+	auto ptr = static_cast<oscPtr *>( _n->m_pluginData );
+	Oscillator::destroyChain( ptr->oscLeft, m_oscillatorPool );
+	Oscillator::destroyChain( ptr->oscRight, m_oscillatorPool );
+	m_oscPtrPool.destroy( ptr );
 }
 
 /*float inline OrganicInstrument::foldback(float in, float threshold)
@@ -30,6 +30,8 @@
 #include "Instrument.h"
 #include "InstrumentView.h"
 #include "AutomatableModel.h"
+#include "NotePluginDataPool.h"
+#include "Oscillator.h"
 
 class QPixmap;
 
@@ -38,7 +40,6 @@ namespace lmms
 
 
 class NotePlayHandle;
-class Oscillator;
 
 namespace gui
 {
@@ -166,6 +167,10 @@ private:
 		float phaseOffsetRight[NUM_OSCILLATORS];		
 	} ;
 
+	NotePluginDataPool<oscPtr> m_oscPtrPool;
+	NotePluginDataPool<Oscillator> m_oscillatorPool{
+		NotePluginDataPool<Oscillator>::DefaultCapacity * 2 * NUM_OSCILLATORS};
+
 	const IntModel m_modulationAlgo;
 
 	FloatModel  m_fx1Model;
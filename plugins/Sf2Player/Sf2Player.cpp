@@ -28,7 +28,9 @@
 #include <fluidsynth.h>
 #include <QDebug>
 #include <QDomElement>
+#include <QFileInfo>
 #include <QLabel>
+#include <QMutexLocker>
 
 #include "ArrayVector.h"
 #include "AudioEngine.h"
@@ -104,6 +106,28 @@ private:
 	float m_coarseTune;
 };
 
+/**
+ * A soundfont loaded by one of the synths and added to the synths of all other
+ * instruments playing the same file, so that it's only parsed and held in
+ * memory once. The last instrument using it unloads it.
+ */
+class Sf2Font
+{
+	MM_OPERATORS
+public:
+	explicit Sf2Font(fluid_sfont_t* f) :
+		fluidFont(f),
+		refCount(1)
+	{ }
+
+	fluid_sfont_t* fluidFont;
+	int refCount;
+};
+
+QMap<QString, Sf2Font*> Sf2Instrument::s_fonts;
+QMutex Sf2Instrument::s_fontsMutex;
+QMap<QString, std::shared_future<fluid_sfont_t*>> Sf2Instrument::s_prefetchedFonts;
+
 struct Sf2PluginData
 {
 	int midiNote;
@@ -371,7 +395,19 @@ void Sf2Instrument::freeFont()
 
 	if (m_font != nullptr)
 	{
-		fluid_synth_sfunload(m_synth, m_fontId, true);
+		QMutexLocker locker(&s_fontsMutex);
+		if (--m_font->refCount <= 0)
+		{
+			// Every synth adding the font gives it a new ID, so ask for its current one
+			fluid_synth_sfunload(m_synth, fluid_sfont_get_id(m_font->fluidFont), true);
+			s_fonts.remove(s_fonts.key(m_font));
+			delete m_font;
+		}
+		else
+		{
+			// Still in use by other instruments
+			fluid_synth_remove_sfont(m_synth, m_font->fluidFont);
+		}
 		m_font = nullptr;
 	}
 
@@ -385,8 +421,10 @@ void Sf2Instrument::openFile( const QString & _sf2File, bool updateTrackName )
 	emit fileLoading();
 
 	// Used for loading file
-	char * sf2Ascii = qstrdup( qPrintable( PathUtil::toAbsolute( _sf2File ) ) );
+	const QString absolutePath = PathUtil::toAbsolute( _sf2File );
+	char * sf2Ascii = qstrdup( qPrintable( absolutePath ) );
 	QString relativePath = PathUtil::toShortestRelative( _sf2File );
+	const QString key = fontKey( absolutePath );
 
 	// free the soundfont if one is selected
 	freeFont();
@@ -394,16 +432,43 @@ void Sf2Instrument::openFile( const QString & _sf2File, bool updateTrackName )
 	m_synthMutex.lock();
 
 	bool loaded = false;
-	if (fluid_is_soundfont(sf2Ascii))
 	{
-		m_fontId = fluid_synth_sfload(m_synth, sf2Ascii, true);
-
-		if (fluid_synth_sfcount(m_synth) > 0)
+		// Hold the lock while loading, so that instruments opening the same
+		// file at the same time wait for it instead of loading it again
+		QMutexLocker locker(&s_fontsMutex);
+		if (Sf2Font* font = s_fonts.value(key))
 		{
-			// Grab this sf from the top of the stack and add to list
-			m_font = fluid_synth_get_sfont(m_synth, 0);
+			m_font = font;
+			++m_font->refCount;
+			m_fontId = fluid_synth_add_sfont(m_synth, m_font->fluidFont);
 			loaded = true;
 		}
+		else
+		{
+			// Loaded by prefetchFont() on a thread which doesn't need the lock
+			fluid_sfont_t* prefetched = s_prefetchedFonts.contains(key)
+				? s_prefetchedFonts.take(key).get() : nullptr;
+
+			if (prefetched != nullptr)
+			{
+				m_font = new Sf2Font(prefetched);
+				s_fonts.insert(key, m_font);
+				m_fontId = fluid_synth_add_sfont(m_synth, m_font->fluidFont);
+				loaded = true;
+			}
+			else if (fluid_is_soundfont(sf2Ascii))
+			{
+				m_fontId = fluid_synth_sfload(m_synth, sf2Ascii, true);
+
+				if (fluid_synth_sfcount(m_synth) > 0)
+				{
+					// Grab this sf from the top of the stack and add to list
+					m_font = new Sf2Font(fluid_synth_get_sfont(m_synth, 0));
+					s_fonts.insert(key, m_font);
+					loaded = true;
+				}
+			}
+		}
 	}
 
 	if (!loaded)
@@ -437,11 +502,85 @@ void Sf2Instrument::openFile( const QString & _sf2File, bool updateTrackName )
 
 
 
+QString Sf2Instrument::fontKey( const QString & absolutePath )
+{
+	// Different paths to the same file share the font
+	const QString canonicalPath = QFileInfo( absolutePath ).canonicalFilePath();
+	return canonicalPath.isEmpty() ? absolutePath : canonicalPath;
+}
+
+
+
+
+void Sf2Instrument::prefetchFont( const QDomElement & _this )
+{
+	const QString absolutePath = PathUtil::toAbsolute( _this.attribute( "src" ) );
+	if( absolutePath.isEmpty() )
+	{
+		return;
+	}
+	const QString key = fontKey( absolutePath );
+
+	QMutexLocker locker( &s_fontsMutex );
+	if( s_fonts.contains( key ) || s_prefetchedFonts.contains( key ) )
+	{
+		return;
+	}
+
+	const QByteArray file = absolutePath.toLocal8Bit();
+	s_prefetchedFonts.insert( key, std::async( std::launch::async, [file]() -> fluid_sfont_t*
+	{
+		if( !fluid_is_soundfont( file.constData() ) )
+		{
+			return nullptr;
+		}
+
+		// A synth of its own loads the font and hands it over to the
+		// synth of the instrument opening it
+		fluid_settings_t* settings = new_fluid_settings();
+		fluid_synth_t* synth = new_fluid_synth( settings );
+		fluid_sfont_t* font = nullptr;
+		if( fluid_synth_sfload( synth, file.constData(), false ) >= 0 )
+		{
+			font = fluid_synth_get_sfont( synth, 0 );
+			fluid_synth_remove_sfont( synth, font );
+		}
+		delete_fluid_synth( synth );
+		delete_fluid_settings( settings );
+		return font;
+	} ).share() );
+}
+
+
+
+
+void Sf2Instrument::dropPrefetchedFonts()
+{
+	QMap<QString, std::shared_future<fluid_sfont_t*>> prefetched;
+	{
+		QMutexLocker locker( &s_fontsMutex );
+		prefetched.swap( s_prefetchedFonts );
+	}
+
+	for( const auto& font : prefetched )
+	{
+		if( font.get() != nullptr )
+		{
+			delete_fluid_sfont( font.get() );
+		}
+	}
+}
+
+
+
+
 void Sf2Instrument::updatePatch()
 {
 	if( m_bankNum.value() >= 0 && m_patchNum.value() >= 0 )
 	{
-		fluid_synth_program_select( m_synth, m_channel, m_fontId,
+		// Other synths adding the shared font change its ID
+		const int fontId = m_font != nullptr ? fluid_sfont_get_id( m_font->fluidFont ) : m_fontId;
+		fluid_synth_program_select( m_synth, m_channel, fontId,
 				m_bankNum.value(), m_patchNum.value() );
 	}
 }
@@ -582,12 +721,12 @@ void Sf2Instrument::reloadSynth()
 	{
 		// Now, delete the old one and replace
 		m_synthMutex.lock();
-		fluid_synth_remove_sfont( m_synth, m_font );
+		fluid_synth_remove_sfont( m_synth, m_font->fluidFont );
 		delete_fluid_synth( m_synth );
 
 		// New synth
 		m_synth = new_fluid_synth( m_settings );
-		m_fontId = fluid_synth_add_sfont( m_synth, m_font );
+		m_fontId = fluid_synth_add_sfont( m_synth, m_font->fluidFont );
 		m_synthMutex.unlock();
 
 		// synth program change (set bank and patch)
@@ -1244,6 +1383,16 @@ PLUGIN_EXPORT Plugin * lmms_plugin_main( Model *m, void * )
 {
 	return new Sf2Instrument( static_cast<InstrumentTrack *>( m ) );
 }
+
+PLUGIN_EXPORT void lmms_plugin_prefetch( const QDomElement & settings )
+{
+	Sf2Instrument::prefetchFont( settings );
+}
+
+PLUGIN_EXPORT void lmms_plugin_drop_prefetched()
+{
+	Sf2Instrument::dropPrefetchedFonts();
+}
 }
 
 
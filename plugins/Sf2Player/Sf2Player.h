@@ -27,7 +27,9 @@
 #ifndef SF2_PLAYER_H
 #define SF2_PLAYER_H
 
+#include <future>
 #include <fluidsynth/types.h>
+#include <QMap>
 #include <QMutex>
 #include <samplerate.h>
 
@@ -98,6 +100,12 @@ public:
 
 	void setParameter( const QString & _param, const QString & _value );
 
+	//! Starts loading the soundfont the settings refer to on another thread,
+	//! so that openFile() only has to wait for it
+	static void prefetchFont( const QDomElement & _this );
+	//! Unloads the prefetched soundfonts no instrument has opened
+	static void dropPrefetchedFonts();
+
 
 public slots:
 	void openFile( const QString & _sf2File, bool updateTrackName = true );
@@ -119,7 +127,7 @@ private:
 	fluid_settings_t* m_settings;
 	fluid_synth_t* m_synth;
 
-	fluid_sfont_t* m_font;
+	Sf2Font* m_font;
 
 	int m_fontId;
 	QString m_filename;
@@ -157,7 +165,14 @@ private:
 	QVector<NotePlayHandle *> m_playingNotes;
 	QMutex m_playingNotesMutex;
 
+	//! The loaded soundfonts by file, shared by all instruments playing them
+	static QMap<QString, Sf2Font*> s_fonts;
+	static QMutex s_fontsMutex;
+	//! Soundfonts being loaded by prefetchFont(), guarded by s_fontsMutex
+	static QMap<QString, std::shared_future<fluid_sfont_t*>> s_prefetchedFonts;
+
 private:
+	static QString fontKey( const QString & absolutePath );
 	void freeFont();
 	void noteOn( Sf2PluginData * n );
 	void noteOff( Sf2PluginData * n );
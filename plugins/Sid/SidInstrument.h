@@ -30,6 +30,9 @@
 #include "AutomatableModel.h"
 #include "Instrument.h"
 #include "InstrumentView.h"
+#include "NotePluginDataPool.h"
+
+#include "sid.h"
 
 namespace lmms
 {
@@ -136,6 +139,8 @@ private:
 
 	IntModel m_chipModel;
 
+	NotePluginDataPool<reSID::SID> m_sidPool;
+
 	friend class gui::SidInstrumentView;
 
 } ;
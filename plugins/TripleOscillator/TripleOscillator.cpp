@@ -127,6 +127,8 @@ OscillatorObject::OscillatorObject( Model * _parent, int _idx ) :
 			this, SLOT( updatePhaseOffsetLeft() ), Qt::DirectConnection );
 	connect ( &m_useWaveTableModel, SIGNAL(dataChanged()),
 			this, SLOT( updateUseWaveTable()));
+	connect(&m_waveShapeModel, SIGNAL(dataChanged()),
+			this, SLOT(updateUserAntiAliasWaveTable()));
 
 	updatePhaseOffsetLeft();
 	updatePhaseOffsetRight();
@@ -217,6 +219,16 @@ void OscillatorObject::updatePhaseOffsetRight()
 void OscillatorObject::updateUseWaveTable()
 {
 	m_useWaveTable = m_useWaveTableModel.value();
+	updateUserAntiAliasWaveTable();
+}
+
+void OscillatorObject::updateUserAntiAliasWaveTable()
+{
+	// only build the band-limited tables once the sample is actually played as a wave
+	if (m_useWaveTable && m_waveShapeModel.value() == static_cast<int>(Oscillator::WaveShape::UserDefined))
+	{
+		m_sampleBuffer->enableUserAntiAliasWaveTable();
+	}
 }
 
 
@@ -319,7 +331,7 @@ void TripleOscillator::playNote( NotePlayHandle * _n,
 			// the last oscs needs no sub-oscs...
 			if( i == NUM_OF_OSCILLATORS - 1 )
 			{
-				oscs_l[i] = new Oscillator(
+				oscs_l[i] = m_oscillatorPool.create(
 						&m_osc[i]->m_waveShapeModel,
 						&m_osc[i]->m_modulationAlgoModel,
 						_n->frequency(),
@@ -327,7 +339,7 @@ void TripleOscillator::playNote( NotePlayHandle * _n,
 						m_osc[i]->m_phaseOffsetLeft,
 						m_osc[i]->m_volumeLeft );
 				oscs_l[i]->setUseWaveTable(m_osc[i]->m_useWaveTable);
-				oscs_r[i] = new Oscillator(
+				oscs_r[i] = m_oscillatorPool.create(
 						&m_osc[i]->m_waveShapeModel,
 						&m_osc[i]->m_modulationAlgoModel,
 						_n->frequency(),
@@ -338,7 +350,7 @@ void TripleOscillator::playNote( NotePlayHandle * _n,
 			}
 			else
 			{
-				oscs_l[i] = new Oscillator(
+				oscs_l[i] = m_oscillatorPool.create(
 						&m_osc[i]->m_waveShapeModel,
 						&m_osc[i]->m_modulationAlgoModel,
 						_n->frequency(),
@@ -347,7 +359,7 @@ void TripleOscillator::playNote( NotePlayHandle * _n,
 						m_osc[i]->m_volumeLeft,
 						oscs_l[i + 1] );
 				oscs_l[i]->setUseWaveTable(m_osc[i]->m_useWaveTable);
-				oscs_r[i] = new Oscillator(
+				oscs_r[i] = m_oscillatorPool.create(
 						&m_osc[i]->m_waveShapeModel,
 						&m_osc[i]->m_modulationAlgoModel,
 						_n->frequency(),
@@ -363,7 +375,7 @@ void TripleOscillator::playNote( NotePlayHandle * _n,
 
 		}
 
-		_n->m_pluginData = new oscPtr;
+		_n->m_pluginData = m_oscPtrPool.create();
 		static_cast<oscPtr *>( _n->m_pluginData )->oscLeft = oscs_l[0];
 		static_cast< oscPtr *>( _n->m_pluginData )->oscRight =
 								oscs_r[0];
@@ -387,11 +399,10 @@ void TripleOscillator::playNote( NotePlayHandle * _n,
 
 void TripleOscillator::deleteNotePluginData( NotePlayHandle * _n )
 {
-	delete static_cast<Oscillator *>( static_cast<oscPtr *>(
-						_n->m_pluginData )->oscLeft );
-	delete static_cast<Oscillator *>( static_cast<oscPtr *>(
-						_n->m_pluginData )->oscRight );
-	delete static_cast<oscPtr *>( _n->m_pluginData );
+	auto ptr = static_cast<oscPtr *>( _n->m_pluginData );
+	Oscillator::destroyChain( ptr->oscLeft, m_oscillatorPool );
+	Oscillator::destroyChain( ptr->oscRight, m_oscillatorPool );
+	m_oscPtrPool.destroy( ptr );
 }
 
 
@@ -29,6 +29,8 @@
 #include "Instrument.h"
 #include "InstrumentView.h"
 #include "AutomatableModel.h"
+#include "NotePluginDataPool.h"
+#include "Oscillator.h"
 
 namespace lmms
 {
@@ -36,7 +38,6 @@ namespace lmms
 
 class NotePlayHandle;
 class SampleBuffer;
-class Oscillator;
 
 
 namespace gui
@@ -97,6 +98,7 @@ private slots:
 	void updatePhaseOffsetLeft();
 	void updatePhaseOffsetRight();
 	void updateUseWaveTable();
+	void updateUserAntiAliasWaveTable();
 
 } ;
 
@@ -142,6 +144,9 @@ private:
 		Oscillator * oscRight;
 	} ;
 
+	NotePluginDataPool<oscPtr> m_oscPtrPool;
+	NotePluginDataPool<Oscillator> m_oscillatorPool{
+		NotePluginDataPool<Oscillator>::DefaultCapacity * 2 * NUM_OF_OSCILLATORS};
 
 	friend class gui::TripleOscillatorView;
 
@@ -63,9 +63,7 @@ Plugin::Descriptor PLUGIN_EXPORT watsyn_plugin_descriptor =
 
 
 
-WatsynObject::WatsynObject( float * _A1wave, float * _A2wave,
-					float * _B1wave, float * _B2wave,
-					int _amod, int _bmod, const sample_rate_t _samplerate, NotePlayHandle * _nph, fpp_t _frames,
+WatsynObject::WatsynObject( int _amod, int _bmod, const sample_rate_t _samplerate, NotePlayHandle * _nph, fpp_t _frames,
 					WatsynInstrument * _w ) :
 				m_amod( _amod ),
 				m_bmod( _bmod ),
@@ -87,12 +85,23 @@ WatsynObject::WatsynObject( float * _A1wave, float * _A2wave,
 	m_rphase[B1_OSC] = 0.0f;
 	m_rphase[B2_OSC] = 0.0f;
 
-	// copy wavegraphs to the synth object to prevent race conditions
-
-	memcpy( &m_A1wave, _A1wave, sizeof( m_A1wave ) );
-	memcpy( &m_A2wave, _A2wave, sizeof( m_A2wave ) );
-	memcpy( &m_B1wave, _B1wave, sizeof( m_B1wave ) );
-	memcpy( &m_B2wave, _B2wave, sizeof( m_B2wave ) );
+	// keep playing the tables the note started with, even if they're
+	// replaced meanwhile. A table whose last reference was just dropped
+	// stays valid until the end of this period, but it's not published
+	// anymore, so its replacement is.
+	for( int i = 0; i < NUM_OSCS; ++i )
+	{
+		WatsynWave * wave;
+		do
+		{
+			wave = m_parent->m_waves[i].load();
+		} while( !wave->tryRef() );
+		m_waves[i] = wave;
+	}
+	m_A1wave = m_waves[A1_OSC]->samples.data();
+	m_A2wave = m_waves[A2_OSC]->samples.data();
+	m_B1wave = m_waves[B1_OSC]->samples.data();
+	m_B2wave = m_waves[B2_OSC]->samples.data();
 }
 
 
@@ -101,6 +110,11 @@ WatsynObject::~WatsynObject()
 {
 	delete[] m_abuf;
 	delete[] m_bbuf;
+
+	for( auto wave : m_waves )
+	{
+		wave->unref();
+	}
 }
 
 
@@ -319,6 +333,10 @@ WatsynInstrument::WatsynInstrument( InstrumentTrack * _instrument_track ) :
 	updateFreqA2();
 	updateFreqB1();
 	updateFreqB2();
+	for( auto & wave : m_waves )
+	{
+		wave = nullptr;
+	}
 	updateWaveA1();
 	updateWaveA2();
 	updateWaveB1();
@@ -326,12 +344,21 @@ WatsynInstrument::WatsynInstrument( InstrumentTrack * _instrument_track ) :
 }
 
 
+WatsynInstrument::~WatsynInstrument()
+{
+	for( auto & wave : m_waves )
+	{
+		wave.load()->unref();
+	}
+}
+
+
 void WatsynInstrument::playNote( NotePlayHandle * _n,
 						sampleFrame * _working_buffer )
 {
 	if (!_n->m_pluginData)
 	{
-		auto w = new WatsynObject(&A1_wave[0], &A2_wave[0], &B1_wave[0], &B2_wave[0], m_amod.value(), m_bmod.value(),
+		auto w = m_voicePool.create(m_amod.value(), m_bmod.value(),
 			Engine::audioEngine()->processingSampleRate(), _n, Engine::audioEngine()->framesPerPeriod(), this);
 
 		_n->m_pluginData = w;
@@ -450,7 +477,7 @@ void WatsynInstrument::playNote( NotePlayHandle * _n,
 
 void WatsynInstrument::deleteNotePluginData( NotePlayHandle * _n )
 {
-	delete static_cast<WatsynObject *>( _n->m_pluginData );
+	m_voicePool.destroy( static_cast<WatsynObject *>( _n->m_pluginData ) );
 }
 
 
@@ -627,29 +654,52 @@ void WatsynInstrument::updateFreqB2()
 
 void WatsynInstrument::updateWaveA1()
 {
-	// do sinc+oversampling on the wavetables to improve quality
-	srccpy( &A1_wave[0], const_cast<float*>( a1_graph.samples() ) );
+	publishWave( A1_OSC, a1_graph.samples() );
 }
 
 
 void WatsynInstrument::updateWaveA2()
 {
-	// do sinc+oversampling on the wavetables to improve quality
-	srccpy( &A2_wave[0], const_cast<float*>( a2_graph.samples() ) );
+	publishWave( A2_OSC, a2_graph.samples() );
 }
 
 
 void WatsynInstrument::updateWaveB1()
 {
-	// do sinc+oversampling on the wavetables to improve quality
-	srccpy( &B1_wave[0], const_cast<float*>( b1_graph.samples() ) );
+	publishWave( B1_OSC, b1_graph.samples() );
 }
 
 
 void WatsynInstrument::updateWaveB2()
+{
+	publishWave( B2_OSC, b2_graph.samples() );
+}
+
+
+void WatsynInstrument::publishWave( int _osc, const float * _samples )
 {
 	// do sinc+oversampling on the wavetables to improve quality
-	srccpy( &B2_wave[0], const_cast<float*>( b2_graph.samples() ) );
+	auto wave = new WatsynWave;
+	srccpy( wave->samples.data(), _samples );
+
+	// playing notes keep the previous wavetable until they end
+	WatsynWave * old = m_waves[_osc].exchange( wave );
+	if( old != nullptr )
+	{
+		old->unref();
+	}
+}
+
+
+
+
+void WatsynWave::unref()
+{
+	if( --m_refs == 0 )
+	{
+		// a voice might have read the pointer, but not taken a reference yet
+		Engine::audioEngine()->reclaimLater( this );
+	}
 }
 
 
@@ -26,6 +26,9 @@
 #ifndef WATSYN_H
 #define WATSYN_H
 
+#include <array>
+#include <atomic>
+
 #include "Instrument.h"
 #include "InstrumentView.h"
 #include "Graph.h"
@@ -33,6 +36,7 @@
 #include "TempoSyncKnob.h"
 #include <samplerate.h>
 #include "MemoryManager.h"
+#include "NotePluginDataPool.h"
 
 namespace lmms
 {
@@ -77,6 +81,30 @@ const int	B1_OSC = 2;
 const int	B2_OSC = 3;
 const int	NUM_OSCS = 4;
 
+//! An oversampled wavetable. Once published by the instrument it's never
+//! changed. The instrument and every voice that started with it hold a
+//! reference, the last one let go of hands it to AudioEngine::reclaimLater().
+class WatsynWave
+{
+	MM_OPERATORS
+public:
+	std::array<float, WAVELEN> samples;
+
+	//! Take a reference, unless the last one was let go of already - the
+	//! table isn't published anymore then
+	bool tryRef()
+	{
+		int refs = m_refs.load();
+		while( refs > 0 && !m_refs.compare_exchange_weak( refs, refs + 1 ) ) {}
+		return refs > 0;
+	}
+
+	void unref();
+
+private:
+	std::atomic<int> m_refs{1};
+};
+
 class WatsynInstrument;
 
 namespace gui
@@ -90,9 +118,7 @@ class WatsynObject
 {
 	MM_OPERATORS
 public:
-	WatsynObject( 	float * _A1wave, float * _A2wave,
-					float * _B1wave, float * _B2wave,
-					int _amod, int _bmod, const sample_rate_t _samplerate, NotePlayHandle * _nph, fpp_t _frames,
+	WatsynObject( int _amod, int _bmod, const sample_rate_t _samplerate, NotePlayHandle * _nph, fpp_t _frames,
 					WatsynInstrument * _w );
 	virtual ~WatsynObject();
 
@@ -128,10 +154,12 @@ private:
 	float m_lphase [NUM_OSCS];
 	float m_rphase [NUM_OSCS];
 
-	float m_A1wave [WAVELEN];
-	float m_A2wave [WAVELEN];
-	float m_B1wave [WAVELEN];
-	float m_B2wave [WAVELEN];
+	// the wavetables the note started with, see WatsynWave
+	WatsynWave * m_waves [NUM_OSCS];
+	const float * m_A1wave;
+	const float * m_A2wave;
+	const float * m_B1wave;
+	const float * m_B2wave;
 };
 
 class WatsynInstrument : public Instrument
@@ -139,7 +167,7 @@ class WatsynInstrument : public Instrument
 	Q_OBJECT
 public:
 	WatsynInstrument( InstrumentTrack * _instrument_track );
-	~WatsynInstrument() override = default;
+	~WatsynInstrument() override;
 
 	void playNote( NotePlayHandle * _n,
 						sampleFrame * _working_buffer ) override;
@@ -188,8 +216,12 @@ private:
 		return ( _pan >= 0 ? 1.0 : 1.0 + ( _pan / 100.0 ) ) * _vol / 100.0;
 	}
 
+	//! Oversamples the graph @p _samples and publishes it as the new
+	//! wavetable of the oscillator @p _osc
+	void publishWave( int _osc, const float * _samples );
+
 	// memcpy utilizing libsamplerate (src) for sinc interpolation
-	inline void srccpy( float * _dst, float * _src )
+	inline void srccpy( float * _dst, const float * _src )
 	{
 		int err;
 		const int margin = 64;
@@ -290,10 +322,10 @@ private:
 
 	IntModel m_selectedGraph;
 	
-	float A1_wave [WAVELEN];
-	float A2_wave [WAVELEN];
-	float B1_wave [WAVELEN];
-	float B2_wave [WAVELEN];
+	// replaced by the GUI thread while the audio threads start notes
+	std::atomic<WatsynWave *> m_waves [NUM_OSCS];
+
+	NotePluginDataPool<WatsynObject> m_voicePool;
 
 	friend class WatsynObject;
 	friend class gui::WatsynView;
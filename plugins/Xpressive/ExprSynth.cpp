@@ -520,12 +520,34 @@ struct harmonic_semitone
 static freefunc1<float,harmonic_semitone,true> harmonic_semitone_func;
 
 
+size_t find_occurances(const std::string& haystack, const char* const needle)
+{
+	size_t last_pos = 0;
+	size_t count = 0;
+	const size_t len = strlen(needle);
+	if (len > 0)
+	{
+		while (last_pos + len <= haystack.length())
+		{
+			last_pos = haystack.find(needle, last_pos);
+			if (last_pos == std::string::npos)
+				break;
+			++count;
+			last_pos += len;
+		}
+	}
+	return count;
+}
+
+
 ExprFront::ExprFront(const char * expr, int last_func_samples)
 {
 	m_valid = false;
 	try
 	{
-		m_data = new ExprFrontData(last_func_samples);
+		// the history of the "last" function is only needed if it's used,
+		// zeroing it for every note is not for free
+		m_data = new ExprFrontData(find_occurances(expr, "last") > 0 ? last_func_samples : 1);
 
 		m_data->m_expression_string = expr;
 		m_data->m_symbol_table.add_pi();
@@ -651,24 +673,6 @@ bool ExprFront::add_cyclic_vector(const char* name, const float* data, size_t le
 	}
 	return false;
 }
-size_t find_occurances(const std::string& haystack, const char* const needle)
-{
-	size_t last_pos = 0;
-	size_t count = 0;
-	const size_t len = strlen(needle);
-	if (len > 0)
-	{
-		while (last_pos + len <= haystack.length())
-		{
-			last_pos = haystack.find(needle, last_pos);
-			if (last_pos == std::string::npos)
-				break;
-			++count;
-			last_pos += len;
-		}
-	}
-	return count;
-}
 
 void ExprFront::setIntegrate(const unsigned int* const frameCounter, const unsigned int sample_rate)
 {
@@ -757,6 +761,7 @@ void ExprSynth::renderOutput(fpp_t frames, sampleFrame *buf)
 		const float new_freq = m_nph->frequency();
 		const float freq_inc = (new_freq - m_frequency) / frames;
 		const bool is_released = m_nph->isReleased();
+		const float sample_rate_inv = 1.0f / m_sample_rate;
 
 		expression_t *o1_rawExpr = &(m_exprO1->getData()->m_expression);
 		expression_t *o2_rawExpr = &(m_exprO2->getData()->m_expression);
@@ -781,10 +786,10 @@ void ExprSynth::renderOutput(fpp_t frames, sampleFrame *buf)
 				buf[frame][0] = (-pn1 + 0.5) * o1 + (-pn2 + 0.5) * o2;
 				buf[frame][1] = ( pn1 + 0.5) * o1 + ( pn2 + 0.5) * o2;
 				m_note_sample++;
-				m_note_sample_sec = m_note_sample / (float)m_sample_rate;
+				m_note_sample_sec = m_note_sample * sample_rate_inv;
 				if (is_released)
 				{
-					m_note_rel_sec = (m_note_sample - m_note_rel_sample) / (float)m_sample_rate;
+					m_note_rel_sec = (m_note_sample - m_note_rel_sample) * sample_rate_inv;
 				}
 				m_frequency += freq_inc;
 			}
@@ -809,10 +814,10 @@ void ExprSynth::renderOutput(fpp_t frames, sampleFrame *buf)
 				buf[frame][0] = (-pn1 + 0.5) * o1;
 				buf[frame][1] = ( pn1 + 0.5) * o1;
 				m_note_sample++;
-				m_note_sample_sec = m_note_sample / (float)m_sample_rate;
+				m_note_sample_sec = m_note_sample * sample_rate_inv;
 				if (is_released)
 				{
-					m_note_rel_sec = (m_note_sample - m_note_rel_sample) / (float)m_sample_rate;
+					m_note_rel_sec = (m_note_sample - m_note_rel_sample) * sample_rate_inv;
 				}
 				m_frequency += freq_inc;
 			}
@@ -24,6 +24,8 @@
 
 #include "AudioEngine.h"
 
+#include <cstdlib>
+
 #include "denormals.h"
 
 #include "lmmsconfig.h"
@@ -33,8 +35,10 @@
 #include "Mixer.h"
 #include "Song.h"
 #include "EnvelopeAndLfoParameters.h"
+#include "lmms_math.h"
 #include "NotePlayHandle.h"
 #include "ConfigManager.h"
+#include "Controller.h"
 #include "SamplePlayHandle.h"
 #include "MemoryHelper.h"
 
@@ -66,14 +70,24 @@ namespace lmms
 
 using LocklessListElement = LocklessList<PlayHandle*>::Element;
 
+using ModelChangeListElement = LocklessList<std::function<void()>*>::Element;
+
 static thread_local bool s_renderingThread;
 static thread_local bool s_runningChange;
 
+// capacities of the lock-free queues for model changes and retired objects
+static const std::size_t MODEL_CHANGE_QUEUE_SIZE = 1024;
+static const std::size_t RECLAIM_QUEUE_SIZE = 4096;
+// how often the reclaimer thread looks for objects to destroy
+static const unsigned long RECLAIM_INTERVAL_MS = 20;
+
 
 
 
 AudioEngine::AudioEngine( bool renderOnly ) :
 	m_renderOnly( renderOnly ),
+	m_deterministic( false ),
+	m_audioPorts( new AudioPortList ),
 	m_framesPerPeriod( DEFAULT_BUFFER_SIZE ),
 	m_inputBufferRead( 0 ),
 	m_inputBufferWrite( 1 ),
@@ -89,7 +103,12 @@ AudioEngine::AudioEngine( bool renderOnly ) :
 	m_audioDevStartFailed( false ),
 	m_profiler(),
 	m_metronomeActive(false),
-	m_clearSignal(false)
+	m_clearSignal(false),
+	m_modelChanges(MODEL_CHANGE_QUEUE_SIZE),
+	m_retiredObjects(RECLAIM_QUEUE_SIZE),
+	m_periodsStarted(0),
+	m_periodsFinished(0),
+	m_reclaimer(nullptr)
 {
 	for( int i = 0; i < 2; ++i )
 	{
@@ -152,6 +171,9 @@ AudioEngine::AudioEngine( bool renderOnly ) :
 		}
 		m_workers.push_back( wt );
 	}
+
+	m_reclaimer = new Reclaimer(this);
+	m_reclaimer->start(QThread::LowPriority);
 }
 
 
@@ -180,6 +202,14 @@ AudioEngine::~AudioEngine()
 	delete m_midiClient;
 	delete m_audioDev;
 
+	// no more rendering, so everything left can be destroyed now
+	m_reclaimer->finish();
+	m_reclaimer->wait();
+	delete m_reclaimer;
+	applyModelChanges();
+	reclaim(true);
+	delete m_audioPorts.load();
+
 	MemoryHelper::alignedFree(m_outputBufferRead);
 	MemoryHelper::alignedFree(m_outputBufferWrite);
 
@@ -213,7 +243,7 @@ void AudioEngine::initDevices()
 
 void AudioEngine::startProcessing(bool needsFifo)
 {
-	if (needsFifo)
+	if (needsFifo && m_audioDev->needsFifo())
 	{
 		m_fifoWriter = new fifoWriter( this, m_fifo );
 		m_fifoWriter->start( QThread::HighPriority );
@@ -336,24 +366,22 @@ void AudioEngine::renderStageNoteSetup()
 
 	// remove all play-handles that have to be deleted and delete
 	// them if they still exist...
-	// maybe this algorithm could be optimized...
-	ConstPlayHandleList::Iterator it_rem = m_playHandlesToRemove.begin();
-	while( it_rem != m_playHandlesToRemove.end() )
+	if (!m_playHandlesToRemove.isEmpty())
 	{
-		PlayHandleList::Iterator it = std::find( m_playHandles.begin(), m_playHandles.end(), *it_rem );
-
-		if( it != m_playHandles.end() )
+		PlayHandleList toRemove;
+		toRemove.swap(m_playHandlesToRemove);
+		for (const auto ph : toRemove)
 		{
-			( *it )->audioPort()->removePlayHandle( ( *it ) );
-			if( ( *it )->type() == PlayHandle::Type::NotePlayHandle )
+			ph->m_removalIndex = -1;
+		}
+		for (const auto ph : toRemove)
+		{
+			if (ph->m_engineIndex >= 0)
 			{
-				NotePlayHandleManager::release( (NotePlayHandle*) *it );
+				takePlayHandle(ph);
+				retirePlayHandle(ph);
 			}
-			else delete *it;
-			m_playHandles.erase( it );
 		}
-
-		it_rem = m_playHandlesToRemove.erase( it_rem );
 	}
 
 	swapBuffers();
@@ -370,7 +398,7 @@ void AudioEngine::renderStageNoteSetup()
 	// add all play-handles that have to be added
 	for( LocklessListElement * e = m_newPlayHandles.popList(); e; )
 	{
-		m_playHandles += e->value;
+		appendPlayHandle(e->value);
 		LocklessListElement * next = e->next;
 		m_newPlayHandles.free( e );
 		e = next;
@@ -394,32 +422,22 @@ void AudioEngine::renderStageEffects()
 	AudioEngineProfiler::Probe profilerProbe(m_profiler, AudioEngineProfiler::DetailType::Effects);
 
 	// STAGE 2: process effects of all instrument- and sampletracks
-	AudioEngineWorkerThread::fillJobQueue(m_audioPorts);
+	AudioEngineWorkerThread::fillJobQueue(*m_audioPorts.load());
 	AudioEngineWorkerThread::startAndWaitForJobs();
 
 	// removed all play handles which are done
-	for( PlayHandleList::Iterator it = m_playHandles.begin();
-						it != m_playHandles.end(); )
+	for (int i = 0; i < m_playHandles.size();)
 	{
-		if( ( *it )->affinityMatters() &&
-			( *it )->affinity() != QThread::currentThread() )
-		{
-			++it;
-			continue;
-		}
-		if( ( *it )->isFinished() )
+		PlayHandle* ph = m_playHandles[i];
+		if (ph->isFinished() && !(ph->affinityMatters() && ph->affinity() != QThread::currentThread()))
 		{
-			( *it )->audioPort()->removePlayHandle( ( *it ) );
-			if( ( *it )->type() == PlayHandle::Type::NotePlayHandle )
-			{
-				NotePlayHandleManager::release( (NotePlayHandle*) *it );
-			}
-			else delete *it;
-			it = m_playHandles.erase( it );
+			// the last handle moves into this slot, so check it next
+			takePlayHandle(ph);
+			retirePlayHandle(ph);
 		}
 		else
 		{
-			++it;
+			++i;
 		}
 	}
 }
@@ -447,15 +465,19 @@ const surroundSampleFrame *AudioEngine::renderNextBuffer()
 {
 	const auto lock = std::lock_guard{m_changeMutex};
 
+	++m_periodsStarted;
 	m_profiler.startPeriod();
 	s_renderingThread = true;
 
+	applyModelChanges();
+
 	renderStageNoteSetup();     // STAGE 0: clear old play handles and buffers, setup new play handles
 	renderStageInstruments();   // STAGE 1: run and render all play handles
 	renderStageEffects();       // STAGE 2: process effects of all instrument- and sampletracks
 	renderStageMix();           // STAGE 3: do master mix in mixer
 
 	s_renderingThread = false;
+	++m_periodsFinished;
 	m_profiler.finishPeriod(processingSampleRate(), m_framesPerPeriod);
 
 	return m_outputBufferRead;
@@ -545,6 +567,39 @@ void AudioEngine::clearNewPlayHandles()
 
 
 
+void AudioEngine::setDeterministic( bool deterministic )
+{
+	requestChangeInModel();
+
+	// the order in which the worker threads finish their jobs changes the
+	// order of summing the buffers
+	AudioEngineWorkerThread::setProcessInline( deterministic );
+	m_deterministic = deterministic;
+
+	if( deterministic )
+	{
+		// every generator used while rendering, in the order of the jobs.
+		// fast_rand() has a state per thread, but all jobs run on this one
+		// now, and each track draws from a generator of its own
+		std::srand( 1 );
+		fastRandSeed( 1 );
+		unsigned long seed = 1;
+		for( AudioPort* port : *m_audioPorts.load() )
+		{
+			port->seedRand( ++seed );
+		}
+
+		EnvelopeAndLfoParameters::instances()->reset();
+		Controller::resetFrameCounter();
+		AutomatableModel::resetPeriodCounter();
+	}
+
+	doneChangeInModel();
+}
+
+
+
+
 // removes all play-handles. this is necessary, when the song is stopped ->
 // all remaining notes etc. would be played until their end
 void AudioEngine::clearInternal()
@@ -554,7 +609,7 @@ void AudioEngine::clearInternal()
 	{
 		if (ph->type() != PlayHandle::Type::InstrumentPlayHandle)
 		{
-			m_playHandlesToRemove.push_back(ph);
+			queuePlayHandleRemoval(ph);
 		}
 	}
 }
@@ -677,16 +732,46 @@ void AudioEngine::restoreAudioDevice()
 
 
 
-void AudioEngine::removeAudioPort(AudioPort * port)
+void AudioEngine::addAudioPort(AudioPort * port)
 {
-	requestChangeInModel();
+	const auto lock = std::lock_guard{m_audioPortsWriteMutex};
+
+	// publish a copy, the audio thread might still be using the current list
+	auto ports = new AudioPortList(*m_audioPorts.load());
+	ports->push_back(port);
+	reclaimLater(m_audioPorts.exchange(ports));
+}
+
+
 
-	auto it = std::find(m_audioPorts.begin(), m_audioPorts.end(), port);
-	if (it != m_audioPorts.end())
+
+void AudioEngine::removeAudioPort(AudioPort * port)
+{
 	{
-		m_audioPorts.erase(it);
+		const auto lock = std::lock_guard{m_audioPortsWriteMutex};
+
+		AudioPortList* ports = m_audioPorts.load();
+		auto it = std::find(ports->begin(), ports->end(), port);
+		if (it == ports->end())
+		{
+			return;
+		}
+
+		if (s_renderingThread)
+		{
+			// we are the only reader, so don't allocate in the audio thread
+			ports->erase(it);
+			return;
+		}
+
+		auto newPorts = new AudioPortList(*ports);
+		newPorts->erase(newPorts->begin() + (it - ports->begin()));
+		reclaimLater(m_audioPorts.exchange(newPorts));
 	}
-	doneChangeInModel();
+
+	// the port is usually destroyed right after, so make sure that the audio
+	// thread is done with it
+	synchronizeWithRender();
 }
 
 
@@ -742,10 +827,9 @@ void AudioEngine::removePlayHandle(PlayHandle * ph)
 			}
 		}
 		// Now check m_playHandles
-		PlayHandleList::Iterator it = std::find(m_playHandles.begin(), m_playHandles.end(), ph);
-		if (it != m_playHandles.end())
+		if (ph->m_engineIndex >= 0)
 		{
-			m_playHandles.erase(it);
+			takePlayHandle(ph);
 			removedFromList = true;
 		}
 		// Only deleting PlayHandles that were actually found in the list
@@ -753,16 +837,12 @@ void AudioEngine::removePlayHandle(PlayHandle * ph)
 		// (See tobydox's 2008 commit 4583e48)
 		if ( removedFromList )
 		{
-			if (ph->type() == PlayHandle::Type::NotePlayHandle)
-			{
-				NotePlayHandleManager::release(dynamic_cast<NotePlayHandle*>(ph));
-			}
-			else { delete ph; }
+			retirePlayHandle(ph);
 		}
 	}
 	else
 	{
-		m_playHandlesToRemove.push_back(ph);
+		queuePlayHandleRemoval(ph);
 	}
 	doneChangeInModel();
 }
@@ -773,22 +853,17 @@ void AudioEngine::removePlayHandle(PlayHandle * ph)
 void AudioEngine::removePlayHandlesOfTypes(Track * track, PlayHandle::Types types)
 {
 	requestChangeInModel();
-	PlayHandleList::Iterator it = m_playHandles.begin();
-	while( it != m_playHandles.end() )
+	for (int i = 0; i < m_playHandles.size();)
 	{
-		if ((*it)->isFromTrack(track) && ((*it)->type() & types))
+		PlayHandle* ph = m_playHandles[i];
+		if (ph->isFromTrack(track) && (ph->type() & types))
 		{
-			( *it )->audioPort()->removePlayHandle( ( *it ) );
-			if( ( *it )->type() == PlayHandle::Type::NotePlayHandle )
-			{
-				NotePlayHandleManager::release( (NotePlayHandle*) *it );
-			}
-			else delete *it;
-			it = m_playHandles.erase( it );
+			takePlayHandle(ph);
+			retirePlayHandle(ph);
 		}
 		else
 		{
-			++it;
+			++i;
 		}
 	}
 	doneChangeInModel();
@@ -797,11 +872,86 @@ void AudioEngine::removePlayHandlesOfTypes(Track * track, PlayHandle::Types type
 
 
 
+void AudioEngine::appendPlayHandle(PlayHandle* handle)
+{
+	handle->m_engineIndex = m_playHandles.size();
+	m_playHandles.append(handle);
+}
+
+
+
+
+void AudioEngine::takePlayHandle(PlayHandle* handle)
+{
+	// the order of the list doesn't matter, so fill the gap with the last
+	// handle instead of moving all following ones
+	const int index = handle->m_engineIndex;
+	PlayHandle* last = m_playHandles.takeLast();
+	if (last != handle)
+	{
+		last->m_engineIndex = index;
+		m_playHandles[index] = last;
+	}
+	handle->m_engineIndex = -1;
+}
+
+
+
+
+void AudioEngine::queuePlayHandleRemoval(PlayHandle* handle)
+{
+	// a handle is queued only once, so that retiring it can clear its entry
+	if (handle->m_removalIndex < 0)
+	{
+		handle->m_removalIndex = m_playHandlesToRemove.size();
+		m_playHandlesToRemove.push_back(handle);
+	}
+}
+
+
+
+
+void AudioEngine::retirePlayHandle(PlayHandle* handle)
+{
+	handle->audioPort()->removePlayHandle(handle);
+	if (handle->m_removalIndex >= 0)
+	{
+		// fill the gap with the last queued handle to keep the list dense
+		PlayHandle* last = m_playHandlesToRemove.takeLast();
+		if (last != handle)
+		{
+			last->m_removalIndex = handle->m_removalIndex;
+			m_playHandlesToRemove[handle->m_removalIndex] = last;
+		}
+		handle->m_removalIndex = -1;
+	}
+
+	if (handle->type() == PlayHandle::Type::NotePlayHandle)
+	{
+		NotePlayHandleManager::release(static_cast<NotePlayHandle*>(handle));
+	}
+	else if (s_renderingThread && handle->isReclaimable())
+	{
+		handle->detach();
+		// freeing samples and resamplers has no business on the audio thread
+		reclaimLater(handle);
+	}
+	else
+	{
+		delete handle;
+	}
+}
+
+
+
+
 void AudioEngine::requestChangeInModel()
 {
 	if (s_renderingThread || s_runningChange) { return; }
 	m_changeMutex.lock();
 	s_runningChange = true;
+	// changes posted before have to be applied before the model changes
+	applyModelChanges();
 }
 
 void AudioEngine::doneChangeInModel()
@@ -811,6 +961,115 @@ void AudioEngine::doneChangeInModel()
 	s_runningChange = false;
 }
 
+void AudioEngine::postModelChange(std::function<void()> change)
+{
+	if (s_renderingThread || s_runningChange)
+	{
+		// we're synchronized with the audio thread already
+		applyModelChanges();
+		change();
+		return;
+	}
+
+	auto modelChange = new ModelChange(std::move(change));
+	if (!m_modelChanges.push(modelChange))
+	{
+		// queue is full, so fall back to blocking
+		requestChangeInModel();
+		(*modelChange)();
+		doneChangeInModel();
+		delete modelChange;
+	}
+}
+
+
+
+
+void AudioEngine::applyModelChanges()
+{
+	// the list is LIFO, so restore the order in which changes have been posted
+	ModelChangeListElement* changes = nullptr;
+	for (ModelChangeListElement* e = m_modelChanges.popList(); e;)
+	{
+		ModelChangeListElement* next = e->next;
+		e->next = changes;
+		changes = e;
+		e = next;
+	}
+
+	for (ModelChangeListElement* e = changes; e;)
+	{
+		ModelChangeListElement* next = e->next;
+		ModelChange* modelChange = e->value;
+		m_modelChanges.free(e);
+
+		(*modelChange)();
+		// captured data may be freed when destroying the change
+		reclaimLater(modelChange);
+
+		e = next;
+	}
+}
+
+
+
+
+void AudioEngine::synchronizeWithRender()
+{
+	// the audio thread can't be in the middle of a period then
+	if (s_renderingThread || s_runningChange) { return; }
+
+	const auto period = m_periodsStarted.load();
+	while (m_periodsFinished.load() < period)
+	{
+		QThread::yieldCurrentThread();
+	}
+}
+
+
+
+
+void AudioEngine::reclaimLater(void* object, void (*deleter)(void*))
+{
+	if (!m_retiredObjects.push(RetiredObject{object, deleter, m_periodsStarted.load()}))
+	{
+		// no free slot left, so destroy it right here
+		synchronizeWithRender();
+		deleter(object);
+	}
+}
+
+
+
+
+void AudioEngine::reclaim(bool all)
+{
+	const auto periodsFinished = m_periodsFinished.load();
+
+	using RetiredListElement = LocklessList<RetiredObject>::Element;
+	for (RetiredListElement* e = m_retiredObjects.popList(); e;)
+	{
+		RetiredListElement* next = e->next;
+		const RetiredObject retired = e->value;
+		m_retiredObjects.free(e);
+
+		if (all || retired.period <= periodsFinished)
+		{
+			retired.deleter(retired.object);
+		}
+		else
+		{
+			// still might be in use, try again later
+			m_retiredObjects.push(retired);
+		}
+
+		e = next;
+	}
+}
+
+
+
+
 bool AudioEngine::isAudioDevNameValid(QString name)
 {
 #ifdef LMMS_HAVE_SDL
@@ -1252,4 +1511,34 @@ void AudioEngine::fifoWriter::run()
 	m_fifo->waitUntilRead();
 }
 
+
+
+
+AudioEngine::Reclaimer::Reclaimer(AudioEngine* audioEngine) :
+	m_audioEngine(audioEngine),
+	m_running(true)
+{
+	setObjectName("AudioEngine::Reclaimer");
+}
+
+
+
+
+void AudioEngine::Reclaimer::finish()
+{
+	m_running = false;
+}
+
+
+
+
+void AudioEngine::Reclaimer::run()
+{
+	while (m_running)
+	{
+		m_audioEngine->reclaim();
+		msleep(RECLAIM_INTERVAL_MS);
+	}
+}
+
 } // namespace lmms
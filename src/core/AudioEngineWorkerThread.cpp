@@ -43,6 +43,7 @@ namespace lmms
 AudioEngineWorkerThread::JobQueue AudioEngineWorkerThread::globalJobQueue;
 QWaitCondition * AudioEngineWorkerThread::queueReadyWaitCond = nullptr;
 QList<AudioEngineWorkerThread *> AudioEngineWorkerThread::workerThreads;
+std::atomic<bool> AudioEngineWorkerThread::s_processInline = false;
 
 // implementation of internal JobQueue
 void AudioEngineWorkerThread::JobQueue::reset( OperationMode _opMode )
@@ -154,7 +155,10 @@ void AudioEngineWorkerThread::quit()
 
 void AudioEngineWorkerThread::startAndWaitForJobs()
 {
-	queueReadyWaitCond->wakeAll();
+	if( !s_processInline )
+	{
+		queueReadyWaitCond->wakeAll();
+	}
 	// The last worker-thread is never started. Instead it's processed "inline"
 	// i.e. within the global AudioEngine thread. This way we can reduce latencies
 	// that otherwise would be caused by synchronizing with another thread.
@@ -175,7 +179,10 @@ void AudioEngineWorkerThread::run()
 	{
 		m.lock();
 		queueReadyWaitCond->wait( &m );
-		globalJobQueue.run();
+		if( !s_processInline )
+		{
+			globalJobQueue.run();
+		}
 		m.unlock();
 	}
 }
@@ -26,6 +26,9 @@
 #include "BandLimitedWave.h"
 
 #include <QDataStream>
+#include <QFile>
+
+#include "StartupCache.h"
 
 namespace lmms
 {
@@ -78,6 +81,20 @@ void BandLimitedWave::generateWaves()
 	QFile tri_file( s_wavetableDir + "tri.bin" );
 	QFile moog_file( s_wavetableDir + "moog.bin" );
 
+// the startup cache holds all mipmaps in one blob, which is much faster
+// than reading the files above one sample at a time
+	QByteArray cacheKey = "bandlimited-waves-1/" + QByteArray::number( MAXTBL ) + '/' +
+		QByteArray::number( static_cast<int>( sizeof( s_waveforms ) ) );
+	for( QFile* file : { &saw_file, &sqr_file, &tri_file, &moog_file } )
+	{
+		cacheKey += '/' + StartupCache::fileStamp( file->fileName() );
+	}
+	if( StartupCache::loadBlob( "bandlimited-waves", cacheKey, s_waveforms.data(), sizeof( s_waveforms ) ) )
+	{
+		s_wavesGenerated = true;
+		return;
+	}
+
 // saw wave - BLSaw
 // check for file and use it if exists
 	if( saw_file.exists() )
@@ -232,6 +249,8 @@ void BandLimitedWave::generateWaves()
 // set the generated flag so we don't load/generate them again needlessly
 	s_wavesGenerated = true;
 
+	StartupCache::storeBlob( "bandlimited-waves", cacheKey, s_waveforms.data(), sizeof( s_waveforms ) );
+
 
 // generate files, serialize mipmaps as QDataStreams and save them on disk
 //
@@ -0,0 +1,526 @@
+/*
+ * BinaryDataFile.cpp - binary container for LMMS project files
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "BinaryDataFile.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QDomDocument>
+#include <QHash>
+#include <QIODevice>
+#include <QString>
+
+namespace lmms::BinaryDataFile
+{
+
+namespace
+{
+
+constexpr char Magic[] = "LMMSPRJB";
+constexpr int MagicSize = 8;
+constexpr quint16 FormatVersion = 1;
+
+enum class Chunk : quint8
+{
+	End = 0,
+	Strings = 1,
+	Blob = 2,
+	Nodes = 3
+};
+
+enum class Codec : quint8
+{
+	Stored = 0,
+	Zlib = 1
+};
+
+enum class Node : quint8
+{
+	Element = 1,
+	EndElement,
+	Text,
+	CDataSection,
+	Comment,
+	ProcessingInstruction,
+	DocumentType
+};
+
+enum class Value : quint8
+{
+	String = 0, //!< index into the string table
+	Inline = 1, //!< stored right in the node chunk
+	Blob = 2 //!< index of a blob, to be encoded as base64
+};
+
+//! Node chunks are flushed when getting bigger than this
+constexpr int NodeChunkSize = 256 * 1024;
+//! Attribute values up to this length go into the string table
+constexpr int MaxInternedValueLength = 32;
+//! Attribute values from this length on are stored as blob if they are base64
+constexpr int MinBlobLength = 1024;
+//! Sanity limit for the size of a single chunk
+constexpr quint32 MaxChunkSize = 1u << 30;
+
+
+void setupStream(QDataStream& stream)
+{
+	stream.setVersion(QDataStream::Qt_5_6);
+	stream.setByteOrder(QDataStream::LittleEndian);
+}
+
+
+
+
+class Writer
+{
+public:
+	Writer(QIODevice& out) :
+		m_file(&out),
+		m_nodeStream(&m_nodes, QIODevice::WriteOnly),
+		m_blobCount(0)
+	{
+		setupStream(m_file);
+		setupStream(m_nodeStream);
+	}
+
+	bool write(const QDomDocument& doc)
+	{
+		m_file.writeRawData(Magic, MagicSize);
+		m_file << FormatVersion << quint16(0);
+
+		// the document type has to be known before creating the document when reading
+		const QString docType = doc.doctype().name();
+		if (!docType.isEmpty())
+		{
+			m_nodeStream << quint8(Node::DocumentType) << docType.toUtf8();
+		}
+
+		for (QDomNode node = doc.firstChild(); !node.isNull(); node = node.nextSibling())
+		{
+			if (!node.isDocumentType()) { writeNode(node); }
+		}
+
+		flush();
+		m_file << quint8(Chunk::End) << quint8(Codec::Stored) << quint32(0) << quint32(0);
+
+		return m_file.status() == QDataStream::Ok;
+	}
+
+private:
+	void writeNode(const QDomNode& node)
+	{
+		if (node.isElement())
+		{
+			const QDomElement element = node.toElement();
+			const QDomNamedNodeMap attributes = element.attributes();
+
+			m_nodeStream << quint8(Node::Element) << string(element.tagName())
+				<< quint16(attributes.count());
+			for (int i = 0; i < attributes.count(); ++i)
+			{
+				const QDomAttr attribute = attributes.item(i).toAttr();
+				m_nodeStream << string(attribute.name());
+				writeValue(attribute.value());
+			}
+			maybeFlush();
+
+			for (QDomNode child = node.firstChild(); !child.isNull(); child = child.nextSibling())
+			{
+				writeNode(child);
+			}
+
+			m_nodeStream << quint8(Node::EndElement);
+		}
+		// CDATA sections are text nodes as well
+		else if (node.isCDATASection())
+		{
+			m_nodeStream << quint8(Node::CDataSection) << node.nodeValue().toUtf8();
+		}
+		else if (node.isText())
+		{
+			m_nodeStream << quint8(Node::Text) << node.nodeValue().toUtf8();
+		}
+		else if (node.isComment())
+		{
+			m_nodeStream << quint8(Node::Comment) << node.nodeValue().toUtf8();
+		}
+		else if (node.isProcessingInstruction())
+		{
+			const QDomProcessingInstruction pi = node.toProcessingInstruction();
+			m_nodeStream << quint8(Node::ProcessingInstruction) << pi.target().toUtf8() << pi.data().toUtf8();
+		}
+		maybeFlush();
+	}
+
+	void writeValue(const QString& value)
+	{
+		if (value.size() >= MinBlobLength)
+		{
+			// only take it as binary data if it can be restored exactly
+			const QByteArray encoded = value.toLatin1();
+			const QByteArray raw = QByteArray::fromBase64(encoded);
+			if (raw.toBase64() == encoded)
+			{
+				writeChunk(Chunk::Blob, raw, false);
+				m_nodeStream << quint8(Value::Blob) << m_blobCount++;
+				return;
+			}
+		}
+
+		if (value.size() <= MaxInternedValueLength)
+		{
+			m_nodeStream << quint8(Value::String) << string(value);
+		}
+		else
+		{
+			m_nodeStream << quint8(Value::Inline) << value.toUtf8();
+		}
+	}
+
+	quint32 string(const QString& str)
+	{
+		const auto it = m_stringIndex.constFind(str);
+		if (it != m_stringIndex.constEnd()) { return *it; }
+
+		const auto index = static_cast<quint32>(m_stringIndex.size());
+		m_stringIndex.insert(str, index);
+		m_newStrings.push_back(str);
+		return index;
+	}
+
+	void maybeFlush()
+	{
+		if (m_nodes.size() >= NodeChunkSize) { flush(); }
+	}
+
+	void flush()
+	{
+		// the strings have to be known before the nodes referring to them
+		if (!m_newStrings.empty())
+		{
+			QByteArray strings;
+			QDataStream stream(&strings, QIODevice::WriteOnly);
+			setupStream(stream);
+			stream << quint32(m_newStrings.size());
+			for (const auto& str : m_newStrings)
+			{
+				stream << str.toUtf8();
+			}
+			writeChunk(Chunk::Strings, strings, true);
+			m_newStrings.clear();
+		}
+
+		if (!m_nodes.isEmpty())
+		{
+			writeChunk(Chunk::Nodes, m_nodes, true);
+			m_nodeStream.device()->seek(0);
+			m_nodes.clear();
+		}
+	}
+
+	void writeChunk(Chunk type, const QByteArray& data, bool compress)
+	{
+		Codec codec = Codec::Stored;
+		QByteArray compressed;
+		if (compress)
+		{
+			compressed = qCompress(data);
+			if (compressed.size() < data.size()) { codec = Codec::Zlib; }
+		}
+		const QByteArray& stored = codec == Codec::Zlib ? compressed : data;
+
+		m_file << quint8(type) << quint8(codec) << quint32(data.size()) << quint32(stored.size());
+		m_file.writeRawData(stored.constData(), stored.size());
+	}
+
+	QDataStream m_file;
+	QByteArray m_nodes;
+	QDataStream m_nodeStream;
+
+	QHash<QString, quint32> m_stringIndex;
+	std::vector<QString> m_newStrings;
+	quint32 m_blobCount;
+};
+
+
+
+
+class Reader
+{
+public:
+	Reader(QIODevice& in, QDomDocument& doc, QString& errorMsg) :
+		m_file(&in),
+		m_doc(doc),
+		m_errorMsg(errorMsg)
+	{
+		setupStream(m_file);
+	}
+
+	bool read()
+	{
+		char magic[MagicSize];
+		if (m_file.readRawData(magic, MagicSize) != MagicSize
+			|| !std::equal(magic, magic + MagicSize, Magic))
+		{
+			return fail("not a binary project file");
+		}
+
+		quint16 version, flags;
+		m_file >> version >> flags;
+		if (version > FormatVersion)
+		{
+			return fail(QString("unsupported format version %1").arg(version));
+		}
+
+		// without a document type unless there is one in the file
+		m_doc = QDomDocument(QDomDocumentType());
+		m_current = m_doc;
+
+		while (m_file.status() == QDataStream::Ok)
+		{
+			quint8 type, codec;
+			quint32 size, storedSize;
+			m_file >> type >> codec >> size >> storedSize;
+			if (m_file.status() != QDataStream::Ok) { break; }
+
+			if (static_cast<Chunk>(type) == Chunk::End)
+			{
+				if (m_current != m_doc) { return fail("unterminated element"); }
+				return true;
+			}
+
+			if (size > MaxChunkSize || storedSize > MaxChunkSize)
+			{
+				return fail("chunk too big");
+			}
+
+			QByteArray data(storedSize, Qt::Uninitialized);
+			if (m_file.readRawData(data.data(), storedSize) != static_cast<int>(storedSize))
+			{
+				break;
+			}
+			if (static_cast<Codec>(codec) == Codec::Zlib)
+			{
+				data = qUncompress(data);
+			}
+			else if (static_cast<Codec>(codec) != Codec::Stored)
+			{
+				return fail(QString("unknown codec %1").arg(codec));
+			}
+			if (static_cast<quint32>(data.size()) != size)
+			{
+				return fail("corrupt chunk");
+			}
+
+			switch (static_cast<Chunk>(type))
+			{
+				case Chunk::Strings:
+					if (!readStrings(data)) { return false; }
+					break;
+				case Chunk::Blob:
+					m_blobs.push_back(data);
+					break;
+				case Chunk::Nodes:
+					if (!readNodes(data)) { return false; }
+					break;
+				default:
+					// chunks of newer versions which don't affect the document
+					break;
+			}
+		}
+
+		return fail("unexpected end of file");
+	}
+
+private:
+	bool readStrings(const QByteArray& data)
+	{
+		QDataStream stream(data);
+		setupStream(stream);
+
+		quint32 count;
+		stream >> count;
+		for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i)
+		{
+			QByteArray str;
+			stream >> str;
+			m_strings.push_back(QString::fromUtf8(str));
+		}
+
+		return stream.status() == QDataStream::Ok || fail("corrupt string table");
+	}
+
+	bool readNodes(const QByteArray& data)
+	{
+		QDataStream stream(data);
+		setupStream(stream);
+
+		while (!stream.atEnd())
+		{
+			quint8 type;
+			stream >> type;
+
+			switch (static_cast<Node>(type))
+			{
+				case Node::Element:
+				{
+					QString name;
+					quint16 attributeCount;
+					if (!readString(stream, name)) { return false; }
+					stream >> attributeCount;
+
+					QDomElement element = m_doc.createElement(name);
+					for (quint16 i = 0; i < attributeCount; ++i)
+					{
+						QString attribute, value;
+						if (!readString(stream, attribute) || !readValue(stream, value)) { return false; }
+						element.setAttribute(attribute, value);
+					}
+
+					m_current.appendChild(element);
+					m_current = element;
+					break;
+				}
+				case Node::EndElement:
+					if (m_current == m_doc) { return fail("unbalanced element"); }
+					m_current = m_current.parentNode();
+					break;
+				case Node::Text:
+					m_current.appendChild(m_doc.createTextNode(readUtf8(stream)));
+					break;
+				case Node::CDataSection:
+					m_current.appendChild(m_doc.createCDATASection(readUtf8(stream)));
+					break;
+				case Node::Comment:
+					m_current.appendChild(m_doc.createComment(readUtf8(stream)));
+					break;
+				case Node::ProcessingInstruction:
+				{
+					const QString target = readUtf8(stream);
+					m_current.appendChild(m_doc.createProcessingInstruction(target, readUtf8(stream)));
+					break;
+				}
+				case Node::DocumentType:
+				{
+					if (m_doc.hasChildNodes()) { return fail("misplaced document type"); }
+					const QString name = readUtf8(stream);
+					m_doc = QDomDocument(QDomImplementation().createDocumentType(name, QString(), QString()));
+					m_current = m_doc;
+					break;
+				}
+				default:
+					return fail(QString("unknown node type %1").arg(type));
+			}
+
+			if (stream.status() != QDataStream::Ok) { return fail("corrupt node chunk"); }
+		}
+
+		return true;
+	}
+
+	bool readValue(QDataStream& stream, QString& value)
+	{
+		quint8 kind;
+		stream >> kind;
+		switch (static_cast<Value>(kind))
+		{
+			case Value::String:
+				return readString(stream, value);
+			case Value::Inline:
+				value = readUtf8(stream);
+				return true;
+			case Value::Blob:
+			{
+				quint32 index;
+				stream >> index;
+				if (index >= m_blobs.size()) { return fail("invalid blob reference"); }
+				value = QString::fromLatin1(m_blobs[index].toBase64());
+				// every blob is only referred to once
+				m_blobs[index] = QByteArray();
+				return true;
+			}
+		}
+		return fail(QString("unknown value type %1").arg(kind));
+	}
+
+	bool readString(QDataStream& stream, QString& str)
+	{
+		quint32 index;
+		stream >> index;
+		if (index >= m_strings.size()) { return fail("invalid string reference"); }
+		str = m_strings[index];
+		return true;
+	}
+
+	static QString readUtf8(QDataStream& stream)
+	{
+		QByteArray str;
+		stream >> str;
+		return QString::fromUtf8(str);
+	}
+
+	bool fail(const QString& msg)
+	{
+		m_errorMsg = msg;
+		return false;
+	}
+
+	QDataStream m_file;
+	QDomDocument& m_doc;
+	QString& m_errorMsg;
+
+	QDomNode m_current;
+	std::vector<QString> m_strings;
+	std::vector<QByteArray> m_blobs;
+};
+
+} // namespace
+
+
+
+
+bool isBinary(const QByteArray& data)
+{
+	return data.startsWith(QByteArray::fromRawData(Magic, MagicSize));
+}
+
+
+
+
+bool write(const QDomDocument& doc, QIODevice& out)
+{
+	return Writer(out).write(doc);
+}
+
+
+
+
+bool read(QIODevice& in, QDomDocument& doc, QString& errorMsg)
+{
+	return Reader(in, doc, errorMsg).read();
+}
+
+
+} // namespace lmms::BinaryDataFile
@@ -30,6 +30,7 @@
 #include <cmath>
 #include <map>
 
+#include <QBuffer>
 #include <QDebug>
 #include <QFile>
 #include <QFileInfo>
@@ -38,6 +39,7 @@
 #include <QSaveFile>
 
 #include "base64.h"
+#include "BinaryDataFile.h"
 #include "ConfigManager.h"
 #include "Effect.h"
 #include "embed.h"
@@ -61,6 +63,19 @@ namespace lmms
 static void findIds(const QDomElement& elem, QList<jo_id_t>& idList);
 
 
+static void showInvalidFileError(const QString& sourceFile)
+{
+	if (gui::getGUI() != nullptr)
+	{
+		QMessageBox::critical(nullptr,
+			gui::SongEditor::tr("Error in file"),
+			gui::SongEditor::tr("The file %1 seems to contain "
+					"errors and therefore can't be "
+					"loaded.").arg(sourceFile));
+	}
+}
+
+
 // QMap with the DOM elements that access file resources
 const DataFile::ResourcesMap DataFile::ELEMENTS_WITH_RESOURCES = {
 { "sampleclip", {"src"} },
@@ -170,6 +185,13 @@ DataFile::DataFile( const QString & _fileName ) :
 		return;
 	}
 
+	// binary projects are read chunk by chunk instead of all at once
+	if( BinaryDataFile::isBinary( inFile.peek( 8 ) ) )
+	{
+		loadBinaryData( inFile, _fileName );
+		return;
+	}
+
 	loadData( inFile.readAll(), _fileName );
 }
 
@@ -195,7 +217,7 @@ bool DataFile::validate( QString extension )
 	switch( m_type )
 	{
 	case Type::SongProject:
-		if( extension == "mmp" || extension == "mmpz" )
+		if( extension == "mmp" || extension == "mmpz" || extension == "mmpb" )
 		{
 			return true;
 		}
@@ -219,7 +241,7 @@ bool DataFile::validate( QString extension )
 		}
 		break;
 	case Type::Unknown:
-		if (! ( extension == "mmp" || extension == "mpt" || extension == "mmpz" ||
+		if (! ( extension == "mmp" || extension == "mpt" || extension == "mmpz" || extension == "mmpb" ||
 				extension == "xpf" || extension == "xml" ||
 				( extension == "xiz" && ! getPluginFactory()->pluginSupportingExtension(extension).isNull()) ||
 				extension == "sf2" || extension == "sf3" || extension == "pat" || extension == "mid" ||
@@ -261,7 +283,8 @@ QString DataFile::nameWithExtension( const QString & _fn ) const
 		case Type::SongProject:
 			if( extension != "mmp" &&
 					extension != "mpt" &&
-					extension != "mmpz" )
+					extension != "mmpz" &&
+					extension != "mmpb" )
 			{
 				if( ConfigManager::inst()->value( "app",
 						"nommpz" ).toInt() == 0 )
@@ -305,88 +328,150 @@ void DataFile::write( QTextStream & _strm )
 
 
 
+bool DataFile::writeBinary( QIODevice & _out )
+{
+	if( type() == Type::SongProject || type() == Type::SongProjectTemplate
+					|| type() == Type::InstrumentTrackSettings )
+	{
+		cleanMetaNodes( documentElement() );
+	}
+
+	return BinaryDataFile::write( *this, _out );
+}
+
+
+
+
 bool DataFile::writeFile(const QString& filename, bool withResources)
 {
-	// Small lambda function for displaying errors
-	auto showError = [](QString title, QString body){
-		if (gui::getGUI() != nullptr)
-		{
-			QMessageBox mb;
-			mb.setWindowTitle(title);
-			mb.setText(body);
-			mb.setIcon(QMessageBox::Warning);
-			mb.setStandardButtons(QMessageBox::Ok);
-			mb.exec();
-		}
-		else
-		{
-			qWarning() << body;
-		}
-	};
+	const bool keepBackup = !ConfigManager::inst()->value("app", "disablebackup").toInt();
+	const QString fullName = fileNameToWrite(filename, withResources);
+
+	WriteError error;
+	if ((withResources && !createBundle(fullName, error))
+		|| !writeFileSilently(fullName, keepBackup, error))
+	{
+		showWriteError(error);
+		return false;
+	}
+	return true;
+}
+
 
+
+
+void DataFile::showWriteError(const WriteError& error)
+{
+	if (gui::getGUI() != nullptr)
+	{
+		QMessageBox mb;
+		mb.setWindowTitle(error.title);
+		mb.setText(error.message);
+		mb.setIcon(QMessageBox::Warning);
+		mb.setStandardButtons(QMessageBox::Ok);
+		mb.exec();
+	}
+	else
+	{
+		qWarning() << error.message;
+	}
+}
+
+
+
+
+QString DataFile::fileNameToWrite(const QString& filename, bool withResources) const
+{
 	// If we are saving without resources, filename is just the file we are
 	// saving to. If we are saving with resources (project bundle), filename
 	// will be used (discarding extensions) to create a folder where the
 	// bundle will be saved in
+	if (!withResources) { return nameWithExtension(filename); }
 
-	QFileInfo fInfo(filename);
-
+	const QFileInfo fInfo(filename);
 	const QString bundleDir = fInfo.path() + "/" + fInfo.fileName().section('.', 0, 0);
+	return nameWithExtension(bundleDir + "/" + fInfo.fileName());
+}
+
+
+
+
+bool DataFile::createBundle(const QString& fullName, WriteError& error)
+{
+	auto setError = [&error](QString title, QString message){
+		error = WriteError{std::move(title), std::move(message)};
+	};
+
+	const QString bundleDir = QFileInfo(fullName).path();
 	const QString resourcesDir = bundleDir + "/resources";
-	const QString fullName = withResources
-		? nameWithExtension(bundleDir + "/" + fInfo.fileName())
-		: nameWithExtension(filename);
-	const QString fullNameTemp = fullName + ".new";
-	const QString fullNameBak = fullName + ".bak";
 
 	using gui::SongEditor;
 
-	// If we are saving with resources, setup the bundle folder first
-	if (withResources)
+	// First check if there's a bundle folder with the same name in
+	// the path already. If so, warns user that we can't overwrite a
+	// project bundle.
+	if (QDir(bundleDir).exists())
 	{
-		// First check if there's a bundle folder with the same name in
-		// the path already. If so, warns user that we can't overwrite a
-		// project bundle.
-		if (QDir(bundleDir).exists())
-		{
-			showError(SongEditor::tr("Operation denied"),
-				SongEditor::tr("A bundle folder with that name already eists on the "
-				"selected path. Can't overwrite a project bundle. Please select a different "
-				"name."));
+		setError(SongEditor::tr("Operation denied"),
+			SongEditor::tr("A bundle folder with that name already eists on the "
+			"selected path. Can't overwrite a project bundle. Please select a different "
+			"name."));
 
-			return false;
-		}
+		return false;
+	}
 
-		// Create bundle folder
-		if (!QDir().mkdir(bundleDir))
-		{
-			showError(SongEditor::tr("Error"),
-				SongEditor::tr("Couldn't create bundle folder."));
-			return false;
-		}
+	// Create bundle folder
+	if (!QDir().mkdir(bundleDir))
+	{
+		setError(SongEditor::tr("Error"),
+			SongEditor::tr("Couldn't create bundle folder."));
+		return false;
+	}
 
-		// Create resources folder
-		if (!QDir().mkdir(resourcesDir))
-		{
-			showError(SongEditor::tr("Error"),
-				SongEditor::tr("Couldn't create resources folder."));
-			return false;
-		}
+	// Create resources folder
+	if (!QDir().mkdir(resourcesDir))
+	{
+		setError(SongEditor::tr("Error"),
+			SongEditor::tr("Couldn't create resources folder."));
+		return false;
+	}
 
-		// Copy resources to folder and update paths
-		if (!copyResources(resourcesDir))
-		{
-			showError(SongEditor::tr("Error"),
-				SongEditor::tr("Failed to copy resources."));
-			return false;
-		}
+	// Copy resources to folder and update paths
+	if (!copyResources(resourcesDir))
+	{
+		setError(SongEditor::tr("Error"),
+			SongEditor::tr("Failed to copy resources."));
+		return false;
 	}
+	return true;
+}
+
+
+
+
+bool DataFile::writeFileSilently(const QString& fullName, bool keepBackup,
+	WriteError& error, const ProgressCallback& progress)
+{
+	// Small lambdas for reporting errors and progress
+	auto setError = [&error](QString title, QString message){
+		error = WriteError{std::move(title), std::move(message)};
+	};
+	auto setProgress = [&progress](int percent){
+		if (progress) { progress(percent); }
+	};
+
+	const QString fullNameTemp = fullName + ".new";
+	const QString fullNameBak = fullName + ".bak";
+
+	using gui::SongEditor;
+
+	setProgress(0);
 
 	QSaveFile outfile(fullNameTemp);
 
 	if (!outfile.open(QIODevice::WriteOnly | QIODevice::Truncate))
 	{
-		showError(SongEditor::tr("Could not write file"),
+		setError(SongEditor::tr("Could not write file"),
 			SongEditor::tr("Could not open %1 for writing. You probably are not permitted to "
 				"write to this file. Please make sure you have write-access to "
 				"the file and try again.").arg(fullName));
@@ -400,22 +485,34 @@ bool DataFile::writeFile(const QString& filename, bool withResources)
 		QString xml;
 		QTextStream ts( &xml );
 		write( ts );
+		setProgress(50);
 		outfile.write( qCompress( xml.toUtf8() ) );
 	}
+	else if (extension == "mmpb")
+	{
+		if (!writeBinary(outfile))
+		{
+			outfile.cancelWriting();
+			setError(SongEditor::tr("Could not write file"),
+				SongEditor::tr("Could not write the binary project to %1.").arg(fullName));
+			return false;
+		}
+	}
 	else
 	{
 		QTextStream ts( &outfile );
 		write( ts );
 	}
+	setProgress(90);
 
 	if (!outfile.commit())
 	{
-		showError(SongEditor::tr("Could not write file"),
+		setError(SongEditor::tr("Could not write file"),
 			SongEditor::tr("An unknown error has occured and the file could not be saved."));
 		return false;
 	}
 
-	if (ConfigManager::inst()->value("app", "disablebackup").toInt())
+	if (!keepBackup)
 	{
 		// remove current file
 		QFile::remove(fullName);
@@ -430,12 +527,36 @@ bool DataFile::writeFile(const QString& filename, bool withResources)
 	// move temporary file to current file
 	QFile::rename(fullNameTemp, fullName);
 
+	setProgress(100);
+
 	return true;
 }
 
 
 
 
+QStringList DataFile::resourceFiles() const
+{
+	QStringList files;
+	for (const auto& element : ELEMENTS_WITH_RESOURCES)
+	{
+		const QDomNodeList list = elementsByTagName(element.first);
+		for (int i = 0; !list.item(i).isNull(); ++i)
+		{
+			const QDomElement el = list.item(i).toElement();
+			for (const auto& attribute : element.second)
+			{
+				const QString file = el.attribute(attribute);
+				if (!file.isEmpty()) { files << file; }
+			}
+		}
+	}
+	return files;
+}
+
+
+
+
 bool DataFile::copyResources(const QString& resourcesDir)
 {
 	// List of filenames used so we can append a counter to any
@@ -1964,6 +2085,15 @@ void DataFile::upgrade()
 
 void DataFile::loadData( const QByteArray & _data, const QString & _sourceFile )
 {
+	if( BinaryDataFile::isBinary( _data ) )
+	{
+		QBuffer buffer;
+		buffer.setData( _data );
+		buffer.open( QIODevice::ReadOnly );
+		loadBinaryData( buffer, _sourceFile );
+		return;
+	}
+
 	QString errorMsg;
 	int line = -1, col = -1;
 	if( !setContent( _data, &errorMsg, &line, &col ) )
@@ -1979,23 +2109,36 @@ void DataFile::loadData( const QByteArray & _data, const QString & _sourceFile )
 		}
 		if( line >= 0 && col >= 0 )
 		{
-			using gui::SongEditor;
-
 			qWarning() << "at line" << line << "column" << errorMsg;
-			if (gui::getGUI() != nullptr)
-			{
-				QMessageBox::critical( nullptr,
-					SongEditor::tr( "Error in file" ),
-					SongEditor::tr( "The file %1 seems to contain "
-							"errors and therefore can't be "
-							"loaded." ).
-								arg( _sourceFile ) );
-			}
-
+			showInvalidFileError( _sourceFile );
 			return;
 		}
 	}
 
+	setupLoadedData( _sourceFile );
+}
+
+
+
+
+void DataFile::loadBinaryData( QIODevice & _in, const QString & _sourceFile )
+{
+	QString errorMsg;
+	if( !BinaryDataFile::read( _in, *this, errorMsg ) )
+	{
+		qWarning() << "binary project file" << _sourceFile << ":" << errorMsg;
+		showInvalidFileError( _sourceFile );
+		return;
+	}
+
+	setupLoadedData( _sourceFile );
+}
+
+
+
+
+void DataFile::setupLoadedData( const QString & _sourceFile )
+{
 	QDomElement root = documentElement();
 	m_type = type( root.attribute( "type" ) );
 	m_head = root.elementsByTagName( "head" ).item( 0 ).toElement();
@@ -25,6 +25,7 @@
 
 
 #include <QDomElement>
+#include <algorithm>
 #include <cassert>
 
 #include "EffectChain.h"
@@ -209,6 +210,19 @@ bool EffectChain::processAudioBuffer( sampleFrame * _buf, const fpp_t _frames, b
 
 
 
+bool EffectChain::isRunning() const
+{
+	if( m_enabledModel.value() == false )
+	{
+		return false;
+	}
+
+	return std::any_of(m_effects.begin(), m_effects.end(), [](const Effect* effect) { return effect->isRunning(); });
+}
+
+
+
+
 void EffectChain::startRunning()
 {
 	if( m_enabledModel.value() == false )
@@ -230,16 +244,18 @@ void EffectChain::clear()
 	emit aboutToClear();
 
 	Engine::audioEngine()->requestChangeInModel();
+	auto effects = std::move(m_effects);
+	m_effects.clear();
+	Engine::audioEngine()->doneChangeInModel();
 
-	while (m_effects.size())
+	// the effects aren't processed anymore, so the audio thread doesn't have
+	// to wait for them being destroyed
+	while (!effects.empty())
 	{
-		auto e = m_effects[m_effects.size() - 1];
-		m_effects.pop_back();
-		delete e;
+		delete effects.back();
+		effects.pop_back();
 	}
 
-	Engine::audioEngine()->doneChangeInModel();
-
 	m_enabledModel.setValue( false );
 }
 
@@ -34,6 +34,7 @@
 #include "PresetPreviewPlayHandle.h"
 #include "ProjectJournal.h"
 #include "Song.h"
+#include "StartupCache.h"
 #include "BandLimitedWave.h"
 #include "Oscillator.h"
 
@@ -118,6 +119,9 @@ void Engine::destroy()
 
 	delete ConfigManager::inst();
 
+	// keep the plans which have been measured meanwhile, e.g. by plugins
+	StartupCache::exportFftwWisdom();
+
 	// The oscillator FFT plans remain throughout the application lifecycle
 	// due to being expensive to create, and being used whenever a userwave form is changed
 	Oscillator::destroyFFTPlans();
@@ -26,8 +26,10 @@
 
 #include <cmath>
 
+#include "BufferManager.h"
 #include "DummyInstrument.h"
 #include "InstrumentTrack.h"
+#include "MixHelpers.h"
 #include "lmms_constants.h"
 
 
@@ -39,10 +41,19 @@ Instrument::Instrument(InstrumentTrack * _instrument_track,
 			const Descriptor * _descriptor,
 			const Descriptor::SubPluginFeatures::Key *key) :
 	Plugin(_descriptor, nullptr/* _instrument_track*/, key),
-	m_instrumentTrack( _instrument_track )
+	m_instrumentTrack( _instrument_track ),
+	m_voiceBuffer( nullptr )
 {
 }
 
+
+
+
+Instrument::~Instrument()
+{
+	BufferManager::release( m_voiceBuffer );
+}
+
 void Instrument::play( sampleFrame * )
 {
 }
@@ -50,6 +61,29 @@ void Instrument::play( sampleFrame * )
 
 
 
+void Instrument::playNotes( const std::vector<NotePlayHandle*> & _notes,
+					sampleFrame * _working_buffer )
+{
+	if( m_voiceBuffer == nullptr )
+	{
+		m_voiceBuffer = BufferManager::acquire();
+	}
+
+	for( NotePlayHandle * n : _notes )
+	{
+		const f_cnt_t frames = n->noteOffset() + n->framesLeftForCurrentPeriod();
+
+		BufferManager::clear( m_voiceBuffer, frames );
+		playNote( n, m_voiceBuffer );
+		// apply envelopes, volume and panning of this voice
+		m_instrumentTrack->processAudioBuffer( m_voiceBuffer, frames, n );
+		MixHelpers::add( _working_buffer, m_voiceBuffer, frames );
+	}
+}
+
+
+
+
 void Instrument::deleteNotePluginData( NotePlayHandle * )
 {
 }
@@ -24,10 +24,14 @@
 
 
 #include "InstrumentPlayHandle.h"
+
+#include <algorithm>
+
 #include "Instrument.h"
 #include "InstrumentTrack.h"
 #include "Engine.h"
 #include "AudioEngine.h"
+#include "NotePlayHandle.h"
 
 namespace lmms
 {
@@ -37,11 +41,18 @@ InstrumentPlayHandle::InstrumentPlayHandle(Instrument * instrument, InstrumentTr
 	PlayHandle(Type::InstrumentPlayHandle),
 	m_instrument(instrument)
 {
+	m_voices.reserve(PreallocatedVoices);
 	setAudioPort(instrumentTrack->audioPort());
 }
 
 void InstrumentPlayHandle::play(sampleFrame * working_buffer)
 {
+	if (m_instrument->flags().testFlag(Instrument::Flag::IsVoiceBatched))
+	{
+		playBatched(working_buffer);
+		return;
+	}
+
 	InstrumentTrack * instrumentTrack = m_instrument->instrumentTrack();
 
 	// ensure that all our nph's have been processed first
@@ -69,6 +80,64 @@ void InstrumentPlayHandle::play(sampleFrame * working_buffer)
 	// Process the audio buffer that the instrument has just worked on...
 	const fpp_t frames = Engine::audioEngine()->framesPerPeriod();
 	instrumentTrack->processAudioBuffer(working_buffer, frames, nullptr);
+
+	// don't let the audio port mix silence
+	if (instrumentTrack->isSilent())
+	{
+		releaseBuffer();
+	}
+}
+
+void InstrumentPlayHandle::playBatched(sampleFrame * working_buffer)
+{
+	InstrumentTrack * instrumentTrack = m_instrument->instrumentTrack();
+
+	// parents have to be prepared before their sub-notes, which they might
+	// release, but the AudioEngine doesn't keep the notes in order of creation
+	auto nphv = NotePlayHandle::nphsOfInstrumentTrack(instrumentTrack, true);
+	std::stable_sort(nphv.begin(), nphv.end(), [](const NotePlayHandle* a, const NotePlayHandle* b)
+	{
+		return a->depth() < b->depth();
+	});
+
+	m_voices.clear();
+	for (const NotePlayHandle * constNotePlayHandle : nphv)
+	{
+		auto notePlayHandle = const_cast<NotePlayHandle *>(constNotePlayHandle);
+		if (notePlayHandle->isFinished() || !notePlayHandle->startPeriod())
+		{
+			continue;
+		}
+		if (notePlayHandle->framesLeft() > 0)
+		{
+			// let arpeggio and note stacking do their work
+			instrumentTrack->playNote(notePlayHandle, nullptr);
+			if (!notePlayHandle->isMasterNote())
+			{
+				m_voices.push_back(notePlayHandle);
+				continue;
+			}
+		}
+		notePlayHandle->finishPeriod();
+	}
+
+	if (m_voices.empty())
+	{
+		// nothing has been rendered, so don't let the audio port mix silence
+		releaseBuffer();
+		return;
+	}
+
+	m_instrument->playNotes(m_voices, working_buffer);
+
+	for (NotePlayHandle * notePlayHandle : m_voices)
+	{
+		notePlayHandle->finishPeriod();
+	}
+
+	// envelopes, volume and panning have been applied per voice already
+	const fpp_t frames = Engine::audioEngine()->framesPerPeriod();
+	instrumentTrack->processAudioBuffer(working_buffer, frames, nullptr);
 }
 
 bool InstrumentPlayHandle::isFromTrack(const Track* track) const
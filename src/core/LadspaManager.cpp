@@ -25,6 +25,7 @@
  */
 
 #include <QCoreApplication>
+#include <QDataStream>
 #include <QDebug>
 #include <QDir>
 #include <QLibrary>
@@ -34,6 +35,7 @@
 #include "ConfigManager.h"
 #include "LadspaManager.h"
 #include "PluginFactory.h"
+#include "StartupCache.h"
 
 
 namespace lmms
@@ -59,6 +61,11 @@ LadspaManager::LadspaManager()
 	ladspaDirectories.push_back( "/Library/Audio/Plug-Ins/LADSPA" );
 #endif
 
+	// descriptions of the libraries we have seen before, keyed by path
+	const StartupCache::Entries cache =
+		StartupCache::loadEntries( "ladspa-plugins", "ladspa-1" );
+	StartupCache::Entries newCache;
+
 	for (const auto& ladspaDirectory : ladspaDirectories)
 	{
 		// Skip empty entries as QDir will interpret it as the working directory
@@ -78,15 +85,29 @@ LadspaManager::LadspaManager()
 				continue;
 			}
 
-			QLibrary plugin_lib( f.absoluteFilePath() );
+			const QString library = f.absoluteFilePath();
+			if( newCache.contains( library ) )
+			{
+				continue;
+			}
+
+			const QByteArray stamp = StartupCache::fileStamp( library );
+			if( addCachedPlugins( f.fileName(), library, stamp,
+							cache.value( library ) ) )
+			{
+				newCache[library] = cache[library];
+				continue;
+			}
+
+			QLibrary plugin_lib( library );
 
 			if( plugin_lib.load() == true )
 			{
 				auto descriptorFunction = (LADSPA_Descriptor_Function)plugin_lib.resolve("ladspa_descriptor");
 				if( descriptorFunction != nullptr )
 				{
-					addPlugins( descriptorFunction,
-							f.fileName() );
+					newCache[library] = addPlugins( descriptorFunction,
+							f.fileName(), library, stamp );
 				}
 			}
 			else
@@ -95,6 +116,11 @@ LadspaManager::LadspaManager()
 			}
 		}
 	}
+
+	if( newCache != cache )
+	{
+		StartupCache::storeEntries( "ladspa-plugins", "ladspa-1", newCache );
+	}
 	
 	l_ladspa_key_t keys = m_ladspaManagerMap.keys();
 	for (const auto& key : keys)
@@ -135,27 +161,29 @@ LadspaManagerDescription * LadspaManager::getDescription(
 
 
 
-void LadspaManager::addPlugins(
+QByteArray LadspaManager::addPlugins(
 		LADSPA_Descriptor_Function _descriptor_func,
-						const QString & _file )
+				const QString & _file, const QString & _library,
+				const QByteArray & _stamp )
 {
+	QByteArray entry;
+	QDataStream out( &entry, QIODevice::WriteOnly );
+	out << _stamp;
+
 	const LADSPA_Descriptor * descriptor;
 
 	for( long pluginIndex = 0;
 		( descriptor = _descriptor_func( pluginIndex ) ) != nullptr;
 								++pluginIndex )
 	{
-		ladspa_key_t key( _file, QString( descriptor->Label ) );
-		if( m_ladspaManagerMap.contains( key ) )
-		{
-			continue;
-		}
-
 		auto plugIn = new LadspaManagerDescription;
 		plugIn->descriptorFunction = _descriptor_func;
+		plugIn->library = _library;
 		plugIn->index = pluginIndex;
 		plugIn->inputChannels = getPluginInputs( descriptor );
 		plugIn->outputChannels = getPluginOutputs( descriptor );
+		plugIn->name = descriptor->Name;
+		plugIn->properties = descriptor->Properties;
 
 		if( plugIn->inputChannels == 0 && plugIn->outputChannels > 0 )
 		{
@@ -176,8 +204,98 @@ void LadspaManager::addPlugins(
 			plugIn->type = LadspaPluginType::Other;
 		}
 
-		m_ladspaManagerMap[key] = plugIn;
+		const QString label = descriptor->Label;
+		out << label << plugIn->name << plugIn->index
+			<< static_cast<qint32>( plugIn->type )
+			<< plugIn->inputChannels << plugIn->outputChannels
+			<< static_cast<qint32>( plugIn->properties );
+
+		addDescription( ladspa_key_t( _file, label ), plugIn );
 	}
+
+	return entry;
+}
+
+
+
+
+bool LadspaManager::addCachedPlugins( const QString & _file,
+				const QString & _library, const QByteArray & _stamp,
+				const QByteArray & _entry )
+{
+	QDataStream in( _entry );
+	QByteArray stamp;
+	in >> stamp;
+	if( _entry.isEmpty() || stamp != _stamp )
+	{
+		return false;
+	}
+
+	while( !in.atEnd() && in.status() == QDataStream::Ok )
+	{
+		QString label;
+		qint32 type, properties;
+		auto plugIn = new LadspaManagerDescription;
+		plugIn->descriptorFunction = nullptr;
+		plugIn->library = _library;
+		in >> label >> plugIn->name >> plugIn->index >> type
+			>> plugIn->inputChannels >> plugIn->outputChannels
+			>> properties;
+		plugIn->type = static_cast<LadspaPluginType>( type );
+		plugIn->properties = properties;
+
+		if( in.status() != QDataStream::Ok )
+		{
+			delete plugIn;
+			break;
+		}
+		addDescription( ladspa_key_t( _file, label ), plugIn );
+	}
+	return true;
+}
+
+
+
+
+void LadspaManager::addDescription( const ladspa_key_t & _key,
+				LadspaManagerDescription * _description )
+{
+	// the first library found with that file name wins
+	if( m_ladspaManagerMap.contains( _key ) )
+	{
+		delete _description;
+		return;
+	}
+	m_ladspaManagerMap[_key] = _description;
+}
+
+
+
+
+bool LadspaManager::loadLibrary( LadspaManagerDescription * _description )
+{
+	QLibrary plugin_lib( _description->library );
+	if( plugin_lib.load() == false )
+	{
+		qWarning() << plugin_lib.errorString();
+		return false;
+	}
+
+	auto descriptorFunction = (LADSPA_Descriptor_Function)plugin_lib.resolve("ladspa_descriptor");
+	if( descriptorFunction == nullptr )
+	{
+		return false;
+	}
+
+	// all plugins of that library can use it from now on
+	for( LadspaManagerDescription * description : m_ladspaManagerMap )
+	{
+		if( description->library == _description->library )
+		{
+			description->descriptorFunction = descriptorFunction;
+		}
+	}
+	return true;
 }
 
 
@@ -275,8 +393,8 @@ QString LadspaManager::getLabel( const ladspa_key_t & _plugin )
 bool LadspaManager::hasRealTimeDependency(
 					const ladspa_key_t &  _plugin )
 {
-	const LADSPA_Descriptor * descriptor = getDescriptor( _plugin );
-	return( descriptor ? LADSPA_IS_REALTIME( descriptor->Properties )
+	const LadspaManagerDescription * description = getDescription( _plugin );
+	return( description ? LADSPA_IS_REALTIME( description->properties )
 					   : false );
 }
 
@@ -285,8 +403,8 @@ bool LadspaManager::hasRealTimeDependency(
 
 bool LadspaManager::isInplaceBroken( const ladspa_key_t &  _plugin )
 {
-	const LADSPA_Descriptor * descriptor = getDescriptor( _plugin );
-	return( descriptor ? LADSPA_IS_INPLACE_BROKEN( descriptor->Properties )
+	const LadspaManagerDescription * description = getDescription( _plugin );
+	return( description ? LADSPA_IS_INPLACE_BROKEN( description->properties )
 					   : false );
 }
 
@@ -296,8 +414,8 @@ bool LadspaManager::isInplaceBroken( const ladspa_key_t &  _plugin )
 bool LadspaManager::isRealTimeCapable(
 					const ladspa_key_t &  _plugin )
 {
-	const LADSPA_Descriptor * descriptor = getDescriptor( _plugin );
-	return( descriptor ? LADSPA_IS_HARD_RT_CAPABLE( descriptor->Properties )
+	const LadspaManagerDescription * description = getDescription( _plugin );
+	return( description ? LADSPA_IS_HARD_RT_CAPABLE( description->properties )
 					   : false );
 }
 
@@ -306,8 +424,8 @@ bool LadspaManager::isRealTimeCapable(
 
 QString LadspaManager::getName( const ladspa_key_t & _plugin )
 {
-	const LADSPA_Descriptor * descriptor = getDescriptor( _plugin );
-	return( descriptor ? descriptor->Name : "" );
+	const LadspaManagerDescription * description = getDescription( _plugin );
+	return( description ? description->name : "" );
 }
 
 
@@ -526,11 +644,11 @@ bool LadspaManager::isEnum( const ladspa_key_t & _plugin, uint32_t _port )
 	if( m_ladspaManagerMap.contains( _plugin )
 		   && _port < getPortCount( _plugin ) )
 	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
+		const LADSPA_Descriptor * descriptor = getDescriptor( _plugin );
+		if( descriptor == nullptr )
+		{
+			return( false );
+		}
 		LADSPA_PortRangeHintDescriptor hintDescriptor =
 			descriptor->PortRangeHints[_port].HintDescriptor;
 		// This is an LMMS extension to ladspa
@@ -571,11 +689,16 @@ const LADSPA_Descriptor * LadspaManager::getDescriptor(
 {
 	if( m_ladspaManagerMap.contains( _plugin ) )
 	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
+		LadspaManagerDescription * description =
+					m_ladspaManagerMap[_plugin];
+		if( description->descriptorFunction == nullptr &&
+					!loadLibrary( description ) )
+		{
+			return( nullptr );
+		}
 		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
+				description->descriptorFunction(
+					description->index );
 		return( descriptor );
 	}
 	else
@@ -52,10 +52,11 @@ static size_t align( size_t size, size_t alignment )
 
 
 
-LocklessAllocator::LocklessAllocator( size_t nmemb, size_t size )
+LocklessAllocator::LocklessAllocator( size_t nmemb, size_t size,
+							size_t alignment )
 {
 	m_capacity = align( nmemb, SIZEOF_SET );
-	m_elementSize = align( size, sizeof( void * ) );
+	m_elementSize = align( size, std::max( alignment, sizeof( void * ) ) );
 	m_pool = new char[m_capacity * m_elementSize];
 
 	m_freeStateSets = m_capacity / SIZEOF_SET;
@@ -106,6 +107,19 @@ static int ffs( int i )
 
 
 void * LocklessAllocator::alloc()
+{
+	void * ptr = tryAlloc();
+	if( !ptr )
+	{
+		fprintf( stderr, "LocklessAllocator: No free space\n" );
+	}
+	return ptr;
+}
+
+
+
+
+void * LocklessAllocator::tryAlloc()
 {
 	// Some of these CAS loops could probably use relaxed atomics, as discussed
 	// in http://en.cppreference.com/w/cpp/atomic/atomic/compare_exchange.
@@ -115,7 +129,6 @@ void * LocklessAllocator::alloc()
 	{
 		if( !available )
 		{
-			fprintf( stderr, "LocklessAllocator: No free space\n" );
 			return nullptr;
 		}
 	}
@@ -167,4 +180,13 @@ invalid:
 }
 
 
+
+
+bool LocklessAllocator::owns( const void * ptr ) const
+{
+	const char * p = static_cast<const char *>( ptr );
+	return p >= m_pool && p < m_pool + m_capacity * m_elementSize;
+}
+
+
 } // namespace lmms
\ No newline at end of file
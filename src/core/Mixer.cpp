@@ -62,6 +62,7 @@ MixerChannel::MixerChannel( int idx, Model * _parent ) :
 	m_fxChain( nullptr ),
 	m_hasInput( false ),
 	m_stillRunning( false ),
+	m_silent( true ),
 	m_peakLeft( 0.0f ),
 	m_peakRight( 0.0f ),
 	m_buffer( new sampleFrame[Engine::audioEngine()->framesPerPeriod()] ),
@@ -127,7 +128,8 @@ void MixerChannel::doProcessing()
 			FloatModel * sendModel = senderRoute->amount();
 			if( ! sendModel ) qFatal( "Error: no send model found from %d to %d", senderRoute->senderIndex(), m_channelIndex );
 
-			if( sender->m_hasInput || sender->m_stillRunning )
+			// this includes the last period of an effect tail
+			if( !sender->m_silent )
 			{
 				// figure out if we're getting sample-exact input
 				ValueBuffer * sendBuf = sendModel->valueBuffer();
@@ -169,11 +171,21 @@ void MixerChannel::doProcessing()
 			m_fxChain.startRunning();
 		}
 
-		m_stillRunning = m_fxChain.processAudioBuffer( m_buffer, fpp, m_hasInput );
+		// without input and without effects producing a tail the buffer is
+		// still silent, so skip the effect chain and the peak detection
+		if( m_hasInput || m_fxChain.isRunning() )
+		{
+			m_stillRunning = m_fxChain.processAudioBuffer( m_buffer, fpp, m_hasInput );
+			m_silent = false;
 
-		AudioEngine::StereoSample peakSamples = Engine::audioEngine()->getPeakValues(m_buffer, fpp);
-		m_peakLeft = std::max(m_peakLeft, peakSamples.left * v);
-		m_peakRight = std::max(m_peakRight, peakSamples.right * v);
+			AudioEngine::StereoSample peakSamples = Engine::audioEngine()->getPeakValues(m_buffer, fpp);
+			m_peakLeft = std::max(m_peakLeft, peakSamples.left * v);
+			m_peakRight = std::max(m_peakRight, peakSamples.right * v);
+		}
+		else
+		{
+			m_stillRunning = false;
+		}
 	}
 	else
 	{
@@ -603,6 +615,7 @@ void Mixer::mixToChannel( const sampleFrame * _buf, mix_ch_t _ch )
 		m_mixerChannels[_ch]->m_lock.lock();
 		MixHelpers::add( m_mixerChannels[_ch]->m_buffer, _buf, Engine::audioEngine()->framesPerPeriod() );
 		m_mixerChannels[_ch]->m_hasInput = true;
+		m_mixerChannels[_ch]->m_silent = false;
 		m_mixerChannels[_ch]->m_lock.unlock();
 	}
 }
@@ -612,8 +625,12 @@ void Mixer::mixToChannel( const sampleFrame * _buf, mix_ch_t _ch )
 
 void Mixer::prepareMasterMix()
 {
-	BufferManager::clear( m_mixerChannels[0]->m_buffer,
+	if( !m_mixerChannels[0]->m_silent )
+	{
+		BufferManager::clear( m_mixerChannels[0]->m_buffer,
 					Engine::audioEngine()->framesPerPeriod() );
+		m_mixerChannels[0]->m_silent = true;
+	}
 }
 
 
@@ -664,29 +681,38 @@ void Mixer::masterMix( sampleFrame * _buf )
 		AudioEngineWorkerThread::startAndWaitForJobs();
 	}
 
-	// handle sample-exact data in master volume fader
-	ValueBuffer * volBuf = m_mixerChannels[0]->m_volumeModel.valueBuffer();
-
-	if( volBuf )
+	// the output buffer has been cleared already, so there's nothing to do
+	// if the whole mix is silent
+	if( !m_mixerChannels[0]->m_silent )
 	{
-		for( int f = 0; f < fpp; f++ )
+		// handle sample-exact data in master volume fader
+		ValueBuffer * volBuf = m_mixerChannels[0]->m_volumeModel.valueBuffer();
+
+		if( volBuf )
 		{
-			m_mixerChannels[0]->m_buffer[f][0] *= volBuf->values()[f];
-			m_mixerChannels[0]->m_buffer[f][1] *= volBuf->values()[f];
+			for( int f = 0; f < fpp; f++ )
+			{
+				m_mixerChannels[0]->m_buffer[f][0] *= volBuf->values()[f];
+				m_mixerChannels[0]->m_buffer[f][1] *= volBuf->values()[f];
+			}
 		}
-	}
 
-	const float v = volBuf
-		? 1.0f
-		: m_mixerChannels[0]->m_volumeModel.value();
-	MixHelpers::addSanitizedMultiplied( _buf, m_mixerChannels[0]->m_buffer, v, fpp );
+		const float v = volBuf
+			? 1.0f
+			: m_mixerChannels[0]->m_volumeModel.value();
+		MixHelpers::addSanitizedMultiplied( _buf, m_mixerChannels[0]->m_buffer, v, fpp );
+	}
 
-	// clear all channel buffers and
+	// clear all channel buffers which have been written to and
 	// reset channel process state
 	for( int i = 0; i < numChannels(); ++i)
 	{
-		BufferManager::clear( m_mixerChannels[i]->m_buffer,
-				Engine::audioEngine()->framesPerPeriod() );
+		if( !m_mixerChannels[i]->m_silent )
+		{
+			BufferManager::clear( m_mixerChannels[i]->m_buffer,
+					Engine::audioEngine()->framesPerPeriod() );
+			m_mixerChannels[i]->m_silent = true;
+		}
 		m_mixerChannels[i]->reset();
 		m_mixerChannels[i]->m_queued = false;
 		// also reset hasInput
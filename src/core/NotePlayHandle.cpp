@@ -79,7 +79,10 @@ NotePlayHandle::NotePlayHandle( InstrumentTrack* instrumentTrack,
 	m_songGlobalParentOffset( 0 ),
 	m_midiChannel( midiEventChannel >= 0 ? midiEventChannel : instrumentTrack->midiPort()->realOutputChannel() ),
 	m_origin( origin ),
-	m_frequencyNeedsUpdate( false )
+	m_frequencyNeedsUpdate( false ),
+	m_baseNoteVersion( instrumentTrack->baseNoteVersion() ),
+	m_framesThisPeriod( 0 ),
+	m_renderedInBatch( false )
 {
 	lock();
 	if( hasParent() == false )
@@ -114,6 +117,14 @@ NotePlayHandle::NotePlayHandle( InstrumentTrack* instrumentTrack,
 		setUsesBuffer( false );
 	}
 
+	// voices of batched instruments are rendered by the instrument's play handle
+	// and are never queued as jobs on their own
+	if( m_instrumentTrack->instrument() && m_instrumentTrack->instrument()->flags() & Instrument::Flag::IsVoiceBatched )
+	{
+		m_renderedInBatch = true;
+		setUsesBuffer( false );
+	}
+
 	setAudioPort( instrumentTrack->audioPort() );
 
 	unlock();
@@ -185,16 +196,38 @@ int NotePlayHandle::midiKey() const
 
 void NotePlayHandle::play( sampleFrame * _working_buffer )
 {
-	if (m_muted)
+	if( !startPeriod() )
 	{
 		return;
 	}
 
+	// under some circumstances we're called even if there's nothing to play
+	// therefore do an additional check which fixes crash e.g. when
+	// decreasing release of an instrument-track while the note is active
+	if( framesLeft() > 0 )
+	{
+		// play note!
+		m_instrumentTrack->playNote( this, _working_buffer );
+	}
+
+	finishPeriod();
+}
+
+
+
+
+bool NotePlayHandle::startPeriod()
+{
+	if (m_muted)
+	{
+		return false;
+	}
+
 	// if the note offset falls over to next period, then don't start playback yet
 	if( offset() >= Engine::audioEngine()->framesPerPeriod() )
 	{
 		setOffset( offset() - Engine::audioEngine()->framesPerPeriod() );
-		return;
+		return false;
 	}
 
 	lock();
@@ -211,7 +244,7 @@ void NotePlayHandle::play( sampleFrame * _working_buffer )
 		if (m_totalFramesPlayed == 0)
 		{
 			unlock();
-			return;
+			return false;
 		}
 	}
 
@@ -234,34 +267,38 @@ void NotePlayHandle::play( sampleFrame * _working_buffer )
 			offset() );
 	}
 
-	if( m_frequencyNeedsUpdate )
+	const int baseNoteVersion = m_instrumentTrack->baseNoteVersion();
+	if( m_frequencyNeedsUpdate || baseNoteVersion != m_baseNoteVersion )
 	{
+		m_baseNoteVersion = baseNoteVersion;
 		updateFrequency();
 	}
 
 	// number of frames that can be played this period
-	f_cnt_t framesThisPeriod = m_totalFramesPlayed == 0
+	m_framesThisPeriod = m_totalFramesPlayed == 0
 		? Engine::audioEngine()->framesPerPeriod() - offset()
 		: Engine::audioEngine()->framesPerPeriod();
 
 	// check if we start release during this period
 	if( m_released == false &&
 		instrumentTrack()->isSustainPedalPressed() == false &&
-		m_totalFramesPlayed + framesThisPeriod > m_frames )
+		m_totalFramesPlayed + m_framesThisPeriod > m_frames )
 	{
 		noteOff( m_totalFramesPlayed == 0
 			? ( m_frames + offset() ) // if we have noteon and noteoff during the same period, take offset in account for release frame
 			: ( m_frames - m_totalFramesPlayed ) ); // otherwise, the offset is already negated and can be ignored
 	}
 
-	// under some circumstances we're called even if there's nothing to play
-	// therefore do an additional check which fixes crash e.g. when
-	// decreasing release of an instrument-track while the note is active
-	if( framesLeft() > 0 )
-	{
-		// play note!
-		m_instrumentTrack->playNote( this, _working_buffer );
-	}
+	// stay locked until finishPeriod()
+	return true;
+}
+
+
+
+
+void NotePlayHandle::finishPeriod()
+{
+	const f_cnt_t framesThisPeriod = m_framesThisPeriod;
 
 	if( m_released && (!instrumentTrack()->isSustainPedalPressed() ||
 		m_releaseStarted) )
@@ -36,6 +36,7 @@
 #include "AutomatableModel.h"
 #include "fftw3.h"
 #include "fft_helpers.h"
+#include "StartupCache.h"
 
 
 namespace lmms
@@ -44,8 +45,25 @@ namespace lmms
 
 void Oscillator::waveTableInit()
 {
+	// FFTW_MEASURE is slow, unless the plans have been measured before
+	StartupCache::importFftwWisdom();
 	createFFTPlans();
-	generateWaveTables();
+
+	s_waveTables.resize(NumWaveShapeTables * s_waveformLayout.size);
+	const std::size_t waveTablesSize = s_waveTables.size() * sizeof(sample_t);
+
+	// bump the version whenever the generated tables change
+	const QByteArray cacheKey = QByteArray("oscillator-wavetables-2/")
+		+ QByteArray::number(NumWaveShapeTables) + '/'
+		+ QByteArray::number(OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT) + '/'
+		+ QByteArray::number(OscillatorConstants::WAVETABLE_LENGTH) + '/'
+		+ QByteArray::number(s_waveformLayout.size);
+	if (!StartupCache::loadBlob("oscillator-wavetables", cacheKey, s_waveTables.data(), waveTablesSize))
+	{
+		generateWaveTables();
+		StartupCache::storeBlob("oscillator-wavetables", cacheKey, s_waveTables.data(), waveTablesSize);
+		StartupCache::exportFftwWisdom();
+	}
 	// The oscillator FFT plans remain throughout the application lifecycle
 	// due to being expensive to create, and being used whenever a userwave form is changed
 	// deleted in main.cpp main()
@@ -70,7 +88,11 @@ Oscillator::Oscillator(const IntModel *wave_shape_model,
 	m_phase(phase_offset),
 	m_userWave(nullptr),
 	m_useWaveTable(false),
-	m_isModulator(false)
+	m_isModulator(false),
+	m_waveTableBand(1),
+	m_waveTableOffset(s_waveformLayout.offset[1]),
+	m_waveTableLength(s_waveformLayout.length[1]),
+	m_sineAboveMaxFreq(false)
 {
 }
 
@@ -88,6 +110,13 @@ void Oscillator::update(sampleFrame* ab, const fpp_t frames, const ch_cnt_t chnl
 	// The sampling functions will check this variable and avoid using band-limited
 	// wavetables, since they contain ringing that would lead to unexpected results.
 	m_isModulator = modulator;
+
+	const float currentFreq = m_freq * m_detuning_div_samplerate * Engine::audioEngine()->processingSampleRate();
+	m_waveTableBand = waveTableBandFromFreq(currentFreq);
+	m_waveTableOffset = s_waveformLayout.offset[m_waveTableBand];
+	m_waveTableLength = s_waveformLayout.length[m_waveTableBand];
+	m_sineAboveMaxFreq = currentFreq >= OscillatorConstants::MAX_FREQ;
+
 	if (m_subOsc != nullptr)
 	{
 		switch (static_cast<ModulationAlgo>(m_modulationAlgoModel->value()))
@@ -116,15 +145,33 @@ void Oscillator::update(sampleFrame* ab, const fpp_t frames, const ch_cnt_t chnl
 }
 
 
-void Oscillator::generateSawWaveTable(int bands, sample_t* table, int firstBand)
+OscillatorConstants::WaveformLayout Oscillator::createWaveformLayout()
+{
+	OscillatorConstants::WaveformLayout layout;
+	layout.size = 0;
+	for (int i = 0; i < OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT; ++i)
+	{
+		const int needed = 2 * (bandHarmonics(i) + 1) * OscillatorConstants::WAVETABLE_OVERSAMPLING;
+		int length = OscillatorConstants::MIN_WAVETABLE_LENGTH;
+		while (length < needed && length < OscillatorConstants::WAVETABLE_LENGTH) { length *= 2; }
+
+		layout.offset[i] = layout.size;
+		layout.length[i] = std::min(length, OscillatorConstants::WAVETABLE_LENGTH);
+		layout.size += layout.length[i];
+	}
+	return layout;
+}
+
+
+void Oscillator::generateSawWaveTable(int bands, sample_t* table, int length, int firstBand)
 {
 	// sawtooth wave contain both even and odd harmonics
 	// hence sinewaves are added for all bands
 	// https://en.wikipedia.org/wiki/Sawtooth_wave
-	for (int i = 0; i < OscillatorConstants::WAVETABLE_LENGTH; i++)
+	for (int i = 0; i < length; i++)
 	{
 		// add offset to the position index to match phase of the non-wavetable saw wave; precompute "/ period"
-		const float imod = (i - OscillatorConstants::WAVETABLE_LENGTH / 2.f) / OscillatorConstants::WAVETABLE_LENGTH;
+		const float imod = (i - length / 2.f) / length;
 		for (int n = firstBand; n <= bands; n++)
 		{
 			table[i] += (n % 2 ? 1.0f : -1.0f) / n * sinf(F_2PI * n * imod) / F_PI_2;
@@ -133,41 +180,72 @@ void Oscillator::generateSawWaveTable(int bands, sample_t* table, int firstBand)
 }
 
 
-void Oscillator::generateTriangleWaveTable(int bands, sample_t* table, int firstBand)
+void Oscillator::generateTriangleWaveTable(int bands, sample_t* table, int length, int firstBand)
 {
 	// triangle waves contain only odd harmonics
 	// hence sinewaves are added for alternate bands
 	// https://en.wikipedia.org/wiki/Triangle_wave
-	for (int i = 0; i < OscillatorConstants::WAVETABLE_LENGTH; i++)
+	for (int i = 0; i < length; i++)
 	{
 		for (int n = firstBand | 1; n <= bands; n += 2)
 		{
 			table[i] += (n & 2 ? -1.0f : 1.0f) / powf(n, 2.0f) *
-				sinf(F_2PI * n * i / (float)OscillatorConstants::WAVETABLE_LENGTH) / (F_PI_SQR / 8);
+				sinf(F_2PI * n * i / (float)length) / (F_PI_SQR / 8);
 		}
 	}
 }
 
 
-void Oscillator::generateSquareWaveTable(int bands, sample_t* table, int firstBand)
+void Oscillator::generateSquareWaveTable(int bands, sample_t* table, int length, int firstBand)
 {
 	// square waves only contain odd harmonics,
 	// at diffrent levels when compared to triangle waves
 	// https://en.wikipedia.org/wiki/Square_wave
-	for (int i = 0; i < OscillatorConstants::WAVETABLE_LENGTH; i++)
+	for (int i = 0; i < length; i++)
 	{
 		for (int n = firstBand | 1; n <= bands; n += 2)
 		{
-			table[i] += (1.0f / n) * sinf(F_2PI * i * n / OscillatorConstants::WAVETABLE_LENGTH) / (F_PI / 4);
+			table[i] += (1.0f / n) * sinf(F_2PI * i * n / length) / (F_PI / 4);
 		}
 	}
 }
 
 
 
-// Expects waveform converted to frequency domain to be present in the spectrum buffer
-void Oscillator::generateFromFFT(int bands, sample_t* table)
+// Expects the spectrum of one period of the wave, as interleaved real and imaginary parts of the bins
+// computed by s_fftPlan
+void Oscillator::generateFromFFT(int bands, sample_t* table, int length, const std::vector<float>& spectrum)
 {
+	// The inverse FFT isn't scaled, normalize() divides by the full wave table length
+	const float scale = 1.0f / OscillatorConstants::WAVETABLE_LENGTH;
+
+	if (length < OscillatorConstants::WAVETABLE_LENGTH)
+	{
+		// Shorter tables are made by summing the bands directly, there are few of them and there
+		// are no FFT plans for all table lengths. The layout makes sure the table can hold them.
+		std::vector<float> cosTable(length);
+		std::vector<float> sinTable(length);
+		for (int i = 0; i < length; ++i)
+		{
+			cosTable[i] = std::cos(F_2PI * i / length);
+			sinTable[i] = std::sin(F_2PI * i / length);
+		}
+		for (int i = 0; i < length; ++i)
+		{
+			double sum = spectrum[0];
+			for (int n = 1; n <= bands; ++n)
+			{
+				const int phase = (n * i) % length;
+				sum += 2.0 * (spectrum[2 * n] * cosTable[phase] - spectrum[2 * n + 1] * sinTable[phase]);
+			}
+			table[i] = static_cast<sample_t>(sum * scale);
+		}
+		return;
+	}
+
+	// The inverse FFT overwrites the spectrum buffer, so restore it first
+	std::copy(spectrum.begin(), spectrum.end(), &s_specBuf[0][0]);
+
 	// Keep only specified number of bands, set the rest to zero.
 	// Add a +1 offset to the requested number of bands, since the first "useful" frequency falls into bin 1.
 	// I.e., for bands = 1, keeping just bin 0 (center 0 Hz, +- 4 Hz) makes no sense, it would not produce any tone.
@@ -182,27 +260,33 @@ void Oscillator::generateFromFFT(int bands, sample_t* table)
 	normalize(s_sampleBuffer.data(), table, OscillatorConstants::WAVETABLE_LENGTH, 2*OscillatorConstants::WAVETABLE_LENGTH + 1);
 }
 
-void Oscillator::generateAntiAliasUserWaveTable(SampleBuffer *sampleBuffer)
+// Expects one period of the wave without band limit to be present in the sample buffer
+void Oscillator::generateWaveformFromFFT(sample_t* waveform)
 {
-	if (sampleBuffer->m_userAntiAliasWaveTable == nullptr) {return;}
+	// The spectrum is the same for all bands, so only transform it once
+	fftwf_execute(s_fftPlan);
+	const auto bins = OscillatorConstants::WAVETABLE_LENGTH / 2 + 1;
+	const auto spectrum = std::vector<float>(&s_specBuf[0][0], &s_specBuf[0][0] + 2 * bins);
 
 	for (int i = 0; i < OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT; ++i)
 	{
-		for (int i = 0; i < OscillatorConstants::WAVETABLE_LENGTH; ++i)
-		{
-			s_sampleBuffer[i] = sampleBuffer->userWaveSample((float)i / (float)OscillatorConstants::WAVETABLE_LENGTH);
-		}
-		fftwf_execute(s_fftPlan);
-		Oscillator::generateFromFFT(OscillatorConstants::MAX_FREQ / freqFromWaveTableBand(i), (*(sampleBuffer->m_userAntiAliasWaveTable))[i].data());
+		generateFromFFT(bandHarmonics(i), waveform + s_waveformLayout.offset[i], s_waveformLayout.length[i], spectrum);
 	}
 }
 
+void Oscillator::generateAntiAliasUserWaveTable(const SampleBuffer* sampleBuffer, sample_t* waveform)
+{
+	for (int i = 0; i < OscillatorConstants::WAVETABLE_LENGTH; ++i)
+	{
+		s_sampleBuffer[i] = sampleBuffer->userWaveSample((float)i / (float)OscillatorConstants::WAVETABLE_LENGTH);
+	}
+	generateWaveformFromFFT(waveform);
+}
 
 
-sample_t Oscillator::s_waveTables
-	[Oscillator::NumWaveShapeTables]
-	[OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT]
-	[OscillatorConstants::WAVETABLE_LENGTH];
+
+const OscillatorConstants::WaveformLayout Oscillator::s_waveformLayout = Oscillator::createWaveformLayout();
+std::vector<sample_t> Oscillator::s_waveTables;
 fftwf_plan Oscillator::s_fftPlan;
 fftwf_plan Oscillator::s_ifftPlan;
 fftwf_complex * Oscillator::s_specBuf;
@@ -235,30 +319,34 @@ void Oscillator::generateWaveTables()
 	// Generate tables for simple shaped (constructed by summing sine waves).
 	// Start from the table that contains the least number of bands, and re-use each table in the following
 	// iteration, adding more bands in each step and avoiding repeated computation of earlier bands.
-	using generator_t = void (*)(int, sample_t*, int);
+	// The tables of higher bands are shorter, a table can only be re-used if the next one has the same length.
+	using generator_t = void (*)(int, sample_t*, int, int);
 	auto simpleGen = [](WaveShape shape, generator_t generator)
 	{
-		const int shapeID = static_cast<std::size_t>(shape) - FirstWaveShapeTable;
+		sample_t* const waveform = waveTables(shape);
 		int lastBands = 0;
-
-		// Clear the first wave table
-		std::fill(
-		    std::begin(s_waveTables[shapeID][OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT - 1]),
-		    std::end(s_waveTables[shapeID][OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT - 1]),
-		    0.f);
+		int lastLength = 0;
+		sample_t* lastTable = nullptr;
 
 		for (int i = OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT - 1; i >= 0; i--)
 		{
-			const int bands = OscillatorConstants::MAX_FREQ / freqFromWaveTableBand(i);
-			generator(bands, s_waveTables[shapeID][i], lastBands + 1);
-			lastBands = bands;
-			if (i)
+			sample_t* const table = waveform + s_waveformLayout.offset[i];
+			const int length = s_waveformLayout.length[i];
+			if (length == lastLength)
 			{
-				std::copy(
-					s_waveTables[shapeID][i],
-					s_waveTables[shapeID][i] + OscillatorConstants::WAVETABLE_LENGTH,
-					s_waveTables[shapeID][i - 1]);
+				std::copy(lastTable, lastTable + length, table);
 			}
+			else
+			{
+				std::fill(table, table + length, 0.f);
+				lastBands = 0;
+			}
+
+			const int bands = bandHarmonics(i);
+			generator(bands, table, length, lastBands + 1);
+			lastBands = bands;
+			lastLength = length;
+			lastTable = table;
 		}
 	};
 
@@ -267,26 +355,18 @@ void Oscillator::generateWaveTables()
 	auto fftGen = []()
 	{
 		// Generate moogSaw tables
-		for (int i = 0; i < OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT; ++i)
+		for (int i = 0; i < OscillatorConstants::WAVETABLE_LENGTH; ++i)
 		{
-			for (int i = 0; i < OscillatorConstants::WAVETABLE_LENGTH; ++i)
-			{
-				Oscillator::s_sampleBuffer[i] = moogSawSample((float)i / (float)OscillatorConstants::WAVETABLE_LENGTH);
-			}
-			fftwf_execute(s_fftPlan);
-			generateFromFFT(OscillatorConstants::MAX_FREQ / freqFromWaveTableBand(i), s_waveTables[static_cast<std::size_t>(WaveShape::MoogSaw) - FirstWaveShapeTable][i]);
+			s_sampleBuffer[i] = moogSawSample((float)i / (float)OscillatorConstants::WAVETABLE_LENGTH);
 		}
+		generateWaveformFromFFT(waveTables(WaveShape::MoogSaw));
 
 		// Generate exponential tables
-		for (int i = 0; i < OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT; ++i)
+		for (int i = 0; i < OscillatorConstants::WAVETABLE_LENGTH; ++i)
 		{
-			for (int i = 0; i < OscillatorConstants::WAVETABLE_LENGTH; ++i)
-			{
-				s_sampleBuffer[i] = expSample((float)i / (float)OscillatorConstants::WAVETABLE_LENGTH);
-			}
-			fftwf_execute(s_fftPlan);
-			generateFromFFT(OscillatorConstants::MAX_FREQ / freqFromWaveTableBand(i), s_waveTables[static_cast<std::size_t>(WaveShape::Exponential) - FirstWaveShapeTable][i]);
+			s_sampleBuffer[i] = expSample((float)i / (float)OscillatorConstants::WAVETABLE_LENGTH);
 		}
+		generateWaveformFromFFT(waveTables(WaveShape::Exponential));
 	};
 
 // TODO: Mingw compilers currently do not support std::thread. There are some 3rd-party workarounds available,
@@ -693,9 +773,7 @@ void Oscillator::updateFM( sampleFrame * _ab, const fpp_t _frames,
 template<>
 inline sample_t Oscillator::getSample<Oscillator::WaveShape::Sine>(const float sample)
 {
-	const float current_freq = m_freq * m_detuning_div_samplerate * Engine::audioEngine()->processingSampleRate();
-
-	if (!m_useWaveTable || current_freq < OscillatorConstants::MAX_FREQ)
+	if (!m_useWaveTable || !m_sineAboveMaxFreq)
 	{
 		return sinSample(sample);
 	}
@@ -714,7 +792,7 @@ inline sample_t Oscillator::getSample<Oscillator::WaveShape::Triangle>(
 {
 	if (m_useWaveTable && !m_isModulator)
 	{
-		return wtSample(s_waveTables[static_cast<std::size_t>(WaveShape::Triangle) - FirstWaveShapeTable],_sample);
+		return wtSample(waveTables(WaveShape::Triangle), _sample);
 	}
 	else
 	{
@@ -731,7 +809,7 @@ inline sample_t Oscillator::getSample<Oscillator::WaveShape::Saw>(
 {
 	if (m_useWaveTable && !m_isModulator)
 	{
-		return wtSample(s_waveTables[static_cast<std::size_t>(WaveShape::Saw) - FirstWaveShapeTable], _sample);
+		return wtSample(waveTables(WaveShape::Saw), _sample);
 	}
 	else
 	{
@@ -748,7 +826,7 @@ inline sample_t Oscillator::getSample<Oscillator::WaveShape::Square>(
 {
 	if (m_useWaveTable && !m_isModulator)
 	{
-		return wtSample(s_waveTables[static_cast<std::size_t>(WaveShape::Square) - FirstWaveShapeTable], _sample);
+		return wtSample(waveTables(WaveShape::Square), _sample);
 	}
 	else
 	{
@@ -765,7 +843,7 @@ inline sample_t Oscillator::getSample<Oscillator::WaveShape::MoogSaw>(
 {
 	if (m_useWaveTable && !m_isModulator)
 	{
-		return wtSample(s_waveTables[static_cast<std::size_t>(WaveShape::MoogSaw) - FirstWaveShapeTable], _sample);
+		return wtSample(waveTables(WaveShape::MoogSaw), _sample);
 	}
 	else
 	{
@@ -782,7 +860,7 @@ inline sample_t Oscillator::getSample<Oscillator::WaveShape::Exponential>(
 {
 	if (m_useWaveTable && !m_isModulator)
 	{
-		return wtSample(s_waveTables[static_cast<std::size_t>(WaveShape::Exponential) - FirstWaveShapeTable], _sample);
+		return wtSample(waveTables(WaveShape::Exponential), _sample);
 	}
 	else
 	{
@@ -809,12 +887,13 @@ inline sample_t Oscillator::getSample<Oscillator::WaveShape::UserDefined>(
 {
 	if (m_useWaveTable && !m_isModulator)
 	{
-		return wtSample(m_userWave->m_userAntiAliasWaveTable, _sample);
-	}
-	else
-	{
-		return userWaveSample(_sample);
+		// the tables are built on demand, until then play the raw wave
+		if (const sample_t* waveform = m_userWave->userAntiAliasWaveTable())
+		{
+			return wtSample(waveform, _sample);
+		}
 	}
+	return userWaveSample(_sample);
 }
 
 
@@ -24,6 +24,7 @@
  
 #include "PlayHandle.h"
 #include "AudioEngine.h"
+#include "AudioPort.h"
 #include "BufferManager.h"
 #include "Engine.h"
 
@@ -37,9 +38,12 @@ PlayHandle::PlayHandle(const Type type, f_cnt_t offset) :
 		m_type(type),
 		m_offset(offset),
 		m_affinity(QThread::currentThread()),
-		m_playHandleBuffer(BufferManager::acquire()),
+		m_playHandleBuffer(nullptr),
 		m_bufferReleased(true),
-		m_usesBuffer(true)
+		m_usesBuffer(true),
+		m_audioPort(nullptr),
+		m_engineIndex(-1),
+		m_removalIndex(-1)
 {
 }
 
@@ -52,8 +56,15 @@ PlayHandle::~PlayHandle()
 
 void PlayHandle::doProcessing()
 {
+	const AudioPort::RandScope rand( m_audioPort );
 	if( m_usesBuffer )
 	{
+		// acquire lazily, so handles which never render into a buffer of their
+		// own (e.g. voices of single-streamed or batched instruments) don't hold one
+		if (m_playHandleBuffer == nullptr)
+		{
+			m_playHandleBuffer = BufferManager::acquire();
+		}
 		m_bufferReleased = false;
 		BufferManager::clear(m_playHandleBuffer, Engine::audioEngine()->framesPerPeriod());
 		play( buffer() );
@@ -34,6 +34,7 @@
 #include "GuiApplication.h"
 #include "DummyPlugin.h"
 #include "AutomatableModel.h"
+#include "DataFile.h"
 #include "Song.h"
 #include "PluginFactory.h"
 
@@ -226,8 +227,10 @@ Plugin * Plugin::instantiate(const QString& pluginName, Model * parent,
 	}
 	else
 	{
-		InstantiationHook instantiationHook;
-		if ((instantiationHook = ( InstantiationHook ) pi.library->resolve( "lmms_plugin_main" )))
+		// libraries of plugins from the startup cache are loaded on first use
+		InstantiationHook instantiationHook = nullptr;
+		if (getPluginFactory()->load(pi) &&
+			(instantiationHook = ( InstantiationHook ) pi.library->resolve( "lmms_plugin_main" )))
 		{
 			inst = instantiationHook(parent, data);
 			if(!inst) {
@@ -253,6 +256,44 @@ Plugin * Plugin::instantiate(const QString& pluginName, Model * parent,
 
 
 
+void Plugin::prefetch(const DataFile& dataFile)
+{
+	const QDomNodeList instruments = dataFile.elementsByTagName("instrument");
+	for (int i = 0; !instruments.item(i).isNull(); ++i)
+	{
+		const QDomElement instrument = instruments.item(i).toElement();
+		const PluginFactory::PluginInfo& pi =
+			getPluginFactory()->pluginInfo(instrument.attribute("name").toUtf8());
+
+		// the library would be loaded for restoring the instrument anyway
+		PrefetchHook prefetchHook = nullptr;
+		if (getPluginFactory()->load(pi) &&
+			(prefetchHook = (PrefetchHook) pi.library->resolve("lmms_plugin_prefetch")))
+		{
+			prefetchHook(instrument.firstChildElement());
+		}
+	}
+}
+
+
+
+
+void Plugin::dropPrefetched()
+{
+	for (const PluginFactory::PluginInfo& pi : getPluginFactory()->pluginInfos())
+	{
+		if (pi.isNull() || !pi.library->isLoaded()) { continue; }
+
+		if (auto dropHook = (DropPrefetchedHook) pi.library->resolve("lmms_plugin_drop_prefetched"))
+		{
+			dropHook();
+		}
+	}
+}
+
+
+
+
 void Plugin::collectErrorForUI( QString errMsg )
 {
 	Engine::getSong()->collectError( errMsg );
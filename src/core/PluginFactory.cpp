@@ -24,15 +24,22 @@
 
 #include "PluginFactory.h"
 
+#include <QBuffer>
 #include <QCoreApplication>
+#include <QDataStream>
 #include <QDebug>
 #include <QDir>
+#include <QImage>
 #include <QLibrary>
+#include <QPixmapCache>
+#include <map>
 #include <memory>
 #include "lmmsconfig.h"
 
 #include "ConfigManager.h"
+#include "embed.h"
 #include "Plugin.h"
+#include "StartupCache.h"
 
 // QT qHash specialization, needs to be in global namespace
 qint64 qHash(const QFileInfo& fi)
@@ -50,6 +57,68 @@ namespace lmms
 	QStringList nameFilters("lib*.so");
 #endif
 
+//! Libraries from the plugin directories which plugins are linked against.
+//! They are loaded first, as the plugin directory isn't in the search path
+//! of the dynamic linker on all systems.
+const std::map<QString, QStringList> pluginDependencies =
+{
+	{ "carlapatchbay", { "carlabase" } },
+	{ "carlarack", { "carlabase" } },
+	{ "vestige", { "vstbase" } },
+	{ "vsteffect", { "vstbase" } },
+};
+
+//! Startup cache of the native plugins - the key has to change with the
+//! layout of the entries, so older caches are discarded
+const QString pluginCacheName = "native-plugins";
+const QByteArray pluginCacheKey = "plugins-2";
+
+//! What the startup cache knows about a library
+enum class CachedLibrary
+{
+	NoPlugin,
+	Plugin, //!< the descriptor is cached
+	LoadAlways //!< the descriptor can't be cached, e.g. for sub plugins
+};
+
+//! Logo of a plugin whose library isn't loaded. The artwork of plugins is
+//! embedded into their libraries, so the startup cache keeps the image data.
+class CachedPixmapLoader : public PixmapLoader
+{
+public:
+	CachedPixmapLoader(const QString& name, QByteArray data) :
+		PixmapLoader(name),
+		m_data(std::move(data))
+	{
+	}
+
+	QPixmap pixmap() const override
+	{
+		// same key as embed::getIconPixmap() uses once the library is loaded
+		const QString cacheName = QString(m_name).replace("::", "/");
+		QPixmap pixmap;
+		if (!QPixmapCache::find(cacheName, &pixmap) && pixmap.loadFromData(m_data, "PNG"))
+		{
+			QPixmapCache::insert(cacheName, pixmap);
+		}
+		return pixmap;
+	}
+
+private:
+	QByteArray m_data;
+};
+
+struct PluginFactory::CachedDescriptor
+{
+	QByteArray name;
+	QByteArray displayName;
+	QByteArray description;
+	QByteArray author;
+	QByteArray supportedFileTypes;
+	std::unique_ptr<PixmapLoader> logo;
+	Plugin::Descriptor descriptor;
+};
+
 std::unique_ptr<PluginFactory> PluginFactory::s_instance;
 
 PluginFactory::PluginFactory()
@@ -58,6 +127,8 @@ PluginFactory::PluginFactory()
 	discoverPlugins();
 }
 
+PluginFactory::~PluginFactory() = default;
+
 void PluginFactory::setupSearchPaths()
 {
 	// Adds a search path relative to the main executable if the path exists.
@@ -134,6 +205,33 @@ PluginFactory::PluginInfo PluginFactory::pluginInfo(const char* name) const
 	return PluginInfo();
 }
 
+bool PluginFactory::load(const PluginInfo& info)
+{
+	if (info.isNull()) { return false; }
+	if (info.library->isLoaded()) { return true; }
+
+	QString pluginName = info.file.baseName();
+	if (pluginName.startsWith("lib")) { pluginName = pluginName.mid(3); }
+
+	const auto dependencies = pluginDependencies.find(pluginName);
+	if (dependencies != pluginDependencies.end())
+	{
+		for (const QString& dependency : dependencies->second)
+		{
+			QLibrary(info.file.absolutePath() + '/'
+				+ QString(info.file.fileName()).replace(pluginName, dependency)).load();
+		}
+	}
+
+	if (!info.library->load())
+	{
+		m_errors[info.file.baseName()] = info.library->errorString();
+		qWarning("%s", info.library->errorString().toLocal8Bit().data());
+		return false;
+	}
+	return true;
+}
+
 QString PluginFactory::errorString(QString pluginName) const
 {
 	static QString notfound = qApp->translate("PluginFactory", "Plugin not found.");
@@ -157,38 +255,126 @@ void PluginFactory::discoverPlugins()
 #endif
 	}
 
-	// Cheap dependency handling: zynaddsubfx needs ZynAddSubFxCore. By loading
-	// all libraries twice we ensure that libZynAddSubFxCore is found.
-	for (const QFileInfo& file : files)
-	{
-		QLibrary(file.absoluteFilePath()).load();
-	}
+	// Descriptors of the libraries seen before, so that a library is only
+	// loaded once a plugin from it is instantiated
+	const StartupCache::Entries cache = StartupCache::loadEntries(pluginCacheName, pluginCacheKey);
+	StartupCache::Entries newCache;
 
 	for (const QFileInfo& file : files)
 	{
-		auto library = std::make_shared<QLibrary>(file.absoluteFilePath());
-		if (! library->load()) {
-			m_errors[file.baseName()] = library->errorString();
-			qWarning("%s", library->errorString().toLocal8Bit().data());
+		const QString path = file.absoluteFilePath();
+		const QByteArray stamp = StartupCache::fileStamp(path);
+		auto library = std::make_shared<QLibrary>(path);
+
+		Plugin::Descriptor* pluginDescriptor = nullptr;
+		const QByteArray cached = cache.value(path);
+		QDataStream in(cached);
+		QByteArray cachedStamp;
+		qint32 cachedLibrary = -1;
+		in >> cachedStamp >> cachedLibrary;
+
+		if (in.status() == QDataStream::Ok && cachedStamp == stamp
+			&& cachedLibrary == static_cast<qint32>(CachedLibrary::NoPlugin))
+		{
+			newCache[path] = cached;
 			continue;
 		}
+		else if (in.status() == QDataStream::Ok && cachedStamp == stamp
+			&& cachedLibrary == static_cast<qint32>(CachedLibrary::Plugin))
+		{
+			auto desc = std::make_unique<CachedDescriptor>();
+			QString logo;
+			QByteArray logoData;
+			qint32 version, type;
+			in >> desc->name >> desc->displayName >> desc->description >> desc->author
+				>> version >> type >> logo >> logoData >> desc->supportedFileTypes;
+			if (in.status() == QDataStream::Ok)
+			{
+				if (!logo.isEmpty()) { desc->logo = std::make_unique<CachedPixmapLoader>(logo, logoData); }
+				desc->descriptor = {
+					desc->name.constData(),
+					desc->displayName.constData(),
+					desc->description.constData(),
+					desc->author.constData(),
+					version,
+					static_cast<Plugin::Type>(type),
+					desc->logo.get(),
+					desc->supportedFileTypes.isNull() ? nullptr : desc->supportedFileTypes.constData(),
+					nullptr
+				};
+				pluginDescriptor = &desc->descriptor;
+				m_cachedDescriptors.push_back(std::move(desc));
+				newCache[path] = cached;
+			}
+		}
 
-		Plugin::Descriptor* pluginDescriptor = nullptr;
-		if (library->resolve("lmms_plugin_main"))
+		if (pluginDescriptor == nullptr)
 		{
-			QString descriptorName = file.baseName() + "_plugin_descriptor";
-			if( descriptorName.left(3) == "lib" )
+			PluginInfo probe;
+			probe.file = file;
+			probe.library = library;
+			if (!load(probe)) { continue; }
+
+			if (library->resolve("lmms_plugin_main"))
+			{
+				QString descriptorName = file.baseName() + "_plugin_descriptor";
+				if( descriptorName.left(3) == "lib" )
+				{
+					descriptorName = descriptorName.mid(3);
+				}
+
+				pluginDescriptor = reinterpret_cast<Plugin::Descriptor*>(library->resolve(descriptorName.toUtf8().constData()));
+				if(pluginDescriptor == nullptr)
+				{
+					qWarning() << qApp->translate("PluginFactory", "LMMS plugin %1 does not have a plugin descriptor named %2!").
+								  arg(file.absoluteFilePath()).arg(descriptorName);
+					continue;
+				}
+			}
+
+			// the logos of plugins are embedded as ":/artwork/<plugin>/<name>"
+			// and are only available while the library is loaded
+			const QString logo = pluginDescriptor && pluginDescriptor->logo
+				? pluginDescriptor->logo->pixmapName()
+				: QString();
+			QByteArray logoData;
+			if (logo.contains("::"))
 			{
-				descriptorName = descriptorName.mid(3);
+				const QImage image(QString(":/artwork/%1").arg(QString(logo).replace("::", "/")));
+				QBuffer buffer(&logoData);
+				if (image.isNull() || !buffer.open(QIODevice::WriteOnly) || !image.save(&buffer, "PNG"))
+				{
+					logoData.clear();
+				}
 			}
 
-			pluginDescriptor = reinterpret_cast<Plugin::Descriptor*>(library->resolve(descriptorName.toUtf8().constData()));
-			if(pluginDescriptor == nullptr)
+			QByteArray entry;
+			QDataStream out(&entry, QIODevice::WriteOnly);
+			out << stamp;
+			if (pluginDescriptor == nullptr)
 			{
-				qWarning() << qApp->translate("PluginFactory", "LMMS plugin %1 does not have a plugin descriptor named %2!").
-							  arg(file.absoluteFilePath()).arg(descriptorName);
-				continue;
+				out << static_cast<qint32>(CachedLibrary::NoPlugin);
 			}
+			else if (pluginDescriptor->subPluginFeatures || (!logo.isEmpty() && logoData.isEmpty()))
+			{
+				// sub plugins are listed by the library, and other logos
+				// might be compiled in
+				out << static_cast<qint32>(CachedLibrary::LoadAlways);
+			}
+			else
+			{
+				out << static_cast<qint32>(CachedLibrary::Plugin)
+					<< QByteArray(pluginDescriptor->name)
+					<< QByteArray(pluginDescriptor->displayName)
+					<< QByteArray(pluginDescriptor->description)
+					<< QByteArray(pluginDescriptor->author)
+					<< static_cast<qint32>(pluginDescriptor->version)
+					<< static_cast<qint32>(pluginDescriptor->type)
+					<< logo
+					<< logoData
+					<< QByteArray(pluginDescriptor->supportedFileTypes);
+			}
+			newCache[path] = entry;
 		}
 
 		if(pluginDescriptor)
@@ -241,6 +427,11 @@ void PluginFactory::discoverPlugins()
 		}
 	}
 
+	if (newCache != cache)
+	{
+		StartupCache::storeEntries(pluginCacheName, pluginCacheKey, newCache);
+	}
+
 	m_pluginInfos = pluginInfos;
 	m_descriptors = descriptors;
 }
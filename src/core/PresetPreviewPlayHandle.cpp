@@ -194,13 +194,25 @@ PresetPreviewPlayHandle::PresetPreviewPlayHandle( const QString & _preset_file,
 
 PresetPreviewPlayHandle::~PresetPreviewPlayHandle()
 {
-	Engine::audioEngine()->requestChangeInModel();
+	if (m_previewNote != nullptr)
+	{
+		Engine::audioEngine()->requestChangeInModel();
+		detach();
+		Engine::audioEngine()->doneChangeInModel();
+	}
+}
+
+
+
+
+void PresetPreviewPlayHandle::detach()
+{
 	// not muted by other preset-preview-handle?
 	if (s_previewTC->testAndSetPreviewNote(m_previewNote, nullptr))
 	{
 		m_previewNote->noteOff();
 	}
-	Engine::audioEngine()->doneChangeInModel();
+	m_previewNote = nullptr;
 }
 
 
@@ -217,7 +229,7 @@ void PresetPreviewPlayHandle::play( sampleFrame * _working_buffer )
 
 bool PresetPreviewPlayHandle::isFinished() const
 {
-	return m_previewNote->isMuted();
+	return m_previewNote == nullptr || m_previewNote->isMuted();
 }
 
 
@@ -22,9 +22,13 @@
  *
  */
 
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
+#include <limits>
 
 #include "ProjectJournal.h"
+#include "ConfigManager.h"
 #include "Engine.h"
 #include "JournallingObject.h"
 #include "Song.h"
@@ -36,14 +40,79 @@ namespace lmms
 //! and newly created IDs (have the bit set)
 static const int EO_ID_MSB = 1 << 23;
 
-const int ProjectJournal::MAX_UNDO_STATES = 100; // TODO: make this configurable in settings
+const int ProjectJournal::DEFAULT_MEMORY_BUDGET = 64;
+
+
+namespace
+{
+
+QByteArray saveJournalState( JournallingObject * jo )
+{
+	DataFile dataFile( DataFile::Type::JournalData );
+	jo->saveState( dataFile, dataFile.content() );
+	// no indentation, the states are only kept in memory
+	return dataFile.toByteArray( -1 );
+}
+
+void restoreJournalState( JournallingObject * jo, const QByteArray & state )
+{
+	DataFile dataFile( state );
+	jo->restoreState( dataFile.content().firstChildElement() );
+}
+
+// A delta stores how to get from the newer state to the older one: the
+// length of the common prefix and suffix, followed by the bytes between.
+// Most edits only touch a small part of an object's state.
+//! Marks the first checkpoint of an object in a stack
+const auto NoCheckPoint = std::numeric_limits<std::size_t>::max();
+
+struct DeltaHeader
+{
+	quint32 prefix;
+	quint32 suffix;
+};
+
+QByteArray encodeDelta( const QByteArray & newer, const QByteArray & older )
+{
+	const int maxCommon = std::min( newer.size(), older.size() );
+	const auto prefix = static_cast<int>( std::mismatch( older.begin(),
+		older.begin() + maxCommon, newer.begin() ).first - older.begin() );
+	const auto suffix = static_cast<int>( std::mismatch( older.rbegin(),
+		older.rbegin() + ( maxCommon - prefix ), newer.rbegin() ).first - older.rbegin() );
+
+	const DeltaHeader header = { static_cast<quint32>( prefix ), static_cast<quint32>( suffix ) };
+	QByteArray delta( reinterpret_cast<const char *>( &header ), sizeof( header ) );
+	delta += older.mid( prefix, older.size() - prefix - suffix );
+	return delta;
+}
+
+QByteArray applyDelta( const QByteArray & newer, const QByteArray & delta )
+{
+	DeltaHeader header;
+	std::memcpy( &header, delta.constData(), sizeof( header ) );
+	return newer.left( header.prefix ) + delta.mid( sizeof( header ) ) +
+		newer.right( header.suffix );
+}
+
+} // namespace
+
+
+
 
 ProjectJournal::ProjectJournal() :
 	m_joIDs(),
 	m_undoCheckPoints(),
 	m_redoCheckPoints(),
+	m_memoryBudget( DEFAULT_MEMORY_BUDGET ),
 	m_journalling( false )
 {
+	bool ok = false;
+	const int budget = ConfigManager::inst()->value( "app", "undobudget" ).toInt( &ok );
+	if( ok && budget > 0 )
+	{
+		m_memoryBudget = budget;
+	}
+	m_memoryBudget *= 1024 * 1024;
 }
 
 
@@ -51,20 +120,19 @@ ProjectJournal::ProjectJournal() :
 
 void ProjectJournal::undo()
 {
-	while( !m_undoCheckPoints.isEmpty() )
+	while( !m_undoCheckPoints.checkPoints.empty() )
 	{
-		CheckPoint c = m_undoCheckPoints.pop();
-		JournallingObject *jo = m_joIDs[c.joID];
+		jo_id_t id;
+		const QByteArray state = popCheckPoint( m_undoCheckPoints, id );
+		JournallingObject *jo = m_joIDs.value( id );
 
 		if( jo )
 		{
-			DataFile curState( DataFile::Type::JournalData );
-			jo->saveState( curState, curState.content() );
-			m_redoCheckPoints.push( CheckPoint( c.joID, curState ) );
+			pushCheckPoint( m_redoCheckPoints, id, saveJournalState( jo ) );
 
 			bool prev = isJournalling();
 			setJournalling( false );
-			jo->restoreState( c.data.content().firstChildElement() );
+			restoreJournalState( jo, state );
 			setJournalling( prev );
 			Engine::getSong()->setModified();
 			break;
@@ -76,20 +144,19 @@ void ProjectJournal::undo()
 
 void ProjectJournal::redo()
 {
-	while( !m_redoCheckPoints.isEmpty() )
+	while( !m_redoCheckPoints.checkPoints.empty() )
 	{
-		CheckPoint c = m_redoCheckPoints.pop();
-		JournallingObject *jo = m_joIDs[c.joID];
+		jo_id_t id;
+		const QByteArray state = popCheckPoint( m_redoCheckPoints, id );
+		JournallingObject *jo = m_joIDs.value( id );
 
 		if( jo )
 		{
-			DataFile curState( DataFile::Type::JournalData );
-			jo->saveState( curState, curState.content() );
-			m_undoCheckPoints.push( CheckPoint( c.joID, curState ) );
+			pushCheckPoint( m_undoCheckPoints, id, saveJournalState( jo ) );
 
 			bool prev = isJournalling();
 			setJournalling( false );
-			jo->restoreState( c.data.content().firstChildElement() );
+			restoreJournalState( jo, state );
 			setJournalling( prev );
 			Engine::getSong()->setModified();
 			break;
@@ -99,12 +166,12 @@ void ProjectJournal::redo()
 
 bool ProjectJournal::canUndo() const
 {
-	return !m_undoCheckPoints.isEmpty();
+	return !m_undoCheckPoints.checkPoints.empty();
 }
 
 bool ProjectJournal::canRedo() const
 {
-	return !m_redoCheckPoints.isEmpty();
+	return !m_redoCheckPoints.checkPoints.empty();
 }
 
 
@@ -113,17 +180,103 @@ void ProjectJournal::addJournalCheckPoint( JournallingObject *jo )
 {
 	if( isJournalling() )
 	{
-		m_redoCheckPoints.clear();
+		m_redoCheckPoints = CheckPointStack();
+
+		pushCheckPoint( m_undoCheckPoints, jo->id(), saveJournalState( jo ) );
+		trimJournal();
+	}
+}
+
 
-		DataFile dataFile( DataFile::Type::JournalData );
-		jo->saveState( dataFile, dataFile.content() );
 
-		m_undoCheckPoints.push( CheckPoint( jo->id(), dataFile ) );
-		if( m_undoCheckPoints.size() > MAX_UNDO_STATES )
+
+void ProjectJournal::pushCheckPoint( CheckPointStack & stack, jo_id_t id,
+							const QByteArray & state )
+{
+	const std::size_t previous = stack.latest.value( id, NoCheckPoint );
+
+	// the previous checkpoint of the object now only needs to store the
+	// difference to the new one
+	if( previous != NoCheckPoint )
+	{
+		CheckPoint & p = stack.checkPoints[previous - stack.dropped];
+		if( !p.isDelta )
 		{
-			m_undoCheckPoints.remove( 0, m_undoCheckPoints.size() - MAX_UNDO_STATES );
+			QByteArray delta = encodeDelta( state, p.data );
+			if( delta.size() < p.data.size() )
+			{
+				stack.size -= p.data.size() - delta.size();
+				p.data = std::move( delta );
+				p.isDelta = true;
+			}
 		}
 	}
+
+	stack.latest[id] = stack.dropped + stack.checkPoints.size();
+	stack.checkPoints.push_back( CheckPoint{ id, state, false, previous } );
+	stack.size += state.size();
+}
+
+
+
+
+QByteArray ProjectJournal::popCheckPoint( CheckPointStack & stack, jo_id_t & id )
+{
+	CheckPoint c = std::move( stack.checkPoints.back() );
+	stack.checkPoints.pop_back();
+	stack.size -= c.data.size();
+	id = c.joID;
+
+	// the previous checkpoint of the object is the most recent one now
+	if( c.previous != NoCheckPoint && c.previous >= stack.dropped )
+	{
+		stack.latest[id] = c.previous;
+		CheckPoint & p = stack.checkPoints[c.previous - stack.dropped];
+		if( p.isDelta )
+		{
+			stack.size -= p.data.size();
+			p.data = applyDelta( c.data, p.data );
+			p.isDelta = false;
+			stack.size += p.data.size();
+		}
+	}
+	else
+	{
+		stack.latest.remove( id );
+	}
+
+	return c.data;
+}
+
+
+
+
+void ProjectJournal::dropOldestCheckPoint( CheckPointStack & stack )
+{
+	// deltas only refer to newer checkpoints, so the oldest one can be
+	// dropped without touching the others
+	const CheckPoint & c = stack.checkPoints.front();
+	const auto latest = stack.latest.find( c.joID );
+	if( latest != stack.latest.end() && latest.value() == stack.dropped )
+	{
+		stack.latest.erase( latest );
+	}
+	stack.size -= c.data.size();
+	stack.checkPoints.pop_front();
+	++stack.dropped;
+}
+
+
+
+
+void ProjectJournal::trimJournal()
+{
+	// keep at least one step
+	while( m_undoCheckPoints.size + m_redoCheckPoints.size > m_memoryBudget &&
+		m_undoCheckPoints.checkPoints.size() > 1 )
+	{
+		dropOldestCheckPoint( m_undoCheckPoints );
+	}
 }
 
 
@@ -172,8 +325,8 @@ jo_id_t ProjectJournal::idFromSave( jo_id_t id )
 
 void ProjectJournal::clearJournal()
 {
-	m_undoCheckPoints.clear();
-	m_redoCheckPoints.clear();
+	m_undoCheckPoints = CheckPointStack();
+	m_redoCheckPoints = CheckPointStack();
 
 	for( JoIdMap::Iterator it = m_joIDs.begin(); it != m_joIDs.end(); )
 	{
@@ -85,24 +85,60 @@ ProjectRenderer::ProjectRenderer( const AudioEngine::qualitySettings & qualitySe
 	QThread( Engine::audioEngine() ),
 	m_fileDev( nullptr ),
 	m_qualitySettings( qualitySettings ),
+	m_outputSettings( outputSettings ),
 	m_progress( 0 ),
-	m_abort( false )
+	m_abort( false ),
+	m_deterministic( false )
 {
-	AudioFileDeviceInstantiaton audioEncoderFactory = fileEncodeDevices[static_cast<std::size_t>(exportFileFormat)].m_getDevInst;
+	m_fileDev = createFileDevice( exportFileFormat, outputFilename );
+}
+
+
+
 
-	if (audioEncoderFactory)
+bool ProjectRenderer::addOutput( ExportFileFormat fileFormat, const QString & outputFilename )
+{
+	auto output = std::unique_ptr<AudioFileDevice>( createFileDevice( fileFormat, outputFilename ) );
+	if( !isReady() || !output )
 	{
-		bool successful = false;
+		return false;
+	}
 
-		m_fileDev = audioEncoderFactory(
-					outputFilename, outputSettings, DEFAULT_CHANNELS,
-					Engine::audioEngine(), successful );
-		if( !successful )
-		{
-			delete m_fileDev;
-			m_fileDev = nullptr;
-		}
+	const QString file = output->outputFile();
+	if( !m_fileDev->addOutput( std::move( output ) ) )
+	{
+		qWarning( "Can't export %s along with %s, they need different sample rates",
+			qUtf8Printable( file ), qUtf8Printable( m_fileDev->outputFile() ) );
+		QFile::remove( file );
+		return false;
+	}
+	return true;
+}
+
+
+
+
+AudioFileDevice * ProjectRenderer::createFileDevice( ExportFileFormat fileFormat,
+					const QString & outputFilename ) const
+{
+	AudioFileDeviceInstantiaton audioEncoderFactory = fileEncodeDevices[static_cast<std::size_t>(fileFormat)].m_getDevInst;
+
+	if (!audioEncoderFactory)
+	{
+		return nullptr;
+	}
+
+	bool successful = false;
+
+	AudioFileDevice * fileDev = audioEncoderFactory(
+				outputFilename, m_outputSettings, DEFAULT_CHANNELS,
+				Engine::audioEngine(), successful );
+	if( !successful )
+	{
+		delete fileDev;
+		return nullptr;
 	}
+	return fileDev;
 }
 
 
@@ -174,6 +210,11 @@ void ProjectRenderer::run()
 	PerfLogTimer perfLog("Project Render");
 
 	Engine::getSong()->startExport();
+	if( m_deterministic )
+	{
+		Engine::audioEngine()->setDeterministic( true );
+		m_fileDev->setAudioHashing( true );
+	}
 	// Skip first empty buffer.
 	Engine::audioEngine()->nextBuffer();
 
@@ -198,14 +239,28 @@ void ProjectRenderer::run()
 	Engine::audioEngine()->stopProcessing();
 
 	Engine::getSong()->stopExport();
+	// the audio is hashed by the encoder threads, and the files are only
+	// complete once they're done
+	m_fileDev->finishEncoding();
+	if( m_deterministic )
+	{
+		Engine::audioEngine()->setDeterministic( false );
+		m_outputHash = m_fileDev->audioHash();
+	}
 
 	perfLog.end();
 
-	// If the user aborted export-process, the file has to be deleted.
-	const QString f = m_fileDev->outputFile();
+	// If the user aborted export-process, the files have to be deleted.
 	if( m_abort )
 	{
-		QFile( f ).remove();
+		for( const QString & f : m_fileDev->outputFiles() )
+		{
+			QFile( f ).remove();
+		}
+	}
+	else
+	{
+		m_outputFiles = m_fileDev->outputFiles();
 	}
 }
 
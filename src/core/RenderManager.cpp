@@ -54,6 +54,16 @@ RenderManager::~RenderManager()
 	Engine::audioEngine()->changeQuality( m_oldQualitySettings );
 }
 
+void RenderManager::addOutputFormat(ProjectRenderer::ExportFileFormat fmt)
+{
+	m_additionalFormats.push_back(fmt);
+}
+
+void RenderManager::setDeterministic(bool deterministic)
+{
+	m_deterministic = deterministic;
+}
+
 void RenderManager::abortProcessing()
 {
 	if ( m_activeRenderer ) {
@@ -67,6 +77,11 @@ void RenderManager::abortProcessing()
 // Called to render each new track when rendering tracks individually.
 void RenderManager::renderNextTrack()
 {
+	if (m_activeRenderer && m_activeRenderer->isReady())
+	{
+		m_outputHashes.insert(m_activeOutputPath, m_activeRenderer->outputHash());
+		m_outputFiles << m_activeRenderer->outputFiles();
+	}
 	m_activeRenderer.reset();
 
 	if (m_tracksToRender.empty())
@@ -145,9 +160,22 @@ void RenderManager::render(QString outputPath)
 			m_outputSettings,
 			m_format,
 			outputPath);
+	m_activeOutputPath = outputPath;
+	m_activeRenderer->setDeterministic(m_deterministic);
 
 	if( m_activeRenderer->isReady() )
 	{
+		// the other formats are written next to the first one
+		const QString extension = ProjectRenderer::getFileExtensionFromFormat( m_format );
+		const QString basePath = outputPath.endsWith( extension, Qt::CaseInsensitive )
+			? outputPath.left( outputPath.length() - extension.length() )
+			: outputPath;
+		for (const auto fmt : m_additionalFormats)
+		{
+			m_activeRenderer->addOutput( fmt,
+				basePath + ProjectRenderer::getFileExtensionFromFormat( fmt ) );
+		}
+
 		// pass progress signals through
 		connect( m_activeRenderer.get(), SIGNAL(progressChanged(int)),
 				this, SIGNAL(progressChanged(int)));
@@ -0,0 +1,295 @@
+/*
+ * RenderServer.cpp - renders projects sent as JSON lines on stdin
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "RenderServer.h"
+
+#include <cstdio>
+#include <vector>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTextStream>
+
+#include "Engine.h"
+#include "RenderManager.h"
+#include "Song.h"
+
+
+namespace lmms
+{
+
+
+RenderServer::RenderServer(const AudioEngine::qualitySettings& qualitySettings,
+		const OutputSettings& outputSettings, Defaults defaults, QObject* parent) :
+	QObject(parent),
+	m_qualitySettings(qualitySettings),
+	m_outputSettings(outputSettings),
+	m_defaults(std::move(defaults))
+{
+}
+
+
+
+
+void RenderServer::run()
+{
+	QTextStream in(stdin);
+	QString line;
+	while (in.readLineInto(&line))
+	{
+		if (line.trimmed().isEmpty()) { continue; }
+
+		QJsonParseError error;
+		const QJsonDocument doc = QJsonDocument::fromJson(line.toUtf8(), &error);
+		if (!doc.isObject())
+		{
+			replyError(QJsonObject{}, error.error != QJsonParseError::NoError
+				? error.errorString() : QString("A job must be a JSON object"));
+			continue;
+		}
+
+		const QJsonObject job = doc.object();
+		if (job.value("command").toString() == "quit") { break; }
+
+		renderJob(job);
+	}
+
+	emit finished();
+}
+
+
+
+
+void RenderServer::renderJob(const QJsonObject& job)
+{
+	using Interpolation = AudioEngine::qualitySettings::Interpolation;
+	using Oversampling = AudioEngine::qualitySettings::Oversampling;
+
+	const QString project = job.value("project").toString();
+	if (project.isEmpty())
+	{
+		replyError(job, "No project given");
+		return;
+	}
+
+	// the same checks as for the command line options
+	std::vector<ProjectRenderer::ExportFileFormat> formats;
+	for (const QString& ext : job.value("format").toString().split(','))
+	{
+		if (ext.trimmed().isEmpty()) { continue; }
+
+		const QString extension = "." + ext.trimmed();
+		const auto format = ProjectRenderer::getFileFormatFromExtension(extension);
+		if (ProjectRenderer::getFileExtensionFromFormat(format) != extension
+			|| !ProjectRenderer::fileEncodeDevices[static_cast<std::size_t>(format)].isAvailable())
+		{
+			replyError(job, QString("Invalid output format %1").arg(ext));
+			return;
+		}
+		formats.push_back(format);
+	}
+	if (formats.empty()) { formats = m_defaults.formats; }
+
+	AudioEngine::qualitySettings qs = m_qualitySettings;
+	OutputSettings os = m_outputSettings;
+
+	if (job.contains("samplerate"))
+	{
+		const int sr = job.value("samplerate").toInt();
+		if (sr < 44100 || sr > 192000)
+		{
+			replyError(job, QString("Invalid samplerate %1").arg(sr));
+			return;
+		}
+		os.setSampleRate(sr);
+	}
+	if (job.contains("bitrate"))
+	{
+		const int br = job.value("bitrate").toInt();
+		if (br < 64 || br > 384)
+		{
+			replyError(job, QString("Invalid bitrate %1").arg(br));
+			return;
+		}
+		OutputSettings::BitRateSettings bitRateSettings = os.getBitRateSettings();
+		bitRateSettings.setBitRate(br);
+		os.setBitRateSettings(bitRateSettings);
+	}
+	if (job.value("float").toBool())
+	{
+		os.setBitDepth(OutputSettings::BitDepth::Depth32Bit);
+	}
+	if (job.contains("mode"))
+	{
+		const QString mode = job.value("mode").toString();
+		if (mode == "s") { os.setStereoMode(OutputSettings::StereoMode::Stereo); }
+		else if (mode == "j") { os.setStereoMode(OutputSettings::StereoMode::JointStereo); }
+		else if (mode == "m") { os.setStereoMode(OutputSettings::StereoMode::Mono); }
+		else
+		{
+			replyError(job, QString("Invalid stereo mode %1").arg(mode));
+			return;
+		}
+	}
+	if (job.contains("interpolation"))
+	{
+		const QString ip = job.value("interpolation").toString();
+		if (ip == "linear") { qs.interpolation = Interpolation::Linear; }
+		else if (ip == "sincfastest") { qs.interpolation = Interpolation::SincFastest; }
+		else if (ip == "sincmedium") { qs.interpolation = Interpolation::SincMedium; }
+		else if (ip == "sincbest") { qs.interpolation = Interpolation::SincBest; }
+		else
+		{
+			replyError(job, QString("Invalid interpolation method %1").arg(ip));
+			return;
+		}
+	}
+	if (job.contains("oversampling"))
+	{
+		switch (job.value("oversampling").toInt())
+		{
+		case 1: qs.oversampling = Oversampling::None; break;
+		case 2: qs.oversampling = Oversampling::X2; break;
+		case 4: qs.oversampling = Oversampling::X4; break;
+		case 8: qs.oversampling = Oversampling::X8; break;
+		default:
+			replyError(job, QString("Invalid oversampling %1").arg(job.value("oversampling").toInt()));
+			return;
+		}
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+
+	Song* song = Engine::getSong();
+	// a project which can't be loaded is replaced by a new one instead of
+	// leaving the previous job's project loaded, which clears the file name
+	song->setLoadOnLaunch(true);
+	song->loadProject(project);
+	if (song->projectFileName().isEmpty())
+	{
+		replyError(job, QString("The project %1 couldn't be loaded").arg(project));
+		return;
+	}
+	if (song->isEmpty())
+	{
+		replyError(job, QString("The project %1 is empty or couldn't be loaded").arg(project));
+		return;
+	}
+	const qint64 loadTime = timer.restart();
+
+	song->setExportLoop(job.value("loop").toBool(m_defaults.loop));
+	song->setRenderBetweenMarkers(false);
+	song->setLoopRenderCount(job.value("loopcount").toInt(1));
+
+	// like for "render", the output is a file for a project and a
+	// directory for its tracks
+	const bool renderTracks = job.value("tracks").toBool();
+	const QFileInfo outputInfo(job.value("output").toString(project));
+	const QString baseName = outputInfo.absolutePath() + "/" + outputInfo.completeBaseName();
+	const QString output = renderTracks
+		? outputInfo.absoluteFilePath()
+		: baseName + ProjectRenderer::getFileExtensionFromFormat(formats.front());
+	const bool deterministic = job.value("deterministic").toBool(m_defaults.deterministic);
+	QJsonObject hashes;
+	QStringList writtenFiles;
+
+	{
+		// the files are complete once the render manager has restored the
+		// previous audio device
+		RenderManager renderManager(qs, os, formats.front(), output);
+		for (std::size_t i = 1; i < formats.size(); ++i)
+		{
+			renderManager.addOutputFormat(formats[i]);
+		}
+		renderManager.setDeterministic(deterministic);
+
+		QEventLoop loop;
+		bool done = false;
+		connect(&renderManager, &RenderManager::progressChanged, this, [&](int progress)
+		{
+			reply(job, "progress", QJsonObject{{"progress", progress}});
+		});
+		connect(&renderManager, &RenderManager::finished, &loop, [&]
+		{
+			done = true;
+			loop.quit();
+		});
+
+		if (renderTracks) { renderManager.renderTracks(); }
+		else { renderManager.renderProject(); }
+
+		if (!done) { loop.exec(); }
+
+		const auto& outputHashes = renderManager.outputHashes();
+		for (auto it = outputHashes.begin(); it != outputHashes.end(); ++it)
+		{
+			hashes.insert(it.key(), QString::fromLatin1(it.value()));
+		}
+		writtenFiles = renderManager.outputFiles();
+	}
+
+	// only files whose encoders finished count, not leftovers of earlier jobs
+	if (writtenFiles.isEmpty())
+	{
+		replyError(job, QString("Couldn't write %1").arg(output));
+		return;
+	}
+
+	QJsonArray files;
+	if (renderTracks) { files.append(output); }
+	else { files = QJsonArray::fromStringList(writtenFiles); }
+
+	QJsonObject result{
+		{"files", files},
+		{"loadms", static_cast<double>(loadTime)},
+		{"renderms", static_cast<double>(timer.elapsed())}
+	};
+	if (deterministic) { result.insert("hashes", hashes); }
+	reply(job, "done", result);
+}
+
+
+
+
+void RenderServer::reply(const QJsonObject& job, const QString& event, QJsonObject values)
+{
+	if (job.contains("id")) { values.insert("id", job.value("id")); }
+	values.insert("event", event);
+
+	const QByteArray line = QJsonDocument(values).toJson(QJsonDocument::Compact) + '\n';
+	std::fwrite(line.constData(), 1, line.size(), stdout);
+	std::fflush(stdout);
+}
+
+
+
+
+void RenderServer::replyError(const QJsonObject& job, const QString& message)
+{
+	reply(job, "error", QJsonObject{{"message", message}});
+}
+
+
+} // namespace lmms
@@ -26,11 +26,17 @@
 #include "Oscillator.h"
 
 #include <algorithm>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
 
 #include <QFile>
 #include <QFileInfo>
 #include <QMessageBox>
 #include <QPainter>
+#include <QRunnable>
+#include <QThreadPool>
 
 
 #include <sndfile.h>
@@ -64,8 +70,42 @@
 namespace lmms
 {
 
+namespace
+{
+
+// File size and sample length limits
+constexpr int FileSizeMax = 300; // MB
+constexpr int SampleLengthMax = 90; // Minutes
+
+struct PrefetchedFile
+{
+	sampleFrame* data = nullptr;
+	f_cnt_t frames = 0;
+	sample_rate_t samplerate = 0;
+};
+
+class PrefetchJob : public QRunnable
+{
+public:
+	PrefetchJob(std::function<void()> job) : m_job(std::move(job)) {}
+	void run() override { m_job(); }
+
+private:
+	std::function<void()> m_job;
+};
+
+struct PrefetchEntry
+{
+	std::shared_future<PrefetchedFile> result;
+	int uses = 0; //!< number of references which haven't taken the data yet
+};
+
+std::mutex s_prefetchMutex;
+std::map<QString, PrefetchEntry> s_prefetched;
+
+} // namespace
+
 SampleBuffer::SampleBuffer() :
-	m_userAntiAliasWaveTable(nullptr),
 	m_audioFile(""),
 	m_origData(nullptr),
 	m_origFrames(0),
@@ -196,6 +236,9 @@ void swap(SampleBuffer& first, SampleBuffer& second) noexcept
 	swap(first.m_frequency, second.m_frequency);
 	swap(first.m_reversed, second.m_reversed);
 	swap(first.m_sampleRate, second.m_sampleRate);
+	// the wave tables belong to the data
+	first.m_userAntiAliasWaveTable.swap(second.m_userAntiAliasWaveTable);
+	second.m_hasUserAntiAliasWaveTable = first.m_hasUserAntiAliasWaveTable.exchange(second.m_hasUserAntiAliasWaveTable);
 
 	// Unlock again
 	first.m_varLock.unlock();
@@ -235,18 +278,6 @@ sample_rate_t SampleBuffer::audioEngineSampleRate()
 
 void SampleBuffer::update(bool keepSettings)
 {
-	const bool lock = (m_data != nullptr);
-	if (lock)
-	{
-		Engine::audioEngine()->requestChangeInModel();
-		m_varLock.lockForWrite();
-		MM_FREE(m_data);
-	}
-
-	// File size and sample length limits
-	const int fileSizeMax = 300; // MB
-	const int sampleLengthMax = 90; // Minutes
-
 	enum class FileLoadError
 	{
 		None,
@@ -256,34 +287,32 @@ void SampleBuffer::update(bool keepSettings)
 	};
 	FileLoadError fileLoadError = FileLoadError::None;
 
+	// The new data is decoded and resampled before taking any lock, the
+	// audio thread only has to wait while the old data is swapped out
+	sampleFrame * data = nullptr;
+	f_cnt_t frames = 0;
+	bool resampled = false;
+	bool resetSettings = !keepSettings;
+
 	if (m_audioFile.isEmpty() && m_origData != nullptr && m_origFrames > 0)
 	{
 		// TODO: reverse- and amplification-property is not covered
 		// by following code...
-		m_data = MM_ALLOC<sampleFrame>( m_origFrames);
-		memcpy(m_data, m_origData, m_origFrames * BYTES_PER_FRAME);
-		if (keepSettings == false)
-		{
-			m_frames = m_origFrames;
-			m_loopStartFrame = m_startFrame = 0;
-			m_loopEndFrame = m_endFrame = m_frames;
-		}
+		data = MM_ALLOC<sampleFrame>( m_origFrames);
+		memcpy(data, m_origData, m_origFrames * BYTES_PER_FRAME);
+		frames = m_origFrames;
 	}
 	else if (!m_audioFile.isEmpty())
 	{
 		QString file = PathUtil::toAbsolute(m_audioFile);
-		int_sample_t * buf = nullptr;
-		sample_t * fbuf = nullptr;
-		ch_cnt_t channels = DEFAULT_CHANNELS;
 		sample_rate_t samplerate = audioEngineSampleRate();
-		m_frames = 0;
 
 		const QFileInfo fileInfo(file);
 		if (!fileInfo.isReadable())
 		{
 			fileLoadError = FileLoadError::ReadPermissionDenied;
 		}
-		else if (fileInfo.size() > fileSizeMax * 1024 * 1024)
+		else if (fileInfo.size() > FileSizeMax * 1024 * 1024)
 		{
 			fileLoadError = FileLoadError::TooLarge;
 		}
@@ -297,9 +326,9 @@ void SampleBuffer::update(bool keepSettings)
 
 			if (f.open(QIODevice::ReadOnly) && (sndFile = sf_open_fd(f.handle(), SFM_READ, &sfInfo, false)))
 			{
-				f_cnt_t frames = sfInfo.frames;
+				f_cnt_t fileFrames = sfInfo.frames;
 				int rate = sfInfo.samplerate;
-				if (frames / rate > sampleLengthMax * 60)
+				if (fileFrames / rate > SampleLengthMax * 60)
 				{
 					fileLoadError = FileLoadError::TooLarge;
 				}
@@ -310,60 +339,86 @@ void SampleBuffer::update(bool keepSettings)
 
 		if (fileLoadError == FileLoadError::None)
 		{
-#ifdef LMMS_HAVE_OGGVORBIS
-			// workaround for a bug in libsndfile or our libsndfile decoder
-			// causing some OGG files to be distorted -> try with OGG Vorbis
-			// decoder first if filename extension matches "ogg"
-			if (m_frames == 0 && fileInfo.suffix() == "ogg")
+			if (takePrefetched(file, data, frames, samplerate))
 			{
-				m_frames = decodeSampleOGGVorbis(file, buf, channels, samplerate);
-			}
-#endif
-			if (m_frames == 0)
-			{
-				m_frames = decodeSampleSF(file, fbuf, channels, samplerate);
-			}
-#ifdef LMMS_HAVE_OGGVORBIS
-			if (m_frames == 0)
-			{
-				m_frames = decodeSampleOGGVorbis(file, buf, channels, samplerate);
+				// prefetched data is decoded without any settings applied
+				if (m_reversed && data != nullptr)
+				{
+					std::reverse(data, data + frames);
+				}
 			}
-#endif
-			if (m_frames == 0)
+			else
 			{
-				m_frames = decodeSampleDS(file, buf, channels, samplerate);
+				frames = decodeFile(file, data, samplerate, m_reversed);
 			}
 
-			if (m_frames == 0)
+			if (frames == 0)
 			{
 				fileLoadError = FileLoadError::Invalid;
 			}
 		}
 
-		if (m_frames == 0 || fileLoadError != FileLoadError::None)  // if still no frames, bail
+		if (frames == 0 || fileLoadError != FileLoadError::None)  // if still no frames, bail
 		{
-			// sample couldn't be decoded, create buffer containing
-			// one sample-frame
-			m_data = MM_ALLOC<sampleFrame>( 1);
-			memset(m_data, 0, sizeof(*m_data));
-			m_frames = 1;
-			m_loopStartFrame = m_startFrame = 0;
-			m_loopEndFrame = m_endFrame = 1;
+			MM_FREE(data);
+			data = nullptr;
+			frames = 0;
 		}
-		else // otherwise normalize sample rate
+		else if (samplerate != audioEngineSampleRate())
 		{
-			normalizeSampleRate(samplerate, keepSettings);
+			// do samplerate-conversion to our default-samplerate
+			f_cnt_t resampledFrames = 0;
+			sampleFrame * resampledData = resampleFrames(data, frames, samplerate,
+				audioEngineSampleRate(), resampledFrames);
+			MM_FREE(data);
+			data = resampledData;
+			frames = resampledFrames;
+			resampled = true;
 		}
 	}
-	else
+
+	if (data == nullptr)
 	{
-		// neither an audio-file nor a buffer to copy from, so create
-		// buffer containing one sample-frame
-		m_data = MM_ALLOC<sampleFrame>( 1);
-		memset(m_data, 0, sizeof(*m_data));
-		m_frames = 1;
+		// sample couldn't be decoded or there's neither an audio-file nor
+		// a buffer to copy from, so create buffer containing one sample-frame
+		data = MM_ALLOC<sampleFrame>( 1);
+		memset(data, 0, sizeof(*data));
+		frames = 1;
+		resetSettings = true;
+	}
+
+	const bool lock = (m_data != nullptr);
+	if (lock)
+	{
+		Engine::audioEngine()->requestChangeInModel();
+		m_varLock.lockForWrite();
+	}
+
+	sampleFrame * oldData = m_data;
+	m_data = data;
+	m_frames = frames;
+
+	const sample_rate_t oldRate = m_sampleRate;
+	if (resampled)
+	{
+		m_sampleRate = audioEngineSampleRate();
+	}
+
+	if (resetSettings)
+	{
+		// update frame-variables
 		m_loopStartFrame = m_startFrame = 0;
-		m_loopEndFrame = m_endFrame = 1;
+		m_loopEndFrame = m_endFrame = m_frames;
+	}
+	else if (!m_audioFile.isEmpty() && oldRate != audioEngineSampleRate())
+	{
+		auto oldRateToNewRateRatio = static_cast<float>(audioEngineSampleRate()) / oldRate;
+
+		m_startFrame = std::clamp(f_cnt_t(m_startFrame * oldRateToNewRateRatio), 0, m_frames);
+		m_endFrame = std::clamp(f_cnt_t(m_endFrame * oldRateToNewRateRatio), m_startFrame, m_frames);
+		m_loopStartFrame = std::clamp(f_cnt_t(m_loopStartFrame * oldRateToNewRateRatio), 0, m_frames);
+		m_loopEndFrame = std::clamp(f_cnt_t(m_loopEndFrame * oldRateToNewRateRatio), m_loopStartFrame, m_frames);
+		m_sampleRate = audioEngineSampleRate();
 	}
 
 	if (lock)
@@ -372,14 +427,14 @@ void SampleBuffer::update(bool keepSettings)
 		Engine::audioEngine()->doneChangeInModel();
 	}
 
+	MM_FREE(oldData);
+
 	emit sampleUpdated();
 
-	// allocate space for anti-aliased wave table
-	if (m_userAntiAliasWaveTable == nullptr)
+	if (m_hasUserAntiAliasWaveTable.load(std::memory_order_acquire))
 	{
-		m_userAntiAliasWaveTable = std::make_unique<OscillatorConstants::waveform_t>();
+		Oscillator::generateAntiAliasUserWaveTable(this, m_userAntiAliasWaveTable.data());
 	}
-	Oscillator::generateAntiAliasUserWaveTable(this);
 
 	if (fileLoadError != FileLoadError::None)
 	{
@@ -399,7 +454,7 @@ void SampleBuffer::update(bool keepSettings)
 			case FileLoadError::TooLarge:
 				message = tr("Audio files are limited to %1 MB "
 					"in size and %2 minutes of playing time"
-					).arg(fileSizeMax).arg(sampleLengthMax);
+					).arg(FileSizeMax).arg(SampleLengthMax);
 				break;
 
 			case FileLoadError::Invalid:
@@ -419,24 +474,41 @@ void SampleBuffer::update(bool keepSettings)
 }
 
 
+
+
+void SampleBuffer::enableUserAntiAliasWaveTable()
+{
+	if (m_hasUserAntiAliasWaveTable.load(std::memory_order_acquire)) { return; }
+
+	m_userAntiAliasWaveTable.resize(Oscillator::waveformLayout().size);
+	Oscillator::generateAntiAliasUserWaveTable(this, m_userAntiAliasWaveTable.data());
+	m_hasUserAntiAliasWaveTable.store(true, std::memory_order_release);
+}
+
+
+
+
+
 void SampleBuffer::convertIntToFloat(
 	int_sample_t * & ibuf,
 	f_cnt_t frames,
-	int channels
+	int channels,
+	sampleFrame * & data,
+	bool reversed
 )
 {
 	// following code transforms int-samples into float-samples and does amplifying & reversing
 	const float fac = 1 / OUTPUT_SAMPLE_MULTIPLIER;
-	m_data = MM_ALLOC<sampleFrame>( frames);
+	data = MM_ALLOC<sampleFrame>( frames);
 	const int ch = (channels > 1) ? 1 : 0;
 
 	// if reversing is on, we also reverse when scaling
-	bool isReversed = m_reversed;
+	bool isReversed = reversed;
 	int idx = isReversed ? (frames - 1) * channels : 0;
 	for (f_cnt_t frame = 0; frame < frames; ++frame)
 	{
-		m_data[frame][0] = ibuf[idx+0] * fac;
-		m_data[frame][1] = ibuf[idx+ch] * fac;
+		data[frame][0] = ibuf[idx+0] * fac;
+		data[frame][1] = ibuf[idx+ch] * fac;
 		idx += isReversed ? -channels : channels;
 	}
 
@@ -446,20 +518,22 @@ void SampleBuffer::convertIntToFloat(
 void SampleBuffer::directFloatWrite(
 	sample_t * & fbuf,
 	f_cnt_t frames,
-	int channels
+	int channels,
+	sampleFrame * & data,
+	bool reversed
 )
 {
 
-	m_data = MM_ALLOC<sampleFrame>( frames);
+	data = MM_ALLOC<sampleFrame>( frames);
 	const int ch = (channels > 1) ? 1 : 0;
 
 	// if reversing is on, we also reverse when scaling
-	bool isReversed = m_reversed;
+	bool isReversed = reversed;
 	int idx = isReversed ? (frames - 1) * channels : 0;
 	for (f_cnt_t frame = 0; frame < frames; ++frame)
 	{
-		m_data[frame][0] = fbuf[idx+0];
-		m_data[frame][1] = fbuf[idx+ch];
+		data[frame][0] = fbuf[idx+0];
+		data[frame][1] = fbuf[idx+ch];
 		idx += isReversed ? -channels : channels;
 	}
 
@@ -467,38 +541,43 @@ void SampleBuffer::directFloatWrite(
 }
 
 
-void SampleBuffer::normalizeSampleRate(const sample_rate_t srcSR, bool keepSettings)
+f_cnt_t SampleBuffer::decodeFile(
+	const QString & fileName,
+	sampleFrame * & data,
+	sample_rate_t & samplerate,
+	bool reversed
+)
 {
-	const sample_rate_t oldRate = m_sampleRate;
-	// do samplerate-conversion to our default-samplerate
-	if (srcSR != audioEngineSampleRate())
-	{
-		SampleBuffer * resampled = resample(srcSR, audioEngineSampleRate());
+	int_sample_t * buf = nullptr;
+	sample_t * fbuf = nullptr;
+	ch_cnt_t channels = DEFAULT_CHANNELS;
+	f_cnt_t frames = 0;
 
-		m_sampleRate = audioEngineSampleRate();
-		MM_FREE(m_data);
-		m_frames = resampled->frames();
-		m_data = MM_ALLOC<sampleFrame>( m_frames);
-		memcpy(m_data, resampled->data(), m_frames * sizeof(sampleFrame));
-		delete resampled;
+#ifdef LMMS_HAVE_OGGVORBIS
+	// workaround for a bug in libsndfile or our libsndfile decoder
+	// causing some OGG files to be distorted -> try with OGG Vorbis
+	// decoder first if filename extension matches "ogg"
+	if (QFileInfo(fileName).suffix() == "ogg")
+	{
+		frames = decodeSampleOGGVorbis(fileName, buf, channels, samplerate, data, reversed);
 	}
-
-	if (keepSettings == false)
+#endif
+	if (frames == 0)
 	{
-		// update frame-variables
-		m_loopStartFrame = m_startFrame = 0;
-		m_loopEndFrame = m_endFrame = m_frames;
+		frames = decodeSampleSF(fileName, fbuf, channels, samplerate, data, reversed);
 	}
-	else if (oldRate != audioEngineSampleRate())
+#ifdef LMMS_HAVE_OGGVORBIS
+	if (frames == 0)
 	{
-		auto oldRateToNewRateRatio = static_cast<float>(audioEngineSampleRate()) / oldRate;
-
-		m_startFrame = std::clamp(f_cnt_t(m_startFrame * oldRateToNewRateRatio), 0, m_frames);
-		m_endFrame = std::clamp(f_cnt_t(m_endFrame * oldRateToNewRateRatio), m_startFrame, m_frames);
-		m_loopStartFrame = std::clamp(f_cnt_t(m_loopStartFrame * oldRateToNewRateRatio), 0, m_frames);
-		m_loopEndFrame = std::clamp(f_cnt_t(m_loopEndFrame * oldRateToNewRateRatio), m_loopStartFrame, m_frames);
-		m_sampleRate = audioEngineSampleRate();
+		frames = decodeSampleOGGVorbis(fileName, buf, channels, samplerate, data, reversed);
 	}
+#endif
+	if (frames == 0)
+	{
+		frames = decodeSampleDS(fileName, buf, channels, samplerate, data, reversed);
+	}
+
+	return frames;
 }
 
 
@@ -508,7 +587,9 @@ f_cnt_t SampleBuffer::decodeSampleSF(
 	QString fileName,
 	sample_t * & buf,
 	ch_cnt_t & channels,
-	sample_rate_t & samplerate
+	sample_rate_t & samplerate,
+	sampleFrame * & data,
+	bool reversed
 )
 {
 	SNDFILE * sndFile;
@@ -552,7 +633,7 @@ f_cnt_t SampleBuffer::decodeSampleSF(
 
 	if (frames > 0 && buf != nullptr)
 	{
-		directFloatWrite(buf, frames, channels);
+		directFloatWrite(buf, frames, channels, data, reversed);
 	}
 
 	return frames;
@@ -616,7 +697,9 @@ f_cnt_t SampleBuffer::decodeSampleOGGVorbis(
 	QString fileName,
 	int_sample_t * & buf,
 	ch_cnt_t & channels,
-	sample_rate_t & samplerate
+	sample_rate_t & samplerate,
+	sampleFrame * & data,
+	bool reversed
 )
 {
 	static ov_callbacks callbacks =
@@ -704,7 +787,7 @@ f_cnt_t SampleBuffer::decodeSampleOGGVorbis(
 	// if buffer isn't empty, convert it to float and write it down
 	if (frames > 0 && buf != nullptr)
 	{
-		convertIntToFloat(buf, frames, channels);
+		convertIntToFloat(buf, frames, channels, data, reversed);
 	}
 
 	return frames;
@@ -718,7 +801,9 @@ f_cnt_t SampleBuffer::decodeSampleDS(
 	QString fileName,
 	int_sample_t * & buf,
 	ch_cnt_t & channels,
-	sample_rate_t & samplerate
+	sample_rate_t & samplerate,
+	sampleFrame * & data,
+	bool reversed
 )
 {
 	DrumSynth ds;
@@ -726,7 +811,7 @@ f_cnt_t SampleBuffer::decodeSampleDS(
 
 	if (frames > 0 && buf != nullptr)
 	{
-		convertIntToFloat(buf, frames, channels);
+		convertIntToFloat(buf, frames, channels, data, reversed);
 	}
 
 	return frames;
@@ -1370,11 +1455,22 @@ QString & SampleBuffer::toBase64(QString & dst) const
 
 SampleBuffer * SampleBuffer::resample(const sample_rate_t srcSR, const sample_rate_t dstSR )
 {
-	sampleFrame * data = m_data;
-	const f_cnt_t frames = m_frames;
-	const auto dstFrames = static_cast<f_cnt_t>((frames / (float)srcSR) * (float)dstSR);
-	auto dstSB = new SampleBuffer(dstFrames);
-	sampleFrame * dstBuf = dstSB->m_origData;
+	f_cnt_t dstFrames = 0;
+	sampleFrame * dstData = resampleFrames(m_data, m_frames, srcSR, dstSR, dstFrames);
+	auto dstSB = new SampleBuffer(dstData, dstFrames);
+	MM_FREE(dstData);
+	return dstSB;
+}
+
+
+
+
+sampleFrame * SampleBuffer::resampleFrames(const sampleFrame * data, const f_cnt_t frames,
+	const sample_rate_t srcSR, const sample_rate_t dstSR, f_cnt_t & dstFrames)
+{
+	dstFrames = static_cast<f_cnt_t>((frames / (float)srcSR) * (float)dstSR);
+	auto dstBuf = MM_ALLOC<sampleFrame>( dstFrames);
+	memset(dstBuf, 0, dstFrames * BYTES_PER_FRAME);
 
 	// yeah, libsamplerate, let's rock with sinc-interpolation!
 	int error;
@@ -1398,8 +1494,101 @@ SampleBuffer * SampleBuffer::resample(const sample_rate_t srcSR, const sample_ra
 	{
 		printf("Error: src_new() failed in SampleBuffer.cpp!\n");
 	}
-	dstSB->update();
-	return dstSB;
+	return dstBuf;
+}
+
+
+
+
+void SampleBuffer::prefetch(const QStringList & audioFiles)
+{
+	const auto lock = std::lock_guard{s_prefetchMutex};
+	for (const auto& audioFile : audioFiles)
+	{
+		const QString file = PathUtil::toAbsolute(audioFile);
+		if (file.isEmpty()) { continue; }
+
+		const auto it = s_prefetched.find(file);
+		if (it != s_prefetched.end())
+		{
+			++it->second.uses;
+			continue;
+		}
+
+		// don't waste time on files which will be refused anyway
+		const QFileInfo fileInfo(file);
+		if (!fileInfo.isReadable() || fileInfo.size() > FileSizeMax * 1024 * 1024) { continue; }
+
+		const sample_rate_t samplerate = audioEngineSampleRate();
+		auto task = std::make_shared<std::packaged_task<PrefetchedFile()>>([file, samplerate]
+		{
+			PrefetchedFile result;
+			result.samplerate = samplerate;
+			result.frames = decodeFile(file, result.data, result.samplerate, false);
+			return result;
+		});
+		s_prefetched.emplace(file, PrefetchEntry{task->get_future().share(), 1});
+		QThreadPool::globalInstance()->start(new PrefetchJob([task] { (*task)(); }));
+	}
+}
+
+
+
+
+void SampleBuffer::dropPrefetched()
+{
+	auto prefetched = std::map<QString, PrefetchEntry>{};
+	{
+		const auto lock = std::lock_guard{s_prefetchMutex};
+		prefetched.swap(s_prefetched);
+	}
+
+	for (const auto& entry : prefetched)
+	{
+		MM_FREE(entry.second.result.get().data);
+	}
+}
+
+
+
+
+bool SampleBuffer::takePrefetched(const QString & file, sampleFrame * & data,
+	f_cnt_t & frames, sample_rate_t & samplerate)
+{
+	std::shared_future<PrefetchedFile> future;
+	{
+		const auto lock = std::lock_guard{s_prefetchMutex};
+		const auto it = s_prefetched.find(file);
+		if (it == s_prefetched.end()) { return false; }
+		future = it->second.result;
+	}
+
+	const PrefetchedFile& result = future.get();
+
+	const auto lock = std::lock_guard{s_prefetchMutex};
+	const auto it = s_prefetched.find(file);
+	// dropped while waiting
+	if (it == s_prefetched.end()) { return false; }
+
+	frames = result.frames;
+	samplerate = result.samplerate;
+	if (--it->second.uses > 0)
+	{
+		// the file is referenced again, so hand out a copy
+		if (frames > 0)
+		{
+			data = MM_ALLOC<sampleFrame>(frames);
+			std::copy_n(result.data, frames, data);
+		}
+	}
+	else
+	{
+		// the last reference takes over the decoded data
+		if (frames > 0) { data = result.data; }
+		else { MM_FREE(result.data); }
+		s_prefetched.erase(it);
+	}
+	return true;
 }
 
 
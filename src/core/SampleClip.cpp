@@ -108,8 +108,11 @@ SampleClip::~SampleClip()
 		sampletrack->updateClips();
 	}
 	Engine::audioEngine()->requestChangeInModel();
-	sharedObject::unref( m_sampleBuffer );
+	SampleBuffer* oldBuffer = m_sampleBuffer;
+	m_sampleBuffer = nullptr;
 	Engine::audioEngine()->doneChangeInModel();
+	// freeing the sample data doesn't need to hold up the audio thread
+	sharedObject::unref( oldBuffer );
 }
 
 
@@ -133,9 +136,10 @@ const QString & SampleClip::sampleFile() const
 void SampleClip::setSampleBuffer( SampleBuffer* sb )
 {
 	Engine::audioEngine()->requestChangeInModel();
-	sharedObject::unref( m_sampleBuffer );
-	Engine::audioEngine()->doneChangeInModel();
+	SampleBuffer* oldBuffer = m_sampleBuffer;
 	m_sampleBuffer = sb;
+	Engine::audioEngine()->doneChangeInModel();
+	sharedObject::unref( oldBuffer );
 	updateLength();
 
 	emit sampleChanged();
@@ -26,10 +26,15 @@
 #include <QTextStream>
 #include <QCoreApplication>
 #include <QDebug>
+#include <QEventLoop>
 #include <QFile>
 #include <QMessageBox>
+#include <QProgressDialog>
+#include <QTimer>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 
 #include "AutomationTrack.h"
@@ -37,6 +42,7 @@
 #include "ConfigManager.h"
 #include "ControllerRackView.h"
 #include "ControllerConnection.h"
+#include "DataFile.h"
 #include "EnvelopeAndLfoParameters.h"
 #include "Mixer.h"
 #include "MixerView.h"
@@ -44,6 +50,7 @@
 #include "ExportFilter.h"
 #include "InstrumentTrack.h"
 #include "Keymap.h"
+#include "MainWindow.h"
 #include "NotePlayHandle.h"
 #include "MidiClip.h"
 #include "PatternEditor.h"
@@ -52,6 +59,7 @@
 #include "PianoRoll.h"
 #include "ProjectJournal.h"
 #include "ProjectNotes.h"
+#include "SampleBuffer.h"
 #include "Scale.h"
 #include "SongEditor.h"
 #include "TimeLineWidget.h"
@@ -64,6 +72,20 @@ namespace lmms
 tick_t TimePos::s_ticksPerBar = DefaultTicksPerBar;
 
 
+//! An autosave being built, see Song::saveProjectFileInBackground()
+struct Song::BackgroundSnapshot
+{
+	std::shared_ptr<DataFile> dataFile;
+	//! The element of the song, which the tracks are saved into
+	QDomElement songElement;
+	std::size_t nextTrack = 0;
+	//! Song::m_modifications when the snapshot was started
+	unsigned modifications = 0;
+	QString fullName;
+	bool keepBackup = false;
+};
+
+
 
 Song::Song() :
 	TrackContainer(),
@@ -88,6 +110,8 @@ Song::Song() :
 	m_paused( false ),
 	m_savingProject( false ),
 	m_loadingProject( false ),
+	m_writingProject( false ),
+	m_modifications( 0 ),
 	m_isCancelled( false ),
 	m_playMode( PlayMode::None ),
 	m_length( 0 ),
@@ -128,6 +152,7 @@ Song::Song() :
 
 Song::~Song()
 {
+	waitForBackgroundSave();
 	m_playing = false;
 	delete m_globalAutomationTrack;
 }
@@ -145,20 +170,21 @@ void Song::masterVolumeChanged()
 
 void Song::setTempo()
 {
-	Engine::audioEngine()->requestChangeInModel();
 	const auto tempo = (bpm_t)m_tempoModel.value();
-	PlayHandleList & playHandles = Engine::audioEngine()->playHandles();
-	for (const auto& playHandle : playHandles)
+	Engine::audioEngine()->postModelChange([tempo]
 	{
-		auto nph = dynamic_cast<NotePlayHandle*>(playHandle);
-		if( nph && !nph->isReleased() )
+		// changes are applied before the period is rendered, so no worker
+		// is processing the notes and they needn't be locked
+		PlayHandleList & playHandles = Engine::audioEngine()->playHandles();
+		for (const auto& playHandle : playHandles)
 		{
-			nph->lock();
-			nph->resize( tempo );
-			nph->unlock();
+			auto nph = dynamic_cast<NotePlayHandle*>(playHandle);
+			if( nph && !nph->isReleased() )
+			{
+				nph->resize( tempo );
+			}
 		}
-	}
-	Engine::audioEngine()->doneChangeInModel();
+	});
 
 	Engine::updateFramesPerTick();
 
@@ -435,6 +461,10 @@ void Song::processAutomations(const TrackList &tracklist, TimePos timeStart, fpp
 
 void Song::setModified(bool value)
 {
+	if( !m_loadingProject && value )
+	{
+		++m_modifications;
+	}
 	if( !m_loadingProject && m_modified != value)
 	{
 		m_modified = value;
@@ -854,6 +884,9 @@ void Song::clearProject()
 
 	Engine::projectJournal()->setJournalling( false );
 
+	// an autosave being built would mix the old project with the new one
+	m_backgroundSnapshot.reset();
+
 	if( m_playing )
 	{
 		stop();
@@ -1072,6 +1105,11 @@ void Song::loadProject( const QString & fileName )
 
 	clearErrors();
 
+	// decode the samples and load the instruments' files in the background
+	// while the tracks are set up
+	SampleBuffer::prefetch(dataFile.resourceFiles());
+	Plugin::prefetch(dataFile);
+
 	Engine::audioEngine()->requestChangeInModel();
 
 	// get the header information from the DOM
@@ -1191,6 +1229,8 @@ void Song::loadProject( const QString & fileName )
 	// resolve all IDs so that autoModels are automated
 	AutomationClip::resolveAllIDs();
 
+	SampleBuffer::dropPrefetched();
+	Plugin::dropPrefetched();
 
 	Engine::audioEngine()->doneChangeInModel();
 
@@ -1230,20 +1270,34 @@ void Song::loadProject( const QString & fileName )
 }
 
 
-// only save current song as filename and do nothing else
-bool Song::saveProjectFile(const QString & filename, bool withResources)
+void Song::saveProjectSnapshot(DataFile& dataFile)
 {
-	using gui::getGUI;
-
-	DataFile dataFile( DataFile::Type::SongProject );
 	m_savingProject = true;
 
+	saveSnapshotHead( dataFile );
+	saveState( dataFile, dataFile.content() );
+	saveSnapshotTail( dataFile );
+
+	m_savingProject = false;
+}
+
+
+
+
+void Song::saveSnapshotHead(DataFile& dataFile)
+{
 	m_tempoModel.saveSettings( dataFile, dataFile.head(), "bpm" );
 	m_timeSigModel.saveSettings( dataFile, dataFile.head(), "timesig" );
 	m_masterVolumeModel.saveSettings( dataFile, dataFile.head(), "mastervol" );
 	m_masterPitchModel.saveSettings( dataFile, dataFile.head(), "masterpitch" );
+}
 
-	saveState( dataFile, dataFile.content() );
+
+
+
+void Song::saveSnapshotTail(DataFile& dataFile)
+{
+	using gui::getGUI;
 
 	m_globalAutomationTrack->saveState( dataFile, dataFile.content() );
 	Engine::mixer()->saveState( dataFile, dataFile.content() );
@@ -1260,10 +1314,180 @@ bool Song::saveProjectFile(const QString & filename, bool withResources)
 
 	saveScaleStates(dataFile, dataFile.content());
 	saveKeymapStates(dataFile, dataFile.content());
+}
+
+
+
+
+// only save current song as filename and do nothing else
+bool Song::saveProjectFile(const QString & filename, bool withResources)
+{
+	using gui::getGUI;
+	using namespace std::chrono_literals;
+
+	// timers keep running while we wait for the write below, don't let
+	// them start another save meanwhile
+	if (m_writingProject) { return false; }
+
+	DataFile dataFile( DataFile::Type::SongProject );
+	saveProjectSnapshot(dataFile);
+
+	// an autosave might still be writing, don't let it overtake us
+	waitForBackgroundSave();
+
+	if( getGUI() == nullptr )
+	{
+		return dataFile.writeFile(filename, withResources);
+	}
+
+	// the worker must not read the configuration, so the file name and
+	// the bundle are set up here
+	const QString fullName = dataFile.fileNameToWrite(filename, withResources);
+	DataFile::WriteError error;
+	if (withResources && !dataFile.createBundle(fullName, error))
+	{
+		DataFile::showWriteError(error);
+		return false;
+	}
+
+	// Serializing, compressing and writing large projects takes a while,
+	// so do it on a worker thread and keep repainting the GUI meanwhile.
+	// User input is held back until we're done, the snapshot is owned
+	// by the worker until then.
+	const bool keepBackup = !ConfigManager::inst()->value("app", "disablebackup").toInt();
+	std::atomic<int> progress{0};
+	m_writingProject = true;
+	auto result = std::async(std::launch::async, [&]
+	{
+		return dataFile.writeFileSilently(fullName, keepBackup, error,
+			[&progress](int percent) { progress = percent; });
+	});
 
+	if (result.wait_for(50ms) != std::future_status::ready)
+	{
+		QProgressDialog progressDialog(tr("Saving project..."), QString(), 0, 100,
+			getGUI()->mainWindow());
+		progressDialog.setWindowModality(Qt::WindowModal);
+		progressDialog.setMinimumDuration(500);
+
+		QEventLoop loop;
+		QTimer timer;
+		connect(&timer, &QTimer::timeout, &loop, [&]
+		{
+			progressDialog.setValue(progress);
+			if (result.wait_for(0ms) == std::future_status::ready) { loop.quit(); }
+		});
+		timer.start(20);
+		loop.exec(QEventLoop::ExcludeUserInputEvents);
+	}
+
+	const bool written = result.get();
+	m_writingProject = false;
+	if (!written)
+	{
+		DataFile::showWriteError(error);
+		return false;
+	}
+	return true;
+}
+
+
+
+
+bool Song::saveProjectFileInBackground(const QString & filename)
+{
+	if (isSavingInBackground() || m_writingProject) { return false; }
+	waitForBackgroundSave();
+
+	// Serializing all tracks at once stalls the GUI with large projects,
+	// so the snapshot is built a track per event loop iteration. The worker
+	// only gets the finished DOM and the resolved file name, it neither
+	// shares anything with the models nor reads the configuration.
+	auto snapshot = std::make_unique<BackgroundSnapshot>();
+	snapshot->dataFile = std::make_shared<DataFile>(DataFile::Type::SongProject);
+	snapshot->fullName = snapshot->dataFile->fileNameToWrite(filename, false);
+	snapshot->keepBackup = !ConfigManager::inst()->value("app", "disablebackup").toInt();
+	snapshot->modifications = m_modifications;
+
+	DataFile& dataFile = *snapshot->dataFile;
+	m_savingProject = true;
+	saveSnapshotHead(dataFile);
+	snapshot->songElement = saveStateWithoutTracks(dataFile, dataFile.content());
+	m_savingProject = false;
+
+	m_backgroundSnapshot = std::move(snapshot);
+	QTimer::singleShot(0, this, &Song::continueBackgroundSnapshot);
+	return true;
+}
+
+
+
+
+void Song::continueBackgroundSnapshot()
+{
+	if (!m_backgroundSnapshot) { return; }
+
+	// tracks saved before and after a change might not fit together, the
+	// next autosave starts over
+	if (m_modifications != m_backgroundSnapshot->modifications || m_loadingProject)
+	{
+		m_backgroundSnapshot.reset();
+		return;
+	}
+
+	BackgroundSnapshot& snapshot = *m_backgroundSnapshot;
+	DataFile& dataFile = *snapshot.dataFile;
+	m_savingProject = true;
+	m_tracksMutex.lockForRead();
+	const bool tracksDone = snapshot.nextTrack >= tracks().size();
+	if (!tracksDone)
+	{
+		tracks()[snapshot.nextTrack++]->saveState(dataFile, snapshot.songElement);
+	}
+	m_tracksMutex.unlock();
+	if (tracksDone)
+	{
+		saveSnapshotTail(dataFile);
+	}
 	m_savingProject = false;
 
-	return dataFile.writeFile(filename, withResources);
+	if (!tracksDone)
+	{
+		QTimer::singleShot(0, this, &Song::continueBackgroundSnapshot);
+		return;
+	}
+
+	m_backgroundSave = std::async(std::launch::async,
+		[dataFile = snapshot.dataFile, fullName = snapshot.fullName, keepBackup = snapshot.keepBackup]
+	{
+		DataFile::WriteError error;
+		if (!dataFile->writeFileSilently(fullName, keepBackup, error))
+		{
+			qWarning() << "Saving" << fullName << "failed:" << error.message;
+			return false;
+		}
+		return true;
+	});
+	m_backgroundSnapshot.reset();
+}
+
+
+
+
+bool Song::isSavingInBackground() const
+{
+	using namespace std::chrono_literals;
+	return m_backgroundSnapshot != nullptr || m_backgroundSave.valid()
+		&& m_backgroundSave.wait_for(0ms) != std::future_status::ready;
+}
+
+
+
+
+void Song::waitForBackgroundSave()
+{
+	m_backgroundSnapshot.reset();
+	if (m_backgroundSave.valid()) { m_backgroundSave.get(); }
 }
 
 
@@ -0,0 +1,231 @@
+/*
+ * StartupCache.cpp - on-disk cache for data computed at start-up
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "StartupCache.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fftw3.h>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include "lmmsversion.h"
+
+namespace lmms
+{
+
+namespace
+{
+
+constexpr char Magic[8] = {'L', 'M', 'M', 'S', 'C', 'A', 'C', 'H'};
+constexpr quint32 FormatVersion = 1;
+
+struct Header
+{
+	char magic[8];
+	quint32 formatVersion;
+	quint32 keySize;
+	quint64 dataSize;
+};
+
+QByteArray fullKey(const QByteArray& key)
+{
+	// the files are neither portable between versions nor between builds
+	// of a different word size
+	return QByteArray(LMMS_VERSION) + '/' + QByteArray::number(int(sizeof(void*))) + '/' + key;
+}
+
+QString cacheFile(const QString& name)
+{
+	const QString dir = StartupCache::directory();
+	return dir.isEmpty() ? QString() : dir + name;
+}
+
+//! Returns the data of the file @p name if its key matches, the file stays
+//! mapped as long as @p file is open
+const uchar* mapCacheFile(QFile& file, const QByteArray& key, quint64& dataSize)
+{
+	if (file.fileName().isEmpty() || !file.open(QIODevice::ReadOnly)) { return nullptr; }
+
+	const QByteArray expectedKey = fullKey(key);
+	const qint64 size = file.size();
+	if (size < static_cast<qint64>(sizeof(Header) + expectedKey.size())) { return nullptr; }
+
+	const uchar* mapped = file.map(0, size);
+	if (mapped == nullptr) { return nullptr; }
+
+	Header header;
+	std::memcpy(&header, mapped, sizeof(header));
+	const uchar* keyData = mapped + sizeof(header);
+	if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0
+		|| header.formatVersion != FormatVersion
+		|| header.keySize != static_cast<quint32>(expectedKey.size())
+		|| std::memcmp(keyData, expectedKey.constData(), expectedKey.size()) != 0
+		|| header.dataSize != static_cast<quint64>(size - sizeof(header) - expectedKey.size()))
+	{
+		return nullptr;
+	}
+
+	dataSize = header.dataSize;
+	return keyData + expectedKey.size();
+}
+
+void writeCacheFile(const QString& name, const QByteArray& key, const void* data, std::size_t size)
+{
+	const QString fileName = cacheFile(name);
+	if (fileName.isEmpty()) { return; }
+
+	const QByteArray k = fullKey(key);
+	Header header;
+	std::memcpy(header.magic, Magic, sizeof(Magic));
+	header.formatVersion = FormatVersion;
+	header.keySize = k.size();
+	header.dataSize = size;
+
+	// write to a temporary file first, so that other instances never see
+	// a partially written file
+	QSaveFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly)) { return; }
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(k);
+	file.write(static_cast<const char*>(data), size);
+	file.commit();
+}
+
+} // namespace
+
+
+
+
+QString StartupCache::directory()
+{
+	static const QString dir = []
+	{
+		QString path = qEnvironmentVariable("LMMS_CACHE_DIR");
+		if (path == "none") { return QString(); }
+		if (path.isEmpty())
+		{
+			path = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/lmms";
+		}
+		return QDir().mkpath(path) ? QDir(path).absolutePath() + '/' : QString();
+	}();
+	return dir;
+}
+
+
+
+
+bool StartupCache::loadBlob(const QString& name, const QByteArray& key, void* data, std::size_t size)
+{
+	QFile file(cacheFile(name));
+	quint64 dataSize = 0;
+	const uchar* mapped = mapCacheFile(file, key, dataSize);
+	if (mapped == nullptr || dataSize != size) { return false; }
+
+	std::memcpy(data, mapped, size);
+	return true;
+}
+
+
+
+
+void StartupCache::storeBlob(const QString& name, const QByteArray& key, const void* data, std::size_t size)
+{
+	writeCacheFile(name, key, data, size);
+}
+
+
+
+
+StartupCache::Entries StartupCache::loadEntries(const QString& name, const QByteArray& key)
+{
+	QFile file(cacheFile(name));
+	quint64 dataSize = 0;
+	const uchar* mapped = mapCacheFile(file, key, dataSize);
+	if (mapped == nullptr) { return {}; }
+
+	Entries entries;
+	QDataStream in(QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), dataSize));
+	in >> entries;
+	return in.status() == QDataStream::Ok ? entries : Entries{};
+}
+
+
+
+
+void StartupCache::storeEntries(const QString& name, const QByteArray& key, const Entries& entries)
+{
+	QByteArray data;
+	QDataStream out(&data, QIODevice::WriteOnly);
+	out << entries;
+	writeCacheFile(name, key, data.constData(), data.size());
+}
+
+
+
+
+QByteArray StartupCache::fileStamp(const QString& path)
+{
+	const QFileInfo info(path);
+	return QByteArray::number(info.lastModified().toMSecsSinceEpoch())
+		+ ':' + QByteArray::number(info.size());
+}
+
+
+
+
+void StartupCache::importFftwWisdom()
+{
+	const QString fileName = cacheFile("fftw-wisdom");
+	if (!fileName.isEmpty())
+	{
+		fftwf_import_wisdom_from_filename(QFile::encodeName(fileName).constData());
+	}
+}
+
+
+
+
+void StartupCache::exportFftwWisdom()
+{
+	const QString fileName = cacheFile("fftw-wisdom");
+	if (fileName.isEmpty()) { return; }
+
+	char* wisdom = fftwf_export_wisdom_to_string();
+	if (wisdom == nullptr) { return; }
+
+	QSaveFile file(fileName);
+	if (file.open(QIODevice::WriteOnly))
+	{
+		file.write(wisdom);
+		file.commit();
+	}
+	std::free(wisdom);
+}
+
+
+} // namespace lmms
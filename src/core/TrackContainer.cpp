@@ -49,7 +49,8 @@ TrackContainer::TrackContainer() :
 	Model( nullptr ),
 	JournallingObject(),
 	m_tracksMutex(),
-	m_tracks()
+	m_tracks(),
+	m_saveTracks( true )
 {
 }
 
@@ -69,6 +70,11 @@ void TrackContainer::saveSettings( QDomDocument & _doc, QDomElement & _this )
 	_this.setTagName( classNodeName() );
 	_this.setAttribute( "type", nodeName() );
 
+	if( !m_saveTracks )
+	{
+		return;
+	}
+
 	// save settings of each track
 	m_tracksMutex.lockForRead();
 	for (const auto& track : m_tracks)
@@ -81,6 +87,17 @@ void TrackContainer::saveSettings( QDomDocument & _doc, QDomElement & _this )
 
 
 
+QDomElement TrackContainer::saveStateWithoutTracks( QDomDocument & doc, QDomElement & parent )
+{
+	m_saveTracks = false;
+	QDomElement element = saveState( doc, parent );
+	m_saveTracks = true;
+	return element;
+}
+
+
+
+
 void TrackContainer::loadSettings( const QDomElement & _this )
 {
 	bool journalRestore = _this.parentNode().nodeName() == "journaldata";
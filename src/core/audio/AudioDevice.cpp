@@ -182,6 +182,14 @@ void AudioDevice::renamePort( AudioPort * )
 
 
 
+bool AudioDevice::writePort( AudioPort *, const sampleFrame *, const fpp_t )
+{
+	return false;
+}
+
+
+
+
 fpp_t AudioDevice::resample( const surroundSampleFrame * _src,
 						const fpp_t _frames,
 						surroundSampleFrame * _dst,
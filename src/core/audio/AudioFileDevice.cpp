@@ -24,21 +24,56 @@
  */
 
 #include <QMessageBox>
+#include <QThread>
 
 #include "AudioFileDevice.h"
+#include "AudioEngine.h"
 #include "ExportProjectDialog.h"
 #include "GuiApplication.h"
 
 namespace lmms
 {
 
+namespace
+{
+
+//! Enough for more than a second of audio, so the render thread never has
+//! to wait for an encoder which is only briefly slower than the rendering
+constexpr std::size_t QueueFrames = 1 << 16;
+
+} // namespace
+
+
+class AudioFileDevice::EncoderThread : public QThread
+{
+public:
+	EncoderThread(AudioFileDevice* device) : m_device(device) {}
+
+private:
+	void run() override
+	{
+		m_device->runEncoder();
+	}
+
+	AudioFileDevice* m_device;
+};
+
+
+
+
 AudioFileDevice::AudioFileDevice( OutputSettings const & outputSettings,
 					const ch_cnt_t _channels,
 					const QString & _file,
 					AudioEngine*  _audioEngine ) :
 	AudioDevice( _channels, _audioEngine ),
 	m_outputFile( _file ),
-	m_outputSettings(outputSettings)
+	m_outputSettings(outputSettings),
+	m_queue(QueueFrames),
+	m_queueReader(m_queue),
+	m_finishing(false),
+	m_gainBuffer(audioEngine()->framesPerPeriod()),
+	m_audioHashing(false),
+	m_audioHash(QCryptographicHash::Sha256)
 {
 	using gui::ExportProjectDialog;
 
@@ -64,10 +99,16 @@ AudioFileDevice::AudioFileDevice( OutputSettings const & outputSettings,
 		}
 		else
 		{
+			// the device reports the failure through outputFileOpened(),
+			// a render server has to keep running
 			fprintf( stderr, "%s\n", message.toUtf8().constData() );
-			exit( EXIT_FAILURE );
 		}
 	}
+	else
+	{
+		m_encoderThread = std::make_unique<EncoderThread>(this);
+		m_encoderThread->start();
+	}
 }
 
 
@@ -75,12 +116,163 @@ AudioFileDevice::AudioFileDevice( OutputSettings const & outputSettings,
 
 AudioFileDevice::~AudioFileDevice()
 {
+	finishEncoderThread();
 	m_outputFile.close();
 }
 
 
 
 
+bool AudioFileDevice::addOutput(std::unique_ptr<AudioFileDevice> output)
+{
+	if (output->sampleRate() != sampleRate() || output->channels() != channels())
+	{
+		return false;
+	}
+	m_outputs.push_back(std::move(output));
+	return true;
+}
+
+
+
+
+QStringList AudioFileDevice::outputFiles() const
+{
+	QStringList files{outputFile()};
+	for (const auto& output : m_outputs)
+	{
+		files << output->outputFile();
+	}
+	return files;
+}
+
+
+
+
+void AudioFileDevice::writeBuffer(const surroundSampleFrame* buf, const fpp_t frames, const float masterGain)
+{
+	// resampling may return more frames than a period
+	if (m_gainBuffer.size() < static_cast<std::size_t>(frames)) { m_gainBuffer.resize(frames); }
+
+	for (fpp_t frame = 0; frame < frames; ++frame)
+	{
+		for (ch_cnt_t chnl = 0; chnl < SURROUND_CHANNELS; ++chnl)
+		{
+			m_gainBuffer[frame][chnl] = buf[frame][chnl] * masterGain;
+		}
+	}
+
+	queueFrames(m_gainBuffer.data(), frames);
+	for (const auto& output : m_outputs)
+	{
+		output->queueFrames(m_gainBuffer.data(), frames);
+	}
+}
+
+
+
+
+void AudioFileDevice::queueFrames(const surroundSampleFrame* frames, std::size_t count)
+{
+	if (!m_encoderThread) { return; }
+
+	std::size_t written = m_queue.write(frames, count, true);
+	if (written < count)
+	{
+		// the encoder fell behind by a whole queue, wait for it instead
+		// of dropping audio
+		auto lock = std::unique_lock{m_queueSpaceMutex};
+		while (written < count)
+		{
+			m_queueSpace.wait(lock, [this] { return m_queue.free() > 0; });
+			written += m_queue.write(frames + written, count - written, true);
+		}
+	}
+}
+
+
+
+
+void AudioFileDevice::runEncoder()
+{
+	auto& reader = m_queueReader;
+	std::vector<surroundSampleFrame> batch;
+	batch.reserve(EncoderBatchFrames);
+
+	while (true)
+	{
+		// must be read before the queue, so nothing queued before
+		// finishing is left behind
+		const bool finishing = m_finishing;
+
+		// encoders and files are much more efficient with large batches
+		// than with single periods
+		while (batch.size() < EncoderBatchFrames && !reader.empty())
+		{
+			auto frames = reader.read_max(EncoderBatchFrames - batch.size());
+			for (std::size_t i = 0; i < frames.size(); ++i)
+			{
+				batch.push_back(frames[i]);
+			}
+		}
+
+		{
+			// a writer waiting for space checks it under the mutex, so it
+			// can't miss this
+			const auto lock = std::lock_guard{m_queueSpaceMutex};
+		}
+		m_queueSpace.notify_all();
+
+		if (batch.size() == EncoderBatchFrames || (finishing && !batch.empty()))
+		{
+			if (m_audioHashing)
+			{
+				m_audioHash.addData(reinterpret_cast<const char*>(batch.data()),
+					static_cast<int>(batch.size() * sizeof(surroundSampleFrame)));
+			}
+			encodeBuffer(batch.data(), static_cast<fpp_t>(batch.size()));
+			batch.clear();
+		}
+		else if (finishing)
+		{
+			break;
+		}
+		else
+		{
+			reader.waitForData(10);
+		}
+	}
+}
+
+
+
+
+void AudioFileDevice::finishEncoding()
+{
+	finishEncoderThread();
+	for (const auto& output : m_outputs)
+	{
+		output->finishEncoderThread();
+	}
+}
+
+
+
+
+void AudioFileDevice::finishEncoderThread()
+{
+	if (m_encoderThread)
+	{
+		m_finishing = true;
+		m_queue.wakeAll();
+		m_encoderThread->wait();
+		m_encoderThread.reset();
+	}
+}
+
+
+
+
 int AudioFileDevice::writeData( const void* data, int len )
 {
 	if( m_outputFile.isOpen() )
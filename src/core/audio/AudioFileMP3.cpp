@@ -49,25 +49,24 @@ AudioFileMP3::AudioFileMP3(	OutputSettings const & outputSettings,
 
 AudioFileMP3::~AudioFileMP3()
 {
+	finishEncoderThread();
 	flushRemainingBuffers();
 	tearDownEncoder();
 }
 
-void AudioFileMP3::writeBuffer( const surroundSampleFrame * _buf,
-					const fpp_t _frames,
-					const float _master_gain )
+void AudioFileMP3::encodeBuffer( const surroundSampleFrame * _buf,
+					const fpp_t _frames )
 {
 	if (_frames < 1)
 	{
 		return;
 	}
 
-	// TODO Why isn't the gain applied by the driver but inside the device?
 	std::vector<float> interleavedDataBuffer(_frames * 2);
 	for (fpp_t i = 0; i < _frames; ++i)
 	{
-		interleavedDataBuffer[2*i] = _buf[i][0] * _master_gain;
-		interleavedDataBuffer[2*i + 1] = _buf[i][1] * _master_gain;
+		interleavedDataBuffer[2*i] = _buf[i][0];
+		interleavedDataBuffer[2*i + 1] = _buf[i][1];
 	}
 
 	size_t minimumBufferSize = 1.25 * _frames + 7200;
@@ -56,6 +56,7 @@ AudioFileOgg::AudioFileOgg(	OutputSettings const & outputSettings,
 
 AudioFileOgg::~AudioFileOgg()
 {
+	finishEncoderThread();
 	finishEncoding();
 }
 
@@ -188,9 +189,8 @@ bool AudioFileOgg::startEncoding()
 
 
 
-void AudioFileOgg::writeBuffer( const surroundSampleFrame * _ab,
-						const fpp_t _frames,
-						const float _master_gain )
+void AudioFileOgg::encodeBuffer( const surroundSampleFrame * _ab,
+						const fpp_t _frames )
 {
 	int eos = 0;
 
@@ -201,7 +201,7 @@ void AudioFileOgg::writeBuffer( const surroundSampleFrame * _ab,
 	{
 		for( ch_cnt_t chnl = 0; chnl < channels(); ++chnl )
 		{
-			buffer[chnl][frame] = _ab[frame][chnl] * _master_gain;
+			buffer[chnl][frame] = _ab[frame][chnl];
 		}
 	}
 
@@ -258,7 +258,7 @@ void AudioFileOgg::finishEncoding()
 	if( m_ok )
 	{
 		// just for flushing buffers...
-		writeBuffer( nullptr, 0, 0.0f );
+		encodeBuffer( nullptr, 0 );
 
 		// clean up
 		ogg_stream_clear( &m_os );
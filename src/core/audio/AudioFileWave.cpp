@@ -46,6 +46,7 @@ AudioFileWave::AudioFileWave( OutputSettings const & outputSettings,
 
 AudioFileWave::~AudioFileWave()
 {
+	finishEncoderThread();
 	finishEncoding();
 }
 
@@ -96,9 +97,8 @@ bool AudioFileWave::startEncoding()
 
 
 
-void AudioFileWave::writeBuffer( const surroundSampleFrame * _ab,
-						const fpp_t _frames,
-						const float _master_gain )
+void AudioFileWave::encodeBuffer( const surroundSampleFrame * _ab,
+						const fpp_t _frames )
 {
 	OutputSettings::BitDepth bitDepth = getOutputSettings().getBitDepth();
 
@@ -109,8 +109,7 @@ void AudioFileWave::writeBuffer( const surroundSampleFrame * _ab,
 		{
 			for( ch_cnt_t chnl = 0; chnl < channels(); ++chnl )
 			{
-				buf[frame*channels()+chnl] = _ab[frame][chnl] *
-								_master_gain;
+				buf[frame*channels()+chnl] = _ab[frame][chnl];
 			}
 		}
 		sf_writef_float( m_sf, buf, _frames );
@@ -119,7 +118,7 @@ void AudioFileWave::writeBuffer( const surroundSampleFrame * _ab,
 	else
 	{
 		auto buf = new int_sample_t[_frames * channels()];
-		convertToS16( _ab, _frames, _master_gain, buf,
+		convertToS16( _ab, _frames, 1.0f, buf,
 							!isLittleEndian() );
 
 		sf_writef_short( m_sf, buf, _frames );
@@ -26,11 +26,16 @@
 
 #ifdef LMMS_HAVE_JACK
 
+#include <algorithm>
+
+#include <QCheckBox>
 #include <QFormLayout>
 #include <QLineEdit>
 #include <QMessageBox>
+#include <QTimer>
 
 #include "AudioEngine.h"
+#include "AudioPort.h"
 #include "ConfigManager.h"
 #include "Engine.h"
 #include "GuiApplication.h"
@@ -60,6 +65,13 @@ AudioJack::AudioJack(bool& successful, AudioEngine* audioEngineParam)
 	, m_outBuf(new surroundSampleFrame[audioEngine()->framesPerPeriod()])
 	, m_framesDoneInCurBuf(0)
 	, m_framesToDoInCurBuf(0)
+	, m_portMap(new JackPortMap)
+	, m_cyclePortMap(nullptr)
+	, m_cycle(0)
+	, m_trackOutputs(ConfigManager::inst()->value("audiojack", "trackoutputs").toInt())
+	, m_directOut(m_trackOutputs && ConfigManager::inst()->value("audiojack", "directout").toInt())
+	, m_portsWritable(false)
+	, m_portsDirect(false)
 {
 	m_stopped = true;
 
@@ -75,19 +87,22 @@ AudioJack::AudioJack(bool& successful, AudioEngine* audioEngineParam)
 AudioJack::~AudioJack()
 {
 	AudioJack::stopProcessing();
-#ifdef AUDIO_PORT_SUPPORT
-	while (m_portMap.size())
+	while (!m_portMap.load()->isEmpty())
 	{
-		unregisterPort(m_portMap.begin().key());
+		unregisterPort(m_portMap.load()->firstKey());
 	}
-#endif
 
-	if (m_client != nullptr)
+	if (m_client != nullptr && m_active) { jack_deactivate(m_client); }
+
 	{
-		if (m_active) { jack_deactivate(m_client); }
-		jack_client_close(m_client);
+		// the process callback doesn't run anymore
+		const auto lock = std::lock_guard{m_portMapMutex};
+		reclaimPorts(true);
+		delete m_portMap.load();
 	}
 
+	if (m_client != nullptr) { jack_client_close(m_client); }
+
 	delete[] m_tempOutBufs;
 
 	delete[] m_outBuf;
@@ -250,19 +265,41 @@ void AudioJack::applyQualitySettings()
 
 void AudioJack::registerPort(AudioPort* port)
 {
-#ifdef AUDIO_PORT_SUPPORT
+	// only ports of tracks have an effect chain - the temporary ports of
+	// sample play handles may be created on the audio thread, where no
+	// JACK ports must be registered
+	if (!m_trackOutputs || m_client == nullptr || port->effects() == nullptr) { return; }
+
 	// make sure, port is not already registered
 	unregisterPort(port);
-	const QString name[2] = {port->name() + " L", port->name() + " R"};
 
+	const auto lock = std::lock_guard{m_portMapMutex};
+	auto stereoPort = new StereoPort;
+	stereoPort->name = uniquePortName(port);
+	const QString name[2] = {stereoPort->name + " L", stereoPort->name + " R"};
 	for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
 	{
-		m_portMap[port].ports[ch] = jack_port_register(
+		stereoPort->ports[ch] = jack_port_register(
 			m_client, name[ch].toLatin1().constData(), JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+		stereoPort->buffers[ch] = nullptr;
+		stereoPort->target[ch] = nullptr;
+		stereoPort->staging[ch].assign(audioEngine()->framesPerPeriod(), 0.f);
 	}
-#else
-	(void)port;
-#endif
+
+	// the process callback must never see a port JACK refused
+	if (stereoPort->ports[0] == nullptr || stereoPort->ports[1] == nullptr)
+	{
+		for (jack_port_t* jackPort : stereoPort->ports)
+		{
+			if (jackPort != nullptr) { jack_port_unregister(m_client, jackPort); }
+		}
+		delete stereoPort;
+		return;
+	}
+
+	auto map = new JackPortMap(*m_portMap.load());
+	map->insert(port, stereoPort);
+	publishPortMap(map, nullptr);
 }
 
 
@@ -270,38 +307,176 @@ void AudioJack::registerPort(AudioPort* port)
 
 void AudioJack::unregisterPort(AudioPort* port)
 {
-#ifdef AUDIO_PORT_SUPPORT
-	if (m_portMap.contains(port))
+	const auto lock = std::lock_guard{m_portMapMutex};
+	const JackPortMap* current = m_portMap.load();
+	const auto it = current->constFind(port);
+	if (it != current->constEnd())
 	{
-		for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
-		{
-			if (m_portMap[port].ports[ch] != nullptr) { jack_port_unregister(m_client, m_portMap[port].ports[ch]); }
-		}
-		m_portMap.erase(m_portMap.find(port));
+		StereoPort* removed = it.value();
+		auto map = new JackPortMap(*current);
+		map->remove(port);
+		publishPortMap(map, removed);
 	}
-#else
-	(void)port;
-#endif
 }
 
 void AudioJack::renamePort(AudioPort* port)
 {
-#ifdef AUDIO_PORT_SUPPORT
-	if (m_portMap.contains(port))
+	const auto lock = std::lock_guard{m_portMapMutex};
+	const JackPortMap* current = m_portMap.load();
+	const auto it = current->constFind(port);
+	if (it != current->constEnd())
 	{
-		const QString name[2] = {port->name() + " L", port->name() + " R"};
+		// the callback never reads the name, so it may change in place
+		it.value()->name = uniquePortName(port);
+		const QString name[2] = {it.value()->name + " L", it.value()->name + " R"};
 		for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
 		{
+			jack_port_t* jackPort = it.value()->ports[ch];
+			if (jackPort == nullptr) { continue; }
 #ifdef LMMS_HAVE_JACK_PRENAME
-			jack_port_rename(m_client, m_portMap[port].ports[ch], name[ch].toLatin1().constData());
+			jack_port_rename(m_client, jackPort, name[ch].toLatin1().constData());
 #else
-			jack_port_set_name(m_portMap[port].ports[ch], name[ch].toLatin1().constData());
+			jack_port_set_name(jackPort, name[ch].toLatin1().constData());
 #endif
 		}
 	}
-#else
-	(void)port;
-#endif // AUDIO_PORT_SUPPORT
+}
+
+
+
+
+QString AudioJack::uniquePortName(const AudioPort* port) const
+{
+	const JackPortMap* current = m_portMap.load();
+	const auto taken = [current, port](const QString& name)
+	{
+		for (auto it = current->constBegin(); it != current->constEnd(); ++it)
+		{
+			if (it.key() != port && it.value()->name == name) { return true; }
+		}
+		return false;
+	};
+
+	QString name = port->name();
+	for (int number = 2; taken(name); ++number)
+	{
+		name = QString("%1 (%2)").arg(port->name()).arg(number);
+	}
+	return name;
+}
+
+
+
+
+void AudioJack::publishPortMap(const JackPortMap* map, StereoPort* removedPort)
+{
+	const JackPortMap* old = m_portMap.exchange(map);
+
+	// a cycle starting after the exchange finds the new map, so only a
+	// cycle running right now might still use the old one
+	const std::uint64_t cycle = m_cycle.load();
+	m_retiredPorts.push_back(RetiredPorts{old, removedPort, cycle % 2 ? cycle + 1 : cycle});
+
+	reclaimPorts();
+	if (!m_retiredPorts.empty())
+	{
+		// don't leave the ports of a removed track around until the next change
+		QMetaObject::invokeMethod(this, "reclaimRetiredPorts", Qt::QueuedConnection);
+	}
+}
+
+
+
+
+void AudioJack::reclaimRetiredPorts()
+{
+	const auto lock = std::lock_guard{m_portMapMutex};
+	reclaimPorts();
+	if (!m_retiredPorts.empty())
+	{
+		// the running cycle ends within one JACK period
+		QTimer::singleShot(1, this, &AudioJack::reclaimRetiredPorts);
+	}
+}
+
+
+
+
+void AudioJack::reclaimPorts(bool all)
+{
+	const std::uint64_t cycle = m_cycle.load();
+
+	std::size_t kept = 0;
+	for (const RetiredPorts& retired : m_retiredPorts)
+	{
+		if (!all && retired.cycle > cycle)
+		{
+			// try again with the next change
+			m_retiredPorts[kept++] = retired;
+			continue;
+		}
+
+		delete retired.map;
+		if (retired.port != nullptr)
+		{
+			for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+			{
+				if (retired.port->ports[ch] != nullptr && m_client != nullptr)
+				{
+					jack_port_unregister(m_client, retired.port->ports[ch]);
+				}
+			}
+			delete retired.port;
+		}
+	}
+	m_retiredPorts.resize(kept);
+}
+
+
+
+
+bool AudioJack::writePort(AudioPort* port, const sampleFrame* buf, const fpp_t frames)
+{
+	// runs within processCallback(), which set m_cyclePortMap
+	if (!m_portsWritable) { return false; }
+
+	const auto it = m_cyclePortMap->constFind(port);
+	if (it == m_cyclePortMap->constEnd()) { return false; }
+
+	// the targets have been cleared, so there's nothing to do for silence
+	if (buf != nullptr)
+	{
+		for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+		{
+			jack_default_audio_sample_t* target = it.value()->target[ch];
+			for (fpp_t frame = 0; frame < frames; ++frame)
+			{
+				target[frame] = buf[frame][ch];
+			}
+		}
+	}
+
+	return m_directOut;
+}
+
+
+
+
+void AudioJack::preparePortPeriod(jack_nframes_t offset, jack_nframes_t nframes)
+{
+	const fpp_t frames = audioEngine()->framesPerPeriod();
+
+	// the ports are written while rendering, so without any further copy if
+	// the whole period fits into the remaining JACK buffers of this cycle
+	m_portsDirect = offset + frames <= nframes;
+	for (StereoPort* port : *m_cyclePortMap)
+	{
+		for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+		{
+			port->target[ch] = m_portsDirect ? port->buffers[ch] + offset : port->staging[ch].data();
+			std::fill_n(port->target[ch], frames, 0.f);
+		}
+	}
 }
 
 
@@ -309,6 +484,10 @@ void AudioJack::renamePort(AudioPort* port)
 
 int AudioJack::processCallback(jack_nframes_t nframes)
 {
+	// changing the ports never waits for us, it leaves the old map to us
+	// until the cycle ends
+	++m_cycle;
+	m_cyclePortMap = m_portMap.load();
 
 	// do midi processing first so that midi input can
 	// add to the following sound processing
@@ -323,22 +502,18 @@ int AudioJack::processCallback(jack_nframes_t nframes)
 		m_tempOutBufs[c] = (jack_default_audio_sample_t*)jack_port_get_buffer(m_outputPorts[c], nframes);
 	}
 
-#ifdef AUDIO_PORT_SUPPORT
-	const int frames = std::min<int>(nframes, audioEngine()->framesPerPeriod());
-	for (JackPortMap::iterator it = m_portMap.begin(); it != m_portMap.end(); ++it)
+	// the ports can only be fed by periods rendered within this callback
+	m_portsWritable = m_trackOutputs && !audioEngine()->hasFifoWriter()
+		&& audioEngine()->processingSampleRate() == sampleRate();
+	for (StereoPort* port : *m_cyclePortMap)
 	{
-		for (ch_cnt_t ch = 0; ch < channels(); ++ch)
+		for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
 		{
-			if (it.value().ports[ch] == nullptr) { continue; }
-			jack_default_audio_sample_t* buf
-				= (jack_default_audio_sample_t*)jack_port_get_buffer(it.value().ports[ch], nframes);
-			for (int frame = 0; frame < frames; ++frame)
-			{
-				buf[frame] = it.key()->buffer()[frame][ch];
-			}
+			if (port->ports[ch] == nullptr) { continue; }
+			port->buffers[ch] = (jack_default_audio_sample_t*)jack_port_get_buffer(port->ports[ch], nframes);
+			if (!m_portsWritable) { std::fill_n(port->buffers[ch], nframes, 0.f); }
 		}
 	}
-#endif
 
 	jack_nframes_t done = 0;
 	while (done < nframes && !m_stopped)
@@ -353,10 +528,21 @@ int AudioJack::processCallback(jack_nframes_t nframes)
 				o[done + frame] = m_outBuf[m_framesDoneInCurBuf + frame][c] * gain;
 			}
 		}
+		if (m_portsWritable && !m_portsDirect)
+		{
+			for (StereoPort* port : *m_cyclePortMap)
+			{
+				for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+				{
+					std::copy_n(port->staging[ch].data() + m_framesDoneInCurBuf, todo, port->buffers[ch] + done);
+				}
+			}
+		}
 		done += todo;
 		m_framesDoneInCurBuf += todo;
 		if (m_framesDoneInCurBuf == m_framesToDoInCurBuf)
 		{
+			if (m_portsWritable) { preparePortPeriod(done, nframes); }
 			m_framesToDoInCurBuf = getNextBuffer(m_outBuf);
 			m_framesDoneInCurBuf = 0;
 			if (!m_framesToDoInCurBuf)
@@ -374,8 +560,19 @@ int AudioJack::processCallback(jack_nframes_t nframes)
 			jack_default_audio_sample_t* b = m_tempOutBufs[c] + done;
 			memset(b, 0, sizeof(*b) * (nframes - done));
 		}
+		if (m_portsWritable)
+		{
+			for (StereoPort* port : *m_cyclePortMap)
+			{
+				for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+				{
+					std::fill(port->buffers[ch] + done, port->buffers[ch] + nframes, 0.f);
+				}
+			}
+		}
 	}
 
+	++m_cycle;
 	return 0;
 }
 
@@ -420,6 +617,16 @@ AudioJack::setupWidget::setupWidget(QWidget* parent)
 	m_channels->setModel(m);
 
 	form->addRow(tr("Channels"), m_channels);
+
+	m_trackOutputs = new QCheckBox(tr("Output every track at a port of its own"), this);
+	m_trackOutputs->setChecked(ConfigManager::inst()->value("audiojack", "trackoutputs").toInt());
+	form->addRow(tr("Track outputs"), m_trackOutputs);
+
+	m_directOut = new QCheckBox(tr("Don't mix tracks into the master output"), this);
+	m_directOut->setChecked(ConfigManager::inst()->value("audiojack", "directout").toInt());
+	m_directOut->setEnabled(m_trackOutputs->isChecked());
+	connect(m_trackOutputs, &QCheckBox::toggled, m_directOut, &QCheckBox::setEnabled);
+	form->addRow(tr("Direct outs"), m_directOut);
 }
 
 
@@ -437,6 +644,8 @@ void AudioJack::setupWidget::saveSettings()
 {
 	ConfigManager::inst()->setValue("audiojack", "clientname", m_clientName->text());
 	ConfigManager::inst()->setValue("audiojack", "channels", QString::number(m_channels->value<int>()));
+	ConfigManager::inst()->setValue("audiojack", "trackoutputs", QString::number(m_trackOutputs->isChecked()));
+	ConfigManager::inst()->setValue("audiojack", "directout", QString::number(m_directOut->isChecked()));
 }
 
 
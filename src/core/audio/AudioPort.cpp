@@ -30,6 +30,7 @@
 #include "Engine.h"
 #include "MixHelpers.h"
 #include "BufferManager.h"
+#include "lmms_math.h"
 
 namespace lmms
 {
@@ -38,14 +39,16 @@ AudioPort::AudioPort( const QString & _name, bool _has_effect_chain,
 		FloatModel * volumeModel, FloatModel * panningModel,
 		BoolModel * mutedModel ) :
 	m_bufferUsage( false ),
+	m_bufferSilent( false ),
 	m_portBuffer( BufferManager::acquire() ),
 	m_extOutputEnabled( false ),
 	m_nextMixerChannel( 0 ),
-	m_name( "unnamed port" ),
+	m_name( _name ),
 	m_effects( _has_effect_chain ? new EffectChain( nullptr ) : nullptr ),
 	m_volumeModel( volumeModel ),
 	m_panningModel( panningModel ),
-	m_mutedModel( mutedModel )
+	m_mutedModel( mutedModel ),
+	m_randState( 1 )
 {
 	Engine::audioEngine()->addAudioPort( this );
 	setExtOutputEnabled( true );
@@ -105,16 +108,20 @@ bool AudioPort::processEffects()
 
 void AudioPort::doProcessing()
 {
+	const fpp_t fpp = Engine::audioEngine()->framesPerPeriod();
+
+	// clear the buffer unless nothing has been written to it since the last time
+	if( !m_bufferSilent )
+	{
+		BufferManager::clear( m_portBuffer, fpp );
+		m_bufferSilent = true;
+	}
+
 	if( m_mutedModel && m_mutedModel->value() )
 	{
 		return;
 	}
 
-	const fpp_t fpp = Engine::audioEngine()->framesPerPeriod();
-
-	// clear the buffer
-	BufferManager::clear( m_portBuffer, fpp );
-
 	//qDebug( "Playhandles: %d", m_playHandles.size() );
 	for( PlayHandle * ph : m_playHandles ) // now we mix all playhandle buffers into the audioport buffer
 	{
@@ -220,9 +227,26 @@ void AudioPort::doProcessing()
 	// as of now there's no situation where we only have panning model but no volume model
 	// if we have neither, we don't have to do anything here - just pass the audio as is
 
-	// handle effects
-	const bool me = processEffects();
-	if( me || m_bufferUsage )
+	// handle effects - without input they only need to run while some of them
+	// are still producing a tail
+	if( m_bufferUsage || ( m_effects && m_effects->isRunning() ) )
+	{
+		const RandScope rand( this );
+		processEffects();
+		m_bufferSilent = false;
+	}
+
+	// hand the output over to the audio device (e.g. JACK track outputs),
+	// which might play it directly instead of the mixer
+	if( m_extOutputEnabled && Engine::audioEngine()->audioDev()->writePort(
+				this, m_bufferSilent ? nullptr : m_portBuffer, fpp ) )
+	{
+		m_bufferUsage = false;
+		return;
+	}
+
+	// also send the last period of a tail, where the effects have just stopped running
+	if( !m_bufferSilent )
 	{
 		Engine::mixer()->mixToChannel( m_portBuffer, m_nextMixerChannel ); 	// send output to mixer
 																			// TODO: improve the flow here - convert to pull model
@@ -250,4 +274,28 @@ void AudioPort::removePlayHandle( PlayHandle * handle )
 	m_playHandleLock.unlock();
 }
 
+
+AudioPort::RandScope::RandScope( AudioPort* port ) :
+	m_port( port != nullptr && Engine::audioEngine()->isDeterministic() ? port : nullptr )
+{
+	if( m_port )
+	{
+		std::swap( fastRandState(), m_port->m_randState );
+	}
+}
+
+
+
+
+AudioPort::RandScope::~RandScope()
+{
+	if( m_port )
+	{
+		std::swap( fastRandState(), m_port->m_randState );
+	}
+}
+
+
+
+
 } // namespace lmms
\ No newline at end of file
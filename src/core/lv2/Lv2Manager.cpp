@@ -32,8 +32,10 @@
 #include <lv2/lv2plug.in/ns/ext/buf-size/buf-size.h>
 #include <lv2/lv2plug.in/ns/ext/options/options.h>
 #include <lv2/lv2plug.in/ns/ext/worker/worker.h>
+#include <QDataStream>
 #include <QDebug>
 #include <QElapsedTimer>
+#include <QUrl>
 
 #include "AudioEngine.h"
 #include "Engine.h"
@@ -41,12 +43,37 @@
 #include "Lv2ControlBase.h"
 #include "Lv2Options.h"
 #include "PluginIssue.h"
+#include "StartupCache.h"
 
 
 namespace lmms
 {
 
 
+namespace
+{
+
+//! Returns a string which changes whenever one of the plugin's files changes
+QByteArray pluginStamp(const LilvPlugin* plugin)
+{
+	QByteArray stamp;
+	auto addFile = [&stamp](const LilvNode* uri)
+	{
+		if (uri && lilv_node_is_uri(uri))
+		{
+			stamp += StartupCache::fileStamp(QUrl(lilv_node_as_uri(uri)).toLocalFile()) + ';';
+		}
+	};
+	addFile(lilv_plugin_get_library_uri(plugin));
+	const LilvNodes* dataUris = lilv_plugin_get_data_uris(plugin);
+	LILV_FOREACH(nodes, itr, dataUris) { addFile(lilv_nodes_get(dataUris, itr)); }
+	return stamp;
+}
+
+} // namespace
+
+
+
 const std::set<std::string_view> Lv2Manager::pluginBlacklist =
 {
 	// github.com/calf-studio-gear/calf, #278
@@ -237,43 +264,71 @@ void Lv2Manager::initPlugins()
 	QElapsedTimer timer;
 	timer.start();
 
+	// checking the plugins is expensive, so the results are cached per
+	// plugin as long as none of its files change. The checks depend on the
+	// buffer size and whether the blacklist is used. In debug mode, all
+	// plugins are checked again to report their issues.
+	const QByteArray cacheKey = "lv2-1/"
+		+ QByteArray::number(Engine::audioEngine()->framesPerPeriod()) + '/'
+		+ QByteArray::number(int(Engine::ignorePluginBlacklist()));
+	const StartupCache::Entries cache = m_debug
+		? StartupCache::Entries{}
+		: StartupCache::loadEntries("lv2-plugins", cacheKey);
+	StartupCache::Entries newCache;
+
 	unsigned blacklisted = 0;
 	LILV_FOREACH(plugins, itr, plugins)
 	{
 		const LilvPlugin* curPlug = lilv_plugins_get(plugins, itr);
+		const char* pluginUri = lilv_node_as_uri(lilv_plugin_get_uri(curPlug));
+		const QByteArray stamp = pluginStamp(curPlug);
 
-		std::vector<PluginIssue> issues;
-		Plugin::Type type = Lv2ControlBase::check(curPlug, issues);
-		std::sort(issues.begin(), issues.end());
-		auto last = std::unique(issues.begin(), issues.end());
-		issues.erase(last, issues.end());
-		if (m_debug && issues.size())
-		{
-			qDebug() << "Lv2 plugin"
-				<< qStringFromPluginNode(curPlug, lilv_plugin_get_name)
-				<< "(URI:"
-				<< lilv_node_as_uri(lilv_plugin_get_uri(curPlug))
-				<< ") can not be loaded:";
-			for (const PluginIssue& iss : issues) { qDebug() << "  - " << iss; }
-		}
+		QByteArray stampCached;
+		qint32 typeCached = 0;
+		bool valid = false, isBlacklisted = false;
+		QDataStream in(cache.value(pluginUri));
+		in >> stampCached >> typeCached >> valid >> isBlacklisted;
 
-		Lv2Info info(curPlug, type, issues.empty());
-
-		m_lv2InfoMap[lilv_node_as_uri(lilv_plugin_get_uri(curPlug))]
-			= std::move(info);
-		if(issues.empty()) { ++pluginsLoaded; }
-		else
+		auto type = static_cast<Plugin::Type>(typeCached);
+		if (in.status() != QDataStream::Ok || stampCached != stamp)
 		{
-			if(std::any_of(issues.begin(), issues.end(),
-				[](const PluginIssue& iss) {
-				return iss.type() == PluginIssueType::Blacklisted; }))
+			std::vector<PluginIssue> issues;
+			type = Lv2ControlBase::check(curPlug, issues);
+			std::sort(issues.begin(), issues.end());
+			auto last = std::unique(issues.begin(), issues.end());
+			issues.erase(last, issues.end());
+			if (m_debug && issues.size())
 			{
-				++blacklisted;
+				qDebug() << "Lv2 plugin"
+					<< qStringFromPluginNode(curPlug, lilv_plugin_get_name)
+					<< "(URI:"
+					<< pluginUri
+					<< ") can not be loaded:";
+				for (const PluginIssue& iss : issues) { qDebug() << "  - " << iss; }
 			}
+
+			valid = issues.empty();
+			isBlacklisted = std::any_of(issues.begin(), issues.end(),
+				[](const PluginIssue& iss) {
+				return iss.type() == PluginIssueType::Blacklisted; });
 		}
+
+		QDataStream out(&newCache[pluginUri], QIODevice::WriteOnly);
+		out << stamp << static_cast<qint32>(type) << valid << isBlacklisted;
+
+		Lv2Info info(curPlug, type, valid);
+
+		m_lv2InfoMap[pluginUri] = std::move(info);
+		if(valid) { ++pluginsLoaded; }
+		else if(isBlacklisted) { ++blacklisted; }
 		++pluginCount;
 	}
 
+	if (newCache != cache)
+	{
+		StartupCache::storeEntries("lv2-plugins", cacheKey, newCache);
+	}
+
 	qDebug() << "Lv2 plugin SUMMARY:"
 		<< pluginsLoaded << "of" << pluginCount << " loaded in"
 		<< timer.elapsed() << "msecs.";
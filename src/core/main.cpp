@@ -70,6 +70,7 @@
 #include "OutputSettings.h"
 #include "ProjectRenderer.h"
 #include "RenderManager.h"
+#include "RenderServer.h"
 #include "Song.h"
 
 #ifdef LMMS_DEBUG_FPE
@@ -165,9 +166,16 @@ void printHelp()
 		"  compress <in>                         Compress file <in>\n"
 		"  render <project> [options...]         Render given project file\n"
 		"  rendertracks <project> [options...]   Render each track to a different file\n"
+		"  serve [options...]                    Render the jobs given as JSON lines on\n"
+		"                                        stdin, one after the other, without\n"
+		"                                        restarting. The render options are the\n"
+		"                                        defaults for the jobs, see RenderServer.h\n"
 		"  upgrade <in> [out]                    Upgrade file <in> and save as <out>\n"
 		"                                        Standard out is used if no output file\n"
 		"                                        is specified\n"
+		"  convert <in> <out>                    Convert project <in> to the format given\n"
+		"                                        by the extension of <out>, e.g. to the\n"
+		"                                        binary format (.mmpb) or back to XML\n"
 		"  makebundle <in> [out]                 Make a project bundle from the project\n"
 		"                                        file <in> saving the resulting bundle\n"
 		"                                        as <out>\n"
@@ -183,12 +191,16 @@ void printHelp()
 		"          geometry is <xsizexysize+xoffset+yoffsety>.\n"
 		"      --import <in> [-e]         Import MIDI or Hydrogen file <in>.\n"
 		"          If -e is specified lmms exits after importing the file.\n"
-		"\nOptions for \"render\" and \"rendertracks\":\n"
+		"\nOptions for \"render\", \"rendertracks\" and \"serve\":\n"
 		"  -a, --float                    Use 32bit float bit depth\n"
 		"  -b, --bitrate <bitrate>        Specify output bitrate in KBit/s\n"
 		"          Default: 160.\n"
+		"      --deterministic            Render the same project always into the\n"
+		"          same audio and print a hash of it for comparing renders\n"
 		"  -f, --format <format>         Specify format of render-output where\n"
 		"          Format is either 'wav', 'flac', 'ogg' or 'mp3'.\n"
+		"          Several formats separated by commas, e.g. 'wav,mp3',\n"
+		"          are all written in one pass.\n"
 		"  -i, --interpolation <method>   Specify interpolation method\n"
 		"          Possible values:\n"
 		"            - linear\n"
@@ -308,6 +320,8 @@ int main( int argc, char * * argv )
 	bool allowRoot = false;
 	bool renderLoop = false;
 	bool renderTracks = false;
+	bool serve = false;
+	bool renderDeterministic = false;
 	QString fileToLoad, fileToImport, renderOut, profilerOutputFile, configFile;
 
 	// first of two command-line parsing stages
@@ -326,6 +340,11 @@ int main( int argc, char * * argv )
 			coreOnly = true;
 			renderTracks = true;
 		}
+		else if( arg == "serve" || arg == "--serve" )
+		{
+			coreOnly = true;
+			serve = true;
+		}
 		else if( arg == "--allowroot" )
 		{
 			allowRoot = true;
@@ -366,6 +385,7 @@ int main( int argc, char * * argv )
 	AudioEngine::qualitySettings qs( AudioEngine::qualitySettings::Mode::HighQuality );
 	OutputSettings os( 44100, OutputSettings::BitRateSettings(160, false), OutputSettings::BitDepth::Depth16Bit, OutputSettings::StereoMode::JointStereo );
 	ProjectRenderer::ExportFileFormat eff = ProjectRenderer::ExportFileFormat::Wave;
+	std::vector<ProjectRenderer::ExportFileFormat> additionalFormats;
 
 	// second of two command-line parsing stages
 	for( int i = 1; i < argc; ++i )
@@ -407,6 +427,28 @@ int main( int argc, char * * argv )
 
 			return EXIT_SUCCESS;
 		}
+		else if( arg == "convert" || arg == "--convert" )
+		{
+			++i;
+
+			if( i == argc )
+			{
+				return noInputFileError();
+			}
+			if( i + 1 == argc )
+			{
+				return usageError( "No output file given" );
+			}
+
+			DataFile dataFile( QString::fromLocal8Bit( argv[i] ) );
+			if( dataFile.documentElement().isNull() )
+			{
+				return EXIT_FAILURE;
+			}
+
+			return dataFile.writeFile( QString::fromLocal8Bit( argv[i+1] ) )
+				? EXIT_SUCCESS : EXIT_FAILURE;
+		}
 		else if (arg == "makebundle")
 		{
 			++i;
@@ -487,6 +529,10 @@ int main( int argc, char * * argv )
 			fileToLoad = QString::fromLocal8Bit( argv[i] );
 			renderOut = fileToLoad;
 		}
+		else if( arg == "serve" || arg == "--serve" )
+		{
+			// Ignore, processed earlier
+		}
 		else if( arg == "--loop" || arg == "-l" )
 		{
 			renderLoop = true;
@@ -513,31 +559,45 @@ int main( int argc, char * * argv )
 			}
 
 
-			const QString ext = QString( argv[i] );
-
-			if( ext == "wav" )
+			additionalFormats.clear();
+			const QStringList exts = QString( argv[i] ).split( ',' );
+			for( int f = 0; f < exts.size(); ++f )
 			{
-				eff = ProjectRenderer::ExportFileFormat::Wave;
-			}
+				const QString & ext = exts[f];
+				ProjectRenderer::ExportFileFormat format;
+				if( ext == "wav" )
+				{
+					format = ProjectRenderer::ExportFileFormat::Wave;
+				}
 #ifdef LMMS_HAVE_OGGVORBIS
-			else if( ext == "ogg" )
-			{
-				eff = ProjectRenderer::ExportFileFormat::Ogg;
-			}
+				else if( ext == "ogg" )
+				{
+					format = ProjectRenderer::ExportFileFormat::Ogg;
+				}
 #endif
 #ifdef LMMS_HAVE_MP3LAME
-			else if( ext == "mp3" )
-			{
-				eff = ProjectRenderer::ExportFileFormat::MP3;
-			}
+				else if( ext == "mp3" )
+				{
+					format = ProjectRenderer::ExportFileFormat::MP3;
+				}
 #endif
-			else if (ext == "flac")
-			{
-				eff = ProjectRenderer::ExportFileFormat::Flac;
-			}
-			else
-			{
-				return usageError( QString( "Invalid output format %1" ).arg( argv[i] ) );
+				else if (ext == "flac")
+				{
+					format = ProjectRenderer::ExportFileFormat::Flac;
+				}
+				else
+				{
+					return usageError( QString( "Invalid output format %1" ).arg( ext ) );
+				}
+
+				if( f == 0 )
+				{
+					eff = format;
+				}
+				else
+				{
+					additionalFormats.push_back( format );
+				}
 			}
 		}
 		else if( arg == "--samplerate" || arg == "-s" )
@@ -611,6 +671,10 @@ int main( int argc, char * * argv )
 				return usageError( QString( "Invalid stereo mode %1" ).arg( argv[i] ) );
 			}
 		}
+		else if( arg == "--deterministic" )
+		{
+			renderDeterministic = true;
+		}
 		else if( arg =="--float" || arg == "-a" )
 		{
 			os.setBitDepth(OutputSettings::BitDepth::Depth32Bit);
@@ -802,9 +866,27 @@ int main( int argc, char * * argv )
 
 	bool destroyEngine = false;
 
+	// keep the engine running and render the jobs from stdin
+	if( serve )
+	{
+		Engine::init( true );
+		destroyEngine = true;
+
+		RenderServer::Defaults defaults;
+		defaults.formats.push_back( eff );
+		defaults.formats.insert( defaults.formats.end(),
+				additionalFormats.begin(), additionalFormats.end() );
+		defaults.loop = renderLoop;
+		defaults.deterministic = renderDeterministic;
+
+		auto server = new RenderServer( qs, os, defaults, app );
+		QCoreApplication::instance()->connect( server,
+				SIGNAL(finished()), SLOT(quit()));
+		QTimer::singleShot( 0, server, SLOT(run()) );
+	}
 	// if we have an output file for rendering, just render the song
 	// without starting the GUI
-	if( !renderOut.isEmpty() )
+	else if( !renderOut.isEmpty() )
 	{
 		Engine::init( true );
 		destroyEngine = true;
@@ -830,8 +912,37 @@ int main( int argc, char * * argv )
 
 		// create renderer
 		auto r = new RenderManager(qs, os, eff, renderOut);
-		QCoreApplication::instance()->connect( r,
-				SIGNAL(finished()), SLOT(quit()));
+		for( const auto format : additionalFormats )
+		{
+			r->addOutputFormat( format );
+		}
+		r->setDeterministic( renderDeterministic );
+		if( renderDeterministic )
+		{
+			QObject::connect( r, &RenderManager::finished, [r]
+			{
+				// the progress line doesn't end with a newline
+				printf( "\n" );
+				const auto& hashes = r->outputHashes();
+				for( auto it = hashes.begin(); it != hashes.end(); ++it )
+				{
+					printf( "Audio hash of %s: %s\n", qUtf8Printable( it.key() ),
+						it.value().constData() );
+				}
+			} );
+		}
+		QObject::connect( r, &RenderManager::finished, [r]
+		{
+			if( r->outputFiles().isEmpty() )
+			{
+				fprintf( stderr, "Nothing could be rendered\n" );
+				QCoreApplication::exit( EXIT_FAILURE );
+			}
+			else
+			{
+				QCoreApplication::quit();
+			}
+		} );
 
 		// timer for progress-updates
 		auto t = new QTimer(r);
@@ -112,7 +112,7 @@ MainWindow::MainWindow() :
 	sideBar->appendTab( new FileBrowser(
 				confMgr->userProjectsDir() + "*" +
 				confMgr->factoryProjectsDir(),
-					"*.mmp *.mmpz *.xml *.mid *.mpt",
+					"*.mmp *.mmpz *.mmpb *.xml *.mid *.mpt",
 							tr( "My Projects" ),
 					embed::getIconPixmap( "project_file" ).transformed( QTransform().rotate( 90 ) ),
 							splitter, false, true,
@@ -764,7 +764,7 @@ void MainWindow::openProject()
 {
 	if( mayChangeProject(false) )
 	{
-		FileDialog ofd( this, tr( "Open Project" ), "", tr( "LMMS (*.mmp *.mmpz)" ) );
+		FileDialog ofd( this, tr( "Open Project" ), "", tr( "LMMS (*.mmp *.mmpz *.mmpb)" ) );
 
 		ofd.setDirectory( ConfigManager::inst()->userProjectsDir() );
 		ofd.setFileMode( FileDialog::ExistingFiles );
@@ -809,6 +809,7 @@ bool MainWindow::saveProjectAs()
 	auto optionsWidget = new SaveOptionsWidget(Engine::getSong()->getSaveOptions());
 	VersionedSaveDialog sfd( this, optionsWidget, tr( "Save Project" ), "",
 			tr( "LMMS Project" ) + " (*.mmpz *.mmp);;" +
+				tr( "LMMS Binary Project" ) + " (*.mmpb);;" +
 				tr( "LMMS Project Template" ) + " (*.mpt)" );
 	QString f = Engine::getSong()->projectFileName();
 	if( f != "" )
@@ -845,6 +846,16 @@ bool MainWindow::saveProjectAs()
 				}
 			}
 		}
+		else if( sfd.selectedNameFilter().contains( "(*.mmpb)" ) &&
+				!sfd.selectedFiles()[0].endsWith( ".mmpb" ) )
+		{
+			fname.remove( "." + suffix );
+			if( VersionedSaveDialog::fileExistsQuery( fname + ".mmpb",
+					tr( "Save project" ) ) )
+			{
+				fname += ".mmpb";
+			}
+		}
 		if( this->guiSaveProjectAs( fname ) )
 		{
 			if( getSession() == SessionState::Recover )
@@ -1280,6 +1291,7 @@ void MainWindow::closeEvent( QCloseEvent * _ce )
 void MainWindow::sessionCleanup()
 {
 	// delete recover session files
+	Engine::getSong()->waitForBackgroundSave();
 	QFile::remove( ConfigManager::inst()->recoveryFile() );
 	setSession( SessionState::Normal );
 }
@@ -1393,15 +1405,25 @@ void MainWindow::browseHelp()
 
 void MainWindow::autoSave()
 {
-	if( !Engine::getSong()->isExporting() &&
+	const bool canSave = !Engine::getSong()->isExporting() &&
 		!Engine::getSong()->isLoadingProject() &&
 		!RemotePluginBase::isMainThreadWaiting() &&
 		!QApplication::mouseButtons() &&
 		( ConfigManager::inst()->value( "ui",
 				"enablerunningautosave" ).toInt() ||
-			! Engine::getSong()->isPlaying() ) )
+			! Engine::getSong()->isPlaying() );
+
+	bool saved = false;
+	if( canSave )
+	{
+		// built bit by bit and written on a worker thread, fails if the
+		// last autosave isn't done yet
+		saved = Engine::getSong()->saveProjectFileInBackground(
+			ConfigManager::inst()->recoveryFile() );
+	}
+
+	if( saved )
 	{
-		Engine::getSong()->saveProjectFile(ConfigManager::inst()->recoveryFile());
 		autoSaveTimerReset();  // Reset timer
 	}
 	else
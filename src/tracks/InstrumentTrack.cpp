@@ -59,6 +59,7 @@ InstrumentTrack::InstrumentTrack( TrackContainer* tc ) :
 	m_firstKeyModel(0, 0, NumKeys - 1, this, tr("First note")),
 	m_lastKeyModel(0, 0, NumKeys - 1, this, tr("Last note")),
 	m_hasAutoMidiDev( false ),
+	m_baseNoteVersion( 0 ),
 	m_volumeModel( DefaultVolume, MinVolume, MaxVolume, 0.1f, this, tr( "Volume" ) ),
 	m_panningModel( DefaultPanning, PanningLeft, PanningRight, 0.1f, this, tr( "Panning" ) ),
 	m_audioPort( tr( "unnamed_track" ), true, &m_volumeModel, &m_panningModel, &m_mutedModel ),
@@ -579,7 +580,9 @@ void InstrumentTrack::playNote( NotePlayHandle* n, sampleFrame* workingBuffer )
 	m_noteStacking.processNote( n );
 	m_arpeggio.processNote( n );
 
-	if( n->isMasterNote() == false && m_instrument != nullptr )
+	// voices of batched instruments are rendered afterwards by the
+	// instrument-play-handle, see InstrumentPlayHandle::playBatched()
+	if( n->isMasterNote() == false && m_instrument != nullptr && !n->isRenderedInBatch() )
 	{
 		// all is done, so now lets play the note!
 		m_instrument->playNote( n, workingBuffer );
@@ -635,12 +638,9 @@ void InstrumentTrack::setName( const QString & _new_name )
 
 void InstrumentTrack::updateBaseNote()
 {
-	Engine::audioEngine()->requestChangeInModel();
-	for (const auto& processHandle : m_processHandles)
-	{
-		processHandle->setFrequencyUpdate();
-	}
-	Engine::audioEngine()->doneChangeInModel();
+	// the notes check this when they are played, so neither the audio thread
+	// has to be locked out nor does a change refer to this track later on
+	m_baseNoteVersion.fetch_add(1, std::memory_order_release);
 }
 
 
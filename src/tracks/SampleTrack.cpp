@@ -70,6 +70,15 @@ SampleTrack::~SampleTrack()
 
 
 
+void SampleTrack::setName(const QString& name)
+{
+	Track::setName(name);
+	m_audioPort.setName(name);
+}
+
+
+
+
 bool SampleTrack::play( const TimePos & _start, const fpp_t _frames,
 					const f_cnt_t _offset, int _clip_num )
 {
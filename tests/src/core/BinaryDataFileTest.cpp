@@ -0,0 +1,129 @@
+/*
+ * BinaryDataFileTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include <QBuffer>
+#include <QDomDocument>
+
+#include "BinaryDataFile.h"
+
+class BinaryDataFileTest : QTestSuite
+{
+	Q_OBJECT
+private:
+	// attribute order isn't defined by the DOM, so compare node by node
+	static bool equal(const QDomNode& a, const QDomNode& b)
+	{
+		if (a.nodeType() != b.nodeType() || a.nodeName() != b.nodeName()
+			|| a.nodeValue() != b.nodeValue())
+		{
+			return false;
+		}
+
+		if (a.isElement())
+		{
+			const QDomNamedNodeMap attributes = a.attributes();
+			if (attributes.count() != b.attributes().count()) { return false; }
+			for (int i = 0; i < attributes.count(); ++i)
+			{
+				const QDomAttr attribute = attributes.item(i).toAttr();
+				if (b.toElement().attribute(attribute.name(), "<missing>") != attribute.value())
+				{
+					return false;
+				}
+			}
+		}
+
+		QDomNode childA = a.firstChild();
+		QDomNode childB = b.firstChild();
+		for (; !childA.isNull() && !childB.isNull(); childA = childA.nextSibling(), childB = childB.nextSibling())
+		{
+			if (!equal(childA, childB)) { return false; }
+		}
+		return childA.isNull() && childB.isNull();
+	}
+
+	static QByteArray toBinary(const QDomDocument& doc)
+	{
+		QBuffer buffer;
+		buffer.open(QIODevice::WriteOnly);
+		lmms::BinaryDataFile::write(doc, buffer);
+		return buffer.data();
+	}
+
+	static bool fromBinary(const QByteArray& data, QDomDocument& doc)
+	{
+		QBuffer buffer;
+		buffer.setData(data);
+		buffer.open(QIODevice::ReadOnly);
+		QString errorMsg;
+		return lmms::BinaryDataFile::read(buffer, doc, errorMsg);
+	}
+
+private slots:
+	void RoundTripTests()
+	{
+		QDomDocument doc("lmms-project");
+		doc.appendChild(doc.createProcessingInstruction("xml", "version=\"1.0\""));
+		QDomElement root = doc.createElement("lmms-project");
+		root.setAttribute("version", 30);
+		doc.appendChild(root);
+
+		QByteArray sample(64 * 1024, 0);
+		for (int i = 0; i < sample.size(); ++i) { sample[i] = static_cast<char>(i * 7); }
+
+		// enough nodes to be split into several chunks
+		for (int i = 0; i < 20000; ++i)
+		{
+			QDomElement note = doc.createElement("note");
+			note.setAttribute("pos", i * 48);
+			note.setAttribute("key", i % 128);
+			note.setAttribute("comment", QString("a long value äöü which isn't interned #%1").arg(i));
+			root.appendChild(note);
+		}
+		QDomElement clip = doc.createElement("sampleclip");
+		clip.setAttribute("data", QString::fromLatin1(sample.toBase64()));
+		clip.setAttribute("notbase64", QString(2000, '#'));
+		clip.appendChild(doc.createTextNode("some text"));
+		clip.appendChild(doc.createCDATASection("<cdata>"));
+		clip.appendChild(doc.createComment("a comment"));
+		root.appendChild(clip);
+
+		const QByteArray binary = toBinary(doc);
+		QVERIFY(lmms::BinaryDataFile::isBinary(binary));
+		// the sample must be stored raw instead of as base64
+		QVERIFY(binary.contains(sample));
+
+		QDomDocument loaded;
+		QVERIFY(fromBinary(binary, loaded));
+		QCOMPARE(loaded.doctype().name(), QString("lmms-project"));
+		QVERIFY(equal(doc, loaded));
+
+		// truncated files must be rejected
+		QDomDocument truncated;
+		QVERIFY(!fromBinary(binary.left(binary.size() / 2), truncated));
+		QVERIFY(!lmms::BinaryDataFile::isBinary(doc.toByteArray()));
+	}
+} BinaryDataFileTests;
+
+#include "BinaryDataFileTest.moc"
@@ -48,6 +48,19 @@ private slots:
 		QCOMPARE(numDigitsAsInt(900000000), 9);
 		QCOMPARE(numDigitsAsInt(-900000000), 10);
 	}
+
+	void FastDbfsConversionTest()
+	{
+		using namespace lmms;
+		for (float dbfs = -120.f; dbfs < 24.f; dbfs += 0.37f)
+		{
+			const float amp = dbfsToAmp(dbfs);
+			QVERIFY(std::abs(fastAmpToDbfs(amp) - ampToDbfs(amp)) < 1e-4f);
+			QVERIFY(std::abs(fastDbfsToAmp(dbfs) / amp - 1.f) < 1e-5f);
+		}
+		QCOMPARE(fastAmpToDbfs(1.f), 0.f);
+		QCOMPARE(fastDbfsToAmp(0.f), 1.f);
+	}
 } MathTests;
 
 #include "MathTest.moc"
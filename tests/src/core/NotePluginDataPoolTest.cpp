@@ -0,0 +1,96 @@
+/*
+ * NotePluginDataPoolTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "NotePluginDataPool.h"
+
+#include <vector>
+
+#include "QTestSuite.h"
+
+using lmms::NotePluginDataPool;
+
+struct Voice
+{
+	Voice(int* alive, int value) : alive{alive}, value{value} { ++*alive; }
+	~Voice() { --*alive; }
+	int* alive;
+	int value;
+};
+
+class NotePluginDataPoolTest : QTestSuite
+{
+	Q_OBJECT
+
+private slots:
+	void createDestroyTest()
+	{
+		auto alive = 0;
+		auto pool = NotePluginDataPool<Voice>{4};
+
+		Voice* voice = pool.create(&alive, 42);
+		QCOMPARE(voice->value, 42);
+		QCOMPARE(alive, 1);
+
+		pool.destroy(voice);
+		QCOMPARE(alive, 0);
+
+		// destroying nothing is fine, like deleting a nullptr
+		pool.destroy(nullptr);
+	}
+
+	void overCapacityTest()
+	{
+		// the capacity is rounded up, so use far more voices than requested
+		auto alive = 0;
+		auto pool = NotePluginDataPool<Voice>{1};
+		auto voices = std::vector<Voice*>{};
+		for (auto i = 0; i < 100; ++i)
+		{
+			voices.push_back(pool.create(&alive, i));
+		}
+		QCOMPARE(alive, 100);
+		for (auto i = 0; i < 100; ++i)
+		{
+			QCOMPARE(voices[i]->value, i);
+		}
+
+		for (Voice* voice : voices)
+		{
+			pool.destroy(voice);
+		}
+		QCOMPARE(alive, 0);
+	}
+
+	void reuseTest()
+	{
+		auto alive = 0;
+		auto pool = NotePluginDataPool<Voice>{1};
+		Voice* first = pool.create(&alive, 1);
+		pool.destroy(first);
+		Voice* second = pool.create(&alive, 2);
+		QCOMPARE(second, first);
+		pool.destroy(second);
+		QCOMPARE(alive, 0);
+	}
+} NotePluginDataPoolTests;
+
+#include "NotePluginDataPoolTest.moc"